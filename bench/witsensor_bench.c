@@ -0,0 +1,458 @@
+/* witsensor_bench.c
+ * Microbenchmarks of the BLE-thread paths, standalone (no Pd, no BLE)
+ *
+ * Usage: witsensor_bench [frames] [repeats]
+ * Every benchmark runs 'repeats' times over 'frames' synthetic frames and
+ * reports the fastest run. Output is tab-separated with a header row:
+ *   benchmark  variant  frames  ns_per_frame  frames_per_s
+ *
+ * stream_decode    0x61 decode one frame at a time, per output mode
+ * stream_batch     0x61 batch kernels, WITSENSOR_DECODE_BATCH frames per call,
+ *                  scalar and SIMD (variant modeN_<isa>)
+ * stream_path      notification -> parser -> batch decode -> ring -> pop,
+ *                  as witsensor_ble_data_callback does it, per output mode
+ * stream_path_mtu  the same with BENCH_MTU_FRAMES frames per notification
+ * ahrs             host fusion step per frame, Madgwick and Mahony, without
+ *                  and with a magnetometer reading
+ * register_decode  0x71 decode over every row of witsensor_registers
+ * register_path    notification -> parser -> decode -> register ring -> pop
+ * dispatch         handing decoded frames to another thread: the frame ring
+ *                  against a malloc per frame plus a locked list (what a
+ *                  pd_queue_mess per frame costs), on one thread (st) and
+ *                  across two (mt)
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "witsensor_parser.h"
+#include "witsensor_decode.h"
+#include "witsensor_ring.h"
+#include "witsensor_snapshot.h"
+#include "witsensor_ahrs.h"
+#include "witsensor_platform.h"
+
+#define BENCH_PATTERNS 64      // distinct synthetic frames cycled through
+#define BENCH_DEFAULT_FRAMES 2000000
+#define BENCH_DEFAULT_REPEATS 5
+#define BENCH_MTU_FRAMES 12    // frames in a 247-byte MTU notification
+
+static unsigned long bench_frames = BENCH_DEFAULT_FRAMES;
+static int bench_repeats = BENCH_DEFAULT_REPEATS;
+static volatile float bench_sink; // keeps results alive
+
+static unsigned char stream_frames[BENCH_PATTERNS][WITSENSOR_FRAME_SIZE];
+static unsigned char register_frames[BENCH_PATTERNS][WITSENSOR_FRAME_SIZE];
+
+// Deterministic pseudo-random bytes (xorshift32)
+static uint32_t bench_rand_state = 0x12345678u;
+static uint32_t bench_rand(void) {
+    uint32_t v = bench_rand_state;
+    v ^= v << 13;
+    v ^= v >> 17;
+    v ^= v << 5;
+    return bench_rand_state = v;
+}
+
+static void bench_make_frames(void) {
+    for (int i = 0; i < BENCH_PATTERNS; i++) {
+        unsigned char *s = stream_frames[i];
+        s[0] = WITSENSOR_FRAME_HEADER;
+        s[1] = WITSENSOR_FRAME_STREAM;
+        for (int b = 2; b < WITSENSOR_FRAME_SIZE; b++) s[b] = (unsigned char)bench_rand();
+
+        const witsensor_register_desc_t *desc = &witsensor_registers[i % witsensor_register_count];
+        unsigned char *r = register_frames[i];
+        r[0] = WITSENSOR_FRAME_HEADER;
+        r[1] = WITSENSOR_FRAME_REGISTER;
+        r[2] = desc->addr;
+        r[3] = 0x00;
+        for (int b = 4; b < WITSENSOR_FRAME_SIZE; b++) r[b] = (unsigned char)bench_rand();
+        // Plausible battery voltage so the charge curve is walked
+        if (desc->flags & WITSENSOR_REGISTER_BATTERY) { r[4] = (unsigned char)(340 + i); r[5] = 0x01; }
+    }
+}
+
+static void bench_report(const char *name, const char *variant, uint64_t best_ns) {
+    double ns = (double)best_ns / (double)bench_frames;
+    printf("%s\t%s\t%lu\t%.2f\t%.0f\n", name, variant, bench_frames, ns, ns > 0 ? 1e9 / ns : 0.0);
+    fflush(stdout);
+}
+
+// Best of bench_repeats runs of fn(arg); fn returns its own elapsed ns
+static uint64_t bench_best(uint64_t (*fn)(void *), void *arg) {
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < bench_repeats; r++) {
+        uint64_t ns = fn(arg);
+        if (ns < best) best = ns;
+    }
+    return best;
+}
+
+// --- Streaming frames ---
+
+static uint64_t bench_stream_decode(void *arg) {
+    unsigned char flags = witsensor_decode_flags(*(int *)arg);
+    witsensor_frame_t f;
+    float acc = 0.0f;
+    uint64_t start = witsensor_now_ns();
+    for (unsigned long i = 0; i < bench_frames; i++) {
+        witsensor_decode_stream(stream_frames[i % BENCH_PATTERNS], flags, &f);
+        acc += f.v[0] + f.v[8] + (float)f.timestamp;
+    }
+    uint64_t ns = witsensor_now_ns() - start;
+    bench_sink = acc;
+    return ns;
+}
+
+typedef struct bench_batch_t {
+    int mode;
+    int simd;
+} bench_batch_t;
+
+static uint64_t bench_stream_batch(void *arg) {
+    const bench_batch_t *b = (const bench_batch_t *)arg;
+    witsensor_decode_fn decode = witsensor_decode_kernel(b->mode, b->simd);
+    witsensor_frame_t f[WITSENSOR_DECODE_BATCH];
+    float acc = 0.0f;
+    unsigned long i = 0;
+    uint64_t start = witsensor_now_ns();
+    while (i < bench_frames) {
+        unsigned long offset = i % BENCH_PATTERNS;
+        unsigned long count = BENCH_PATTERNS - offset;
+        if (count > WITSENSOR_DECODE_BATCH) count = WITSENSOR_DECODE_BATCH;
+        if (count > bench_frames - i) count = bench_frames - i;
+        decode(stream_frames + offset, (int)count, f);
+        acc += f[0].v[0] + f[count - 1].v[8] + (float)f[0].timestamp;
+        i += count;
+    }
+    uint64_t ns = witsensor_now_ns() - start;
+    bench_sink = acc;
+    return ns;
+}
+
+// Producer state shaped like the BLE-thread fields of t_witsensor_device
+typedef struct bench_device_t {
+    witsensor_parser_t parser;
+    uint64_t rx_ns;
+    uint32_t frame_seq;
+    witsensor_decode_fn decode;
+    unsigned char batch[WITSENSOR_DECODE_BATCH][WITSENSOR_FRAME_SIZE];
+    int batch_count;
+    witsensor_snapshot_t snapshot;
+    witsensor_ring_t frames;
+    witsensor_register_ring_t registers;
+} bench_device_t;
+
+static bench_device_t bench_dev;
+
+static void bench_stream_flush(bench_device_t *dev) {
+    int count = dev->batch_count;
+    witsensor_frame_t f[WITSENSOR_DECODE_BATCH];
+    dev->batch_count = 0;
+    dev->decode((const unsigned char (*)[WITSENSOR_FRAME_SIZE])dev->batch, count, f);
+    uint64_t decode_ns = witsensor_now_ns();
+    for (int i = 0; i < count; i++) {
+        f[i].seq = dev->frame_seq++;
+        f[i].rx_ns = dev->rx_ns;
+        f[i].decode_ns = decode_ns;
+        witsensor_ring_push(&dev->frames, &f[i]);
+    }
+    witsensor_snapshot_store_frame(&dev->snapshot, &f[count - 1]);
+}
+
+static void bench_stream_frame(void *user_data, const unsigned char *frame) {
+    bench_device_t *dev = (bench_device_t *)user_data;
+    if (frame[1] == WITSENSOR_FRAME_REGISTER) {
+        witsensor_register_t regs[WITSENSOR_REGISTER_MAX_WORDS];
+        int n = witsensor_register_decode(frame, regs, WITSENSOR_REGISTER_MAX_WORDS);
+        for (int i = 0; i < n; i++) witsensor_register_ring_push(&dev->registers, &regs[i]);
+        return;
+    }
+    memcpy(dev->batch[dev->batch_count++], frame, WITSENSOR_FRAME_SIZE);
+    if (dev->batch_count == WITSENSOR_DECODE_BATCH) bench_stream_flush(dev);
+}
+
+static void bench_device_init(bench_device_t *dev, int output_mode) {
+    witsensor_parser_init(&dev->parser);
+    dev->rx_ns = 0;
+    dev->frame_seq = 0;
+    dev->decode = witsensor_decode_kernel(output_mode, 1);
+    dev->batch_count = 0;
+    witsensor_snapshot_init(&dev->snapshot);
+    witsensor_ring_init(&dev->frames, WITSENSOR_DROP_OLDEST);
+    witsensor_register_ring_init(&dev->registers);
+}
+
+// Notifications of per_notification frames, drained after each notification
+// as the Pd-side drain would
+static uint64_t bench_path(unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int output_mode, int per_notification) {
+    bench_device_t *dev = &bench_dev;
+    bench_device_init(dev, output_mode);
+    witsensor_frame_t f;
+    witsensor_register_t reg;
+    float acc = 0.0f;
+    uint64_t start = witsensor_now_ns();
+    unsigned long i = 0;
+    while (i < bench_frames) {
+        unsigned long offset = i % BENCH_PATTERNS;
+        unsigned long count = BENCH_PATTERNS - offset;
+        if (count > (unsigned long)per_notification) count = (unsigned long)per_notification;
+        if (count > bench_frames - i) count = bench_frames - i;
+        i += count;
+        dev->rx_ns = witsensor_now_ns();
+        witsensor_parser_feed(&dev->parser, frames[offset], (int)count * WITSENSOR_FRAME_SIZE,
+                              bench_stream_frame, dev);
+        if (dev->batch_count) bench_stream_flush(dev);
+        while (witsensor_ring_pop(&dev->frames, &f)) acc += f.v[0];
+        while (witsensor_register_ring_pop(&dev->registers, &reg)) acc += reg.v[0];
+    }
+    uint64_t ns = witsensor_now_ns() - start;
+    bench_sink = acc;
+    return ns;
+}
+
+// One frame per notification, the sensor's default
+static uint64_t bench_stream_path(void *arg) {
+    return bench_path(stream_frames, *(int *)arg, 1);
+}
+
+// Frames packed into a 247-byte MTU, as in bursts and replays
+static uint64_t bench_stream_path_mtu(void *arg) {
+    return bench_path(stream_frames, *(int *)arg, BENCH_MTU_FRAMES);
+}
+
+typedef struct bench_ahrs_t {
+    witsensor_ahrs_algorithm_t algorithm;
+    int mag;
+} bench_ahrs_t;
+
+static uint64_t bench_ahrs(void *arg) {
+    const bench_ahrs_t *b = (const bench_ahrs_t *)arg;
+    witsensor_frame_t f[BENCH_PATTERNS];
+    witsensor_decode_kernel(0, 0)((const unsigned char (*)[WITSENSOR_FRAME_SIZE])stream_frames, BENCH_PATTERNS, f);
+    witsensor_ahrs_t ahrs;
+    witsensor_ahrs_init(&ahrs, b->algorithm, 0, 0);
+    const float mag[3] = { 0.3f, 0.1f, -0.5f };
+    float q[4], acc = 0.0f;
+    uint64_t start = witsensor_now_ns();
+    for (unsigned long i = 0; i < bench_frames; i++) {
+        if (b->mag) witsensor_ahrs_set_mag(&ahrs, mag, start);
+        const witsensor_frame_t *fr = &f[i % BENCH_PATTERNS];
+        witsensor_ahrs_update(&ahrs, fr->v + 3, fr->v, 0.005f, start, q);
+        acc += q[0];
+    }
+    uint64_t ns = witsensor_now_ns() - start;
+    bench_sink = acc;
+    return ns;
+}
+
+// --- Register responses ---
+
+static uint64_t bench_register_decode(void *arg) {
+    (void)arg;
+    witsensor_register_t regs[WITSENSOR_REGISTER_MAX_WORDS];
+    float acc = 0.0f;
+    uint64_t start = witsensor_now_ns();
+    for (unsigned long i = 0; i < bench_frames; i++) {
+        if (witsensor_register_decode(register_frames[i % BENCH_PATTERNS], regs, WITSENSOR_REGISTER_MAX_WORDS)) acc += regs[0].v[0];
+    }
+    uint64_t ns = witsensor_now_ns() - start;
+    bench_sink = acc;
+    return ns;
+}
+
+static uint64_t bench_register_path(void *arg) {
+    (void)arg;
+    return bench_path(register_frames, 0, 1);
+}
+
+// --- Dispatch to the consumer thread ---
+
+// Baseline: every frame copied into its own allocation and appended to a
+// mutex-protected list, the way a pd_queue_mess per frame hands it over
+typedef struct bench_node_t {
+    struct bench_node_t *next;
+    witsensor_frame_t frame;
+} bench_node_t;
+
+typedef struct bench_list_t {
+    witsensor_mutex_t lock;
+    bench_node_t *head;
+    bench_node_t *tail;
+    _Atomic unsigned int depth; // queued frames, bounded like the ring in the mt run
+} bench_list_t;
+
+static int bench_list_push(bench_list_t *list, const witsensor_frame_t *frame) {
+    bench_node_t *node = (bench_node_t *)malloc(sizeof(*node));
+    if (!node) return 0;
+    node->next = NULL;
+    node->frame = *frame;
+    witsensor_mutex_lock(&list->lock);
+    if (list->tail) list->tail->next = node; else list->head = node;
+    list->tail = node;
+    witsensor_mutex_unlock(&list->lock);
+    atomic_fetch_add_explicit(&list->depth, 1, memory_order_relaxed);
+    return 1;
+}
+
+// Take every queued frame; returns how many there were
+static unsigned long bench_list_drain(bench_list_t *list, float *acc) {
+    witsensor_mutex_lock(&list->lock);
+    bench_node_t *node = list->head;
+    list->head = list->tail = NULL;
+    witsensor_mutex_unlock(&list->lock);
+    unsigned long n = 0;
+    while (node) {
+        bench_node_t *next = node->next;
+        *acc += node->frame.v[0];
+        free(node);
+        node = next;
+        n++;
+    }
+    atomic_fetch_sub_explicit(&list->depth, (unsigned int)n, memory_order_relaxed);
+    return n;
+}
+
+typedef struct bench_dispatch_t {
+    int use_ring;
+    witsensor_ring_t ring;
+    bench_list_t list;
+    witsensor_frame_t frames[BENCH_PATTERNS];
+    _Atomic int go;
+    uint64_t end_ns;    // consumer saw the last frame
+    float acc;
+} bench_dispatch_t;
+
+static bench_dispatch_t bench_disp = { .list = { .lock = WITSENSOR_MUTEX_INIT } };
+
+static void bench_dispatch_setup(bench_dispatch_t *d, int use_ring) {
+    d->use_ring = use_ring;
+    witsensor_ring_init(&d->ring, WITSENSOR_DROP_NEWEST);
+    d->list.head = d->list.tail = NULL;
+    atomic_store(&d->list.depth, 0);
+    for (int i = 0; i < BENCH_PATTERNS; i++) {
+        witsensor_decode_stream(stream_frames[i], 0, &d->frames[i]);
+        d->frames[i].seq = (uint32_t)i;
+    }
+    atomic_store(&d->go, 0);
+    d->acc = 0.0f;
+}
+
+// Same thread: queue one frame and take it straight back (pure handover cost)
+static uint64_t bench_dispatch_st(void *arg) {
+    bench_dispatch_t *d = &bench_disp;
+    bench_dispatch_setup(d, *(int *)arg);
+    witsensor_frame_t f;
+    uint64_t start = witsensor_now_ns();
+    for (unsigned long i = 0; i < bench_frames; i++) {
+        const witsensor_frame_t *src = &d->frames[i % BENCH_PATTERNS];
+        if (d->use_ring) {
+            witsensor_ring_push(&d->ring, src);
+            if (witsensor_ring_pop(&d->ring, &f)) d->acc += f.v[0];
+        } else {
+            bench_list_push(&d->list, src);
+            bench_list_drain(&d->list, &d->acc);
+        }
+    }
+    uint64_t ns = witsensor_now_ns() - start;
+    bench_sink = d->acc;
+    return ns;
+}
+
+static void bench_consumer(void *arg) {
+    bench_dispatch_t *d = (bench_dispatch_t *)arg;
+    witsensor_frame_t f;
+    unsigned long received = 0;
+    atomic_store(&d->go, 1);
+    while (received < bench_frames) {
+        if (d->use_ring) {
+            unsigned long n = 0;
+            while (witsensor_ring_pop(&d->ring, &f)) { d->acc += f.v[0]; n++; }
+            received += n;
+            if (!n) witsensor_yield();
+        } else {
+            unsigned long n = bench_list_drain(&d->list, &d->acc);
+            received += n;
+            if (!n) witsensor_yield();
+        }
+    }
+    d->end_ns = witsensor_now_ns();
+}
+
+// Two threads: producer queues every frame, waiting while WITSENSOR_RING_CAPACITY
+// frames are pending; the consumer polls until it has them all
+static uint64_t bench_dispatch_mt(void *arg) {
+    bench_dispatch_t *d = &bench_disp;
+    bench_dispatch_setup(d, *(int *)arg);
+    witsensor_thread_t consumer;
+    if (!witsensor_thread_start(&consumer, bench_consumer, d)) {
+        fprintf(stderr, "witsensor_bench: cannot start consumer thread\n");
+        exit(1);
+    }
+    while (!atomic_load(&d->go)) witsensor_yield();
+    uint64_t start = witsensor_now_ns();
+    for (unsigned long i = 0; i < bench_frames; i++) {
+        const witsensor_frame_t *src = &d->frames[i % BENCH_PATTERNS];
+        if (d->use_ring) {
+            while (!witsensor_ring_push(&d->ring, src)) witsensor_yield();
+        } else {
+            while (atomic_load_explicit(&d->list.depth, memory_order_relaxed) >= WITSENSOR_RING_CAPACITY) witsensor_yield();
+            bench_list_push(&d->list, src);
+        }
+    }
+    witsensor_thread_join(consumer);
+    bench_sink = d->acc;
+    return d->end_ns - start;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) bench_frames = strtoul(argv[1], NULL, 10);
+    if (argc > 2) bench_repeats = atoi(argv[2]);
+    if (bench_frames < 1) bench_frames = BENCH_DEFAULT_FRAMES;
+    if (bench_repeats < 1) bench_repeats = BENCH_DEFAULT_REPEATS;
+
+    witsensor_register_init();
+    bench_make_frames();
+
+    printf("benchmark\tvariant\tframes\tns_per_frame\tframes_per_s\n");
+    static const char *modes[] = { "mode0", "mode1", "mode2", "mode3" };
+    for (int mode = 0; mode < 4; mode++) {
+        bench_report("stream_decode", modes[mode], bench_best(bench_stream_decode, &mode));
+    }
+    for (int mode = 0; mode < 4; mode++) {
+        char variant[32];
+        bench_batch_t scalar = { mode, 0 }, simd = { mode, 1 };
+        snprintf(variant, sizeof(variant), "%s_scalar", modes[mode]);
+        bench_report("stream_batch", variant, bench_best(bench_stream_batch, &scalar));
+        if (strcmp(witsensor_decode_simd_name(), "scalar") == 0) continue;
+        snprintf(variant, sizeof(variant), "%s_%s", modes[mode], witsensor_decode_simd_name());
+        bench_report("stream_batch", variant, bench_best(bench_stream_batch, &simd));
+    }
+    for (int mode = 0; mode < 4; mode++) {
+        bench_report("stream_path", modes[mode], bench_best(bench_stream_path, &mode));
+    }
+    for (int mode = 0; mode < 4; mode++) {
+        bench_report("stream_path_mtu", modes[mode], bench_best(bench_stream_path_mtu, &mode));
+    }
+    static const bench_ahrs_t ahrs[] = {
+        { WITSENSOR_AHRS_MADGWICK, 0 }, { WITSENSOR_AHRS_MADGWICK, 1 },
+        { WITSENSOR_AHRS_MAHONY, 0 }, { WITSENSOR_AHRS_MAHONY, 1 },
+    };
+    static const char *ahrs_names[] = { "madgwick", "madgwick_mag", "mahony", "mahony_mag" };
+    for (int a = 0; a < 4; a++) {
+        bench_report("ahrs", ahrs_names[a], bench_best(bench_ahrs, (void *)&ahrs[a]));
+    }
+    bench_report("register_decode", "table", bench_best(bench_register_decode, NULL));
+    bench_report("register_path", "table", bench_best(bench_register_path, NULL));
+    int ring = 1, list = 0;
+    bench_report("dispatch_st", "ring", bench_best(bench_dispatch_st, &ring));
+    bench_report("dispatch_st", "malloc_lock", bench_best(bench_dispatch_st, &list));
+    bench_report("dispatch_mt", "ring", bench_best(bench_dispatch_mt, &ring));
+    bench_report("dispatch_mt", "malloc_lock", bench_best(bench_dispatch_mt, &list));
+    return 0;
+}
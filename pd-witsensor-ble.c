@@ -14,7 +14,6 @@
 // Platform-specific includes
 #ifdef _WIN32
     #include <windows.h>
-    #define usleep(x) Sleep((x)/1000)  // usleep takes microseconds, Sleep takes milliseconds
 #else
     #include <unistd.h>
     #include <pthread.h>
@@ -24,91 +23,250 @@
 
 // BLE includes
 #include "witsensor_ble_simpleble.h"
+#include "witsensor_ble_mock.h"
+#include "witsensor_ring.h"
+#include "witsensor_interp.h"
+#include "witsensor_parser.h"
+#include "witsensor_decode.h"
+#include "witsensor_ahrs.h"
+#include "witsensor_poll.h"
+#include "witsensor_pending.h"
+#include "witsensor_snapshot.h"
+#include "witsensor_dejitter.h"
+#include "witsensor_histogram.h"
+#include "witsensor_loss.h"
+#include "witsensor_recorder.h"
+#include "witsensor_replay.h"
+#include "witsensor_platform.h"
 
 #define WITSENSOR_MAJOR_VERSION 0
 #define WITSENSOR_MINOR_VERSION 2
 #define WITSENSOR_BUGFIX_VERSION 1
 
 #define MAX_DEVICES 20
-#define BUFFER_SIZE 256
-#define PACKET_SIZE 20
+#define FRAME_ATOMS 9   // floats per frame in a batched 'frames' list
+#define SIG_CHANNELS 13 // [witsensor~]: 9 frame channels + quaternion w x y z
+#define CMD_QUEUE_SIZE 32
+#define CMD_MAX_BYTES 32
+#define MAX_PERIPHERALS 16 // devices connected through one object
+#define TAGGED_MAX_ATOMS 16 // largest per-device message incl. index and selector
+#define RECONNECT_FIRST_MS 250.0 // autoreconnect: delay after the first failed attempt
+#define RECONNECT_MAX_MS 8000.0  // backoff doubles up to this
+#define DEJITTER_HOLD 64 // timestamped frames held for delivery (100 ms at 200 Hz is 20)
+
+// How frames drained in one scheduler tick are delivered
+typedef enum {
+    COALESCE_OFF = 0,    // one message set per frame
+    COALESCE_LATEST = 1, // only the most recent frame
+    COALESCE_BATCH = 2   // one 'frames <n> ...' list with all frames
+} t_coalesce;
+
+// One queued write; entries sharing a group form a sequence reported as a whole
+typedef struct _witsensor_cmd {
+    unsigned char data[CMD_MAX_BYTES];
+    int length;
+    int request;         // 1: GATT write request, 0: write command
+    t_float delay_ms;    // wait after sending before the next entry
+    int device;          // device slot to write to, -1: every connected device
+    t_symbol *group;     // sequence label for 'command <group> done|failed'
+    int seq;             // sequence id from witsensor_cmd_begin
+    unsigned char span;  // register reads: registers asked for beyond the first row
+    t_symbol *status;    // optional status message emitted once sent
+    int argc;
+    t_atom argv[2];
+} t_witsensor_cmd;
 
 // WIT sensor UUIDs
 #define WIT_SERVICE_UUID "0000ffe5-0000-1000-8000-00805f9a34fb"
 #define WIT_CHAR_READ_UUID "0000ffe4-0000-1000-8000-00805f9a34fb"
 #define WIT_CHAR_WRITE_UUID "0000ffe9-0000-1000-8000-00805f9a34fb"
 
+struct _witsensor;
+
+// One sensor connected through the object. Slot 0 always exists and its BLE
+// handle also runs the object's scan; further slots are added by 'connect'.
+typedef struct _witsensor_device {
+    struct _witsensor *owner;
+    int index;
+    char name[64];               // connect target
+    int is_connected;            // Pd thread view
+    int connecting;              // connect handed to the BLE worker, outcome pending
+    t_symbol *pending_target;    // autoconnect: NULL → none, "*" → any WIT, else exact match
+    witsensor_ble_simpleble_t *ble_data;
+
+    // Autoreconnect (Pd thread)
+    int want_link;               // connected and not disconnected on request since
+    char link_target[128];       // what the last connect used: reconnect target
+    uint64_t lost_ns;            // witsensor_now_ns when the link dropped, 0: no gap
+    int attempts;                // reconnect attempts in the current gap
+    double backoff_ms;           // delay before the next attempt, 0: immediately
+    t_clock *reconnect_clock;
+
+    // De-jitter (Pd thread): timestamped frames held until their reconstructed
+    // time, in Pd logical ms since dejitter_origin
+    witsensor_dejitter_t dejitter;
+    double dejitter_origin;      // clock_getlogicaltime() at device creation
+    witsensor_frame_t held[DEJITTER_HOLD];
+    double held_due[DEJITTER_HOLD]; // logical ms since dejitter_origin
+    int held_head;
+    int held_count;
+    uint64_t late;               // frames that arrived after their delivery time
+    t_clock *dejitter_clock;
+
+    // Link loss of the current connection (Pd thread, frames in producer order)
+    witsensor_loss_t loss;
+
+    // Register polls of this link: reads due and in flight (Pd thread)
+    witsensor_poll_t poll;
+    // Outstanding register reads of this link: timeouts, retries, round trips (Pd thread)
+    witsensor_pending_t pending;
+    t_clock *pending_clock;
+    int reg_start;               // start register of the response being output, -1: none
+    unsigned char reg_span;      // and the span its read asked for
+
+    // Counters at the previous 'stats' (Pd thread)
+    uint64_t stats_dropped;
+    uint64_t stats_notifications;
+
+    // BLE thread only
+    witsensor_parser_t parser;   // frame reassembly across notifications
+    uint64_t rx_ns;              // receive time of the notification being parsed
+    int rx_queued;               // current notification queued output
+    uint32_t frame_seq;
+    witsensor_decode_fn decode;  // batch kernel for decode_mode
+    int decode_mode;
+    unsigned char batch[WITSENSOR_DECODE_BATCH][WITSENSOR_FRAME_SIZE]; // 0x61 frames of this notification
+    int batch_count;
+    witsensor_ahrs_t ahrs;       // host fusion, re-initialised when the settings' reset moves
+    uint32_t ahrs_seen;          // x->ahrs_shared sequence of the settings below
+    witsensor_ahrs_settings_t ahrs_settings;
+    uint32_t ahrs_last_ts;       // device ms of the previous fused frame
+    int ahrs_timed;              // ahrs_last_ts is valid
+
+    // Written by the BLE thread, read by the Pd thread
+    witsensor_snapshot_t snapshot; // newest frame and quaternion
+    witsensor_ring_t frames;     // streaming frames awaiting the drain
+    witsensor_register_ring_t registers; // decoded register responses, same drain
+
+    // Written by the Pd thread, read by the BLE thread once per batch
+    atomic_int output_mode;      // 0..3, picks the decode kernel
+} t_witsensor_device;
+
 typedef struct _witsensor {
     t_object x_obj;
     
     // BLE connection
-    int is_connected;
+    int is_connected;            // any device connected
     int is_scanning;
-    char device_name[64];
-    char device_address[32];
-    
-    // Data buffers
-    unsigned char temp_bytes[PACKET_SIZE];
-    int temp_bytes_count;
-    unsigned char data_buffer[BUFFER_SIZE];
     
-    // Sensor data
-    float accel_x, accel_y, accel_z;
-    float gyro_x, gyro_y, gyro_z;
-    float angle_x, angle_y, angle_z;
-    float quat_w, quat_x, quat_y, quat_z;
-    // Optional streaming variants per output_mode
-    float disp_x, disp_y, disp_z;
-    float speed_x, speed_y, speed_z;
-    unsigned short ts_lo, ts_hi;
-    int use_disp_speed;          // 0: accel/gyro, 1: disp/speed
-    int use_timestamp;   // 0: angle trio, 1: timestamp(+rz)
+    // Devices: output is tagged with the slot index once there is more than one
+    t_witsensor_device *devices[MAX_PERIPHERALS];
+    int device_count;
+
+    // Streaming frames: decoded on the BLE thread, drained on the Pd thread
+    atomic_int drain_pending;    // 1 while a drain is queued with pd_queue_mess
+    t_coalesce coalesce;
+    int dejitter;                // deliver timestamped frames on the device clock
+
+    // Host fusion setting (Pd thread) and its published copy; the BLE thread
+    // picks it up at its next notification
+    witsensor_ahrs_settings_t ahrs;
+    witsensor_ahrs_shared_t ahrs_shared;
+
+    // Latency of streamed frames since the last 'stats' (Pd thread, ns)
+    witsensor_histogram_t lat_decode; // BLE receive -> decoded
+    witsensor_histogram_t lat_output; // decoded -> Pd output
+    witsensor_histogram_t lat_total;  // BLE receive -> Pd output
+    uint64_t stats_frames;
+    uint64_t stats_since_ns;
+
+    // Session recording: BLE callbacks copy raw notifications while non-NULL
+    _Atomic(witsensor_recorder_t *) recorder;
+    atomic_int recorder_users;   // BLE callbacks inside witsensor_recorder_write
+    t_canvas *canvas;            // resolves relative file names
+
+    // Session replay: a thread feeds a recording through the BLE data callback
+    witsensor_replay_t *replay;
+    uint64_t replay_frames;      // parser frames of all slots when it started
+    // Own setting, put back when the replay ends
+    int replay_saved_mode;
+    t_float replay_saved_rate;
+    char replay_saved_names[MAX_PERIPHERALS][64];
+    int replay_saved_count;      // slots whose name was saved
+    t_atom *batch_atoms;         // 'frames' list, sized for all device rings
+    int batch_size;
+
+    // [witsensor~] only: frames resampled to the DSP clock
+    int is_signal;
+    witsensor_interp_mode_t interp;
+    witsensor_interp_t sig_frames;
+    witsensor_interp_t sig_quat;
+    double sig_time;             // samples since creation
+    t_float sig_sr;
+    t_sample *sig_vec[SIG_CHANNELS];
 
     // Threading (legacy - not currently used)
 #ifndef _WIN32
     pthread_t scan_thread;
     pthread_t data_thread;
 #endif
-    int should_stop;
     
     // PureData outlets
     t_outlet *data_out;
     t_outlet *status_out;
     
-    // Clock for polling
+    // Command queue: paced by a clock so configuration never blocks the scheduler
+    t_witsensor_cmd cmd_queue[CMD_QUEUE_SIZE];
+    int cmd_head;
+    int cmd_count;
+    int cmd_busy;                // clock armed for the next entry
+    int cmd_target;              // device slot for entries pushed now, -1: all
+    int cmd_seq;                 // id of the sequence being pushed (witsensor_cmd_begin)
+    int cmd_seq_failed;          // a push of it failed: the rest is ignored
+    t_clock *cmd_clock;
+
+    // Register polling: groups and budget, copied to each device on connect
     t_clock *poll_clock;
-    t_float poll_interval;
-    t_symbol *poll_type;  // "quat", "mag", "battery", "temp", etc.
+    witsensor_poll_t poll;
+    // Register read timeout and resends, applied to every device ('rtt timeout')
+    t_float read_timeout_ms;
+    int read_retries;
     
     // Tracked sensor state
     int axis_mode;       // 6 or 9
     int output_mode;     // AGPVSEL 0..3
+    t_float rate_hz;     // stream rate and code (reg 0x03)
+    unsigned char rate_code;
+    t_float bw_hz;       // filter bandwidth and code (reg 0x1F)
+    unsigned char bw_code;
+    int autoreconnect;   // restore lost links with the tracked configuration
     
-    // BLE specific
+    // BLE specific: slot 0's handle, used for scanning
     witsensor_ble_simpleble_t *ble_data;
     
     // Pd instance for pd_queue_mess
     t_pdinstance *pd_instance;
-    // Autoconnect state: pending_target == NULL → none, "*" → any WIT, else exact match
-    t_symbol *pending_target;
-    // Dedupe device announcements per scan
-    char **seen_ids;
-    unsigned long seen_count;
     
 } t_witsensor;
 
 t_class *witsensor_class;
+t_class *witsensor_tilde_class;
 
 // Forward declarations
 static void witsensor_scan_devices(t_witsensor *x);
 static void witsensor_get_scan_results(t_witsensor *x);
 static void witsensor_connect(t_witsensor *x, t_symbol *s, int argc, t_atom *argv);
-static void witsensor_disconnect(t_witsensor *x);
-static void witsensor_process_register_response(t_witsensor *x, unsigned char *data, int length);
-static void witsensor_process_streaming_data(t_witsensor *x, unsigned char *data, int length);
-static void witsensor_send_sensor_data(t_witsensor *x);
-static void witsensor_send_quaternion_data(t_witsensor *x);
+static void witsensor_connect_slot(t_witsensor *x, t_witsensor_device *dev, const char *target);
+static void witsensor_slot_connected(t_witsensor *x, t_witsensor_device *dev);
+static void witsensor_autoconnect(t_witsensor *x, t_witsensor_device *dev);
+static void witsensor_device_out(t_witsensor *x, t_outlet *out, int index, t_symbol *sel, int argc, t_atom *argv);
+static void witsensor_disconnect(t_witsensor *x, t_symbol *s, int argc, t_atom *argv);
+static void witsensor_process_register_response(t_witsensor_device *dev, const unsigned char *data, int length);
+static void witsensor_process_streaming_data(t_witsensor_device *dev);
+static void witsensor_send_sensor_data(t_witsensor *x, int index, const witsensor_frame_t *f);
 static void witsensor_poll_tick(t_witsensor *x);
+static void witsensor_poll_service(t_witsensor *x);
+static int witsensor_reconnecting(t_witsensor *x);
 static void witsensor_battery(t_witsensor *x);
 static void witsensor_temp(t_witsensor *x);
 static void witsensor_mag(t_witsensor *x);
@@ -119,204 +277,73 @@ static void witsensor_read_version(t_witsensor *x);
 static void witsensor_read_time(t_witsensor *x);
 static void witsensor_reset(t_witsensor *x);
 static void witsensor_setname(t_witsensor *x, t_symbol *s, int argc, t_atom *argv);
-// pd_queue_mess marshaling
-typedef struct _queued_output { 
-    t_symbol *msg; 
-    int argc; 
-    t_atom argv[4]; 
-} t_queued_output;
-
-static void witsensor_pd_output_handler(t_pd *obj, void *data);
-static void witsensor_ble_data_callback(void *user_data, unsigned char *data, int length);
+static void witsensor_cmd_begin(t_witsensor *x);
+static t_witsensor_cmd *witsensor_cmd_push(t_witsensor *x, t_symbol *group, const unsigned char *data, int length, t_float delay_ms);
+static void witsensor_cmd_status(t_witsensor_cmd *cmd, t_symbol *status, int argc, t_atom *argv);
+static void witsensor_cmd_flush(t_witsensor *x);
+// Output selectors of witsensor_registers, interned in witsensor_setup
+static t_symbol *witsensor_register_syms[WITSENSOR_REGISTER_ROWS_MAX];
+
+static void witsensor_pd_drain_handler(t_pd *obj, void *data);
+static void witsensor_ble_data_callback(void *user_data, const unsigned char *data, int length);
 void witsensor_pd_scan_complete_handler(t_pd *obj, void *data);
 // New Pd-thread handlers for status output
-typedef struct _queued_flag { int value; } t_queued_flag;
-typedef struct _queued_device { char *tag; char *addr; char *id; } t_queued_device;
+typedef struct _queued_flag { int value; int index; char *target; char *reason; } t_queued_flag;
+typedef struct _queued_device { char *tag; char *addr; char *id; int rssi; } t_queued_device;
 void witsensor_pd_scanning_handler(t_pd *obj, void *data);
 void witsensor_pd_device_found_handler(t_pd *obj, void *data);
 void witsensor_pd_connected_handler(t_pd *obj, void *data);
 
-// BLE data callback function
-static void witsensor_ble_data_callback(void *user_data, unsigned char *data, int length) {
-    t_witsensor *x = (t_witsensor *)user_data;
-    if (!x) return;
-    if (length <= 0 || length > 64) return;
-    
+// Called by the parser for each complete 20-byte frame (BLE thread)
+static void witsensor_ble_frame_callback(void *user_data, const unsigned char *frame) {
+    t_witsensor_device *dev = (t_witsensor_device *)user_data;
     // Process any register read response (0x71) immediately to avoid queue flooding
-    if (data[0] == 0x55 && data[1] == 0x71 && length >= 6) {
-        witsensor_process_register_response(x, data, length);
-        return;
-    }
-    
-    // Process streaming data (0x61) - parse on BLE thread, queue for Pd thread
-    if (data[0] == 0x55 && data[1] == 0x61 && length >= 20) {
-        witsensor_process_streaming_data(x, data, length);
-        // Queue the output for immediate Pd thread processing
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("streaming");
-            out->argc = 0;
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
+    if (frame[1] == WITSENSOR_FRAME_REGISTER) {
+        witsensor_process_register_response(dev, frame, WITSENSOR_FRAME_SIZE);
         return;
     }
-    return;
+    // Streaming data (0x61) is collected and decoded in one batch per notification
+    memcpy(dev->batch[dev->batch_count++], frame, WITSENSOR_FRAME_SIZE);
+    if (dev->batch_count == WITSENSOR_DECODE_BATCH) witsensor_process_streaming_data(dev);
 }
 
-// Process register read responses immediately on BLE thread (thread-safe for register reads)
-static void witsensor_process_register_response(t_witsensor *x, unsigned char *data, int length) {
-    if (!x || !data || length < 6) return;
-    
-    unsigned char start = data[2];
-    if (start == 0x64) {
-        // Battery centivolts in first word (little-endian)
-        uint16_t vraw = (uint16_t)(data[4] | (data[5] << 8));
-        float volts = (float)vraw / 100.0f;
-        int pct = 0;
-        if (vraw > 396) pct = 100;
-        else if (vraw >= 393) pct = 90;
-        else if (vraw >= 387) pct = 75;
-        else if (vraw >= 382) pct = 60;
-        else if (vraw >= 379) pct = 50;
-        else if (vraw >= 377) pct = 40;
-        else if (vraw >= 373) pct = 30;
-        else if (vraw >= 370) pct = 20;
-        else if (vraw >= 368) pct = 15;
-        else if (vraw >= 350) pct = 10;
-        else if (vraw >= 340) pct = 5;
-        else pct = 0;
-        
-        // Queue the output for Pd thread (thread-safe)
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("battery");
-            out->argc = 2;
-            SETFLOAT(&out->argv[0], volts);
-            SETFLOAT(&out->argv[1], (t_float)pct);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x40 && length >= 6) {
-        // Temperature: assume first word is in centi-degC
-        uint16_t traw = (uint16_t)(data[4] | (data[5] << 8));
-        float degC = (float)((int16_t)traw) / 100.0f;
-        
-        // Queue the output for Pd thread (thread-safe)
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("temp");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)degC);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x3A && length >= 10) {
-        // Magnetic field: three words; convert to uT via /150
-        int16_t mx = (int16_t)((data[5] << 8) | data[4]);
-        int16_t my = (int16_t)((data[7] << 8) | data[6]);
-        int16_t mz = (int16_t)((data[9] << 8) | data[8]);
-        
-        // Queue the output for Pd thread (thread-safe)
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("mag");
-            out->argc = 3;
-            SETFLOAT(&out->argv[0], (t_float)((float)mx / 150.0f));
-            SETFLOAT(&out->argv[1], (t_float)((float)my / 150.0f));
-            SETFLOAT(&out->argv[2], (t_float)((float)mz / 150.0f));
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x51 && length >= 12) {
-        // Quaternion from register page starting at 0x51: four int16 words
-        int16_t q0 = (int16_t)((data[5] << 8) | data[4]);
-        int16_t q1 = (int16_t)((data[7] << 8) | data[6]);
-        int16_t q2 = (int16_t)((data[9] << 8) | data[8]);
-        int16_t q3 = (int16_t)((data[11] << 8) | data[10]);
-        
-        // Store in object (thread-safe for simple assignments)
-        x->quat_w = (float)q0 / 32768.0f;
-        x->quat_x = (float)q1 / 32768.0f;
-        x->quat_y = (float)q2 / 32768.0f;
-        x->quat_z = (float)q3 / 32768.0f;
-        
-        // Queue the output for Pd thread (thread-safe)
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("quat");
-            out->argc = 0;
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x2E && length >= 6) {
-        uint16_t v1 = (uint16_t)(data[4] | (data[5] << 8));
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("version1");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)v1);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
+// BLE data callback function: a notification may hold several frames or a partial one
+static void witsensor_ble_data_callback(void *user_data, const unsigned char *data, int length) {
+    t_witsensor_device *dev = (t_witsensor_device *)user_data;
+    if (!dev || !data || length <= 0) return;
+    t_witsensor *x = dev->owner;
+    dev->rx_ns = witsensor_now_ns();
+    dev->rx_queued = 0;
+    // Recording: raw bytes and receive time, ahead of any parsing
+    atomic_fetch_add(&x->recorder_users, 1);
+    witsensor_recorder_t *rec = atomic_load(&x->recorder);
+    if (rec) witsensor_recorder_write(rec, dev->index, dev->rx_ns, data, length);
+    atomic_fetch_sub(&x->recorder_users, 1);
+    witsensor_parser_feed(&dev->parser, data, length, witsensor_ble_frame_callback, dev);
+    if (dev->batch_count) witsensor_process_streaming_data(dev);
+    // Wake the Pd-side consumer once; it drains every device's queue
+    if (dev->rx_queued && !atomic_exchange(&x->drain_pending, 1)) {
+        pd_queue_mess(x->pd_instance, (t_pd *)x, NULL, witsensor_pd_drain_handler);
     }
-    if (start == 0x2F && length >= 6) {
-        uint16_t v2 = (uint16_t)(data[4] | (data[5] << 8));
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("version2");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)v2);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x30 && length >= 6) {
-        uint16_t yymm = (uint16_t)(data[4] | (data[5] << 8));
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("time_yymm");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)yymm);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x31 && length >= 6) {
-        uint16_t ddh = (uint16_t)(data[4] | (data[5] << 8));
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("time_ddh");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)ddh);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
-        }
-        return;
-    }
-    if (start == 0x32 && length >= 6) {
-        uint16_t mmss = (uint16_t)(data[4] | (data[5] << 8));
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("time_mmss");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)mmss);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
+}
+
+// Decode register read responses on the BLE thread (table-driven, no allocation)
+static void witsensor_process_register_response(t_witsensor_device *dev, const unsigned char *data, int length) {
+    if (!dev || !data || length < WITSENSOR_FRAME_SIZE) return;
+    // One response can carry several rows; witsensor_send_register outputs those the read asked for
+    witsensor_register_t regs[WITSENSOR_REGISTER_MAX_WORDS];
+    int n = witsensor_register_decode(data, regs, WITSENSOR_REGISTER_MAX_WORDS);
+    for (int i = 0; i < n; i++) {
+        witsensor_register_t *reg = &regs[i];
+        reg->rx_ns = dev->rx_ns;
+        if (witsensor_registers[reg->index].flags & WITSENSOR_REGISTER_QUAT) {
+            // Publish as one unit so 'latest' sees the same quaternion
+            witsensor_snapshot_store_quat(&dev->snapshot, reg->v, dev->rx_ns);
         }
-        return;
-    }
-    if (start == 0x33 && length >= 6) {
-        uint16_t ms = (uint16_t)(data[4] | (data[5] << 8));
-        t_queued_output *out = (t_queued_output *)malloc(sizeof(t_queued_output));
-        if (out) {
-            out->msg = gensym("time_ms");
-            out->argc = 1;
-            SETFLOAT(&out->argv[0], (t_float)ms);
-            pd_queue_mess(x->pd_instance, (t_pd *)x, out, witsensor_pd_output_handler);
+        if (witsensor_registers[reg->index].flags & WITSENSOR_REGISTER_MAG) {
+            witsensor_ahrs_set_mag(&dev->ahrs, reg->v, dev->rx_ns);
         }
-        return;
+        if (witsensor_register_ring_push(&dev->registers, reg)) dev->rx_queued = 1;
     }
 }
 
@@ -333,17 +360,13 @@ void witsensor_pd_scan_complete_handler(t_pd *obj, void *data) {
     if (x->ble_data->scan_found_count > 0) {
         post("WITSensorBLE: Devices seen via callbacks: %d", x->ble_data->scan_found_count);
     }
-    unsigned long n = x->ble_data->cached_count;
+    unsigned int n = witsensor_ble_simpleble_result_count(x->ble_data);
     if (n == 0) {
         post("WITSensorBLE: Found 0 devices. Ensure Bluetooth is on and devices are advertising.");
         return;
     }
-    post("WITSensorBLE: Found %lu devices", n);
-    for (unsigned long i = 0; i < n; i++) {
-        const char *id = x->ble_data->cached_ids ? x->ble_data->cached_ids[i] : NULL;
-        const char *addr = x->ble_data->cached_addrs ? x->ble_data->cached_addrs[i] : NULL;
-        if (id && addr) post("WITSensorBLE: Found device: %s [%s]", id, addr);
-    }
+    post("WITSensorBLE: Found %u devices", n);
+    witsensor_ble_simpleble_get_scan_results(x->ble_data);
 }
 
 // Emit scanning status on Pd thread
@@ -364,61 +387,63 @@ void witsensor_pd_device_found_handler(t_pd *obj, void *data) {
     t_witsensor *x = (t_witsensor *)obj;
     t_queued_device *d = (t_queued_device *)data;
     if (x && d) {
-        // Dedupe in current session
-        if (d->id) {
-            int seen = 0;
-            for (unsigned long i = 0; i < x->seen_count; i++) {
-                if (x->seen_ids && x->seen_ids[i] && strcmp(x->seen_ids[i], d->id) == 0) { seen = 1; break; }
-            }
-            if (!seen) {
-                char **new_ids = (char**)realloc(x->seen_ids, (x->seen_count + 1) * sizeof(char*));
-                if (new_ids) {
-                    x->seen_ids = new_ids;
-                    x->seen_ids[x->seen_count] = strdup(d->id);
-                    x->seen_count++;
-                }
-            }
-        }
-        if (x->pending_target && !x->is_connected && x->is_scanning) {
-            int should_connect = 0;
-            const char *target = x->pending_target->s_name;
+        // Announcements are deduplicated by the scan cache in the BLE layer
+        // First device slot waiting to autoconnect to this device
+        t_witsensor_device *slot = NULL;
+        for (int i = 0; i < x->device_count && x->is_scanning && !slot; i++) {
+            t_witsensor_device *dev = x->devices[i];
+            if (!dev->pending_target || dev->is_connected || dev->connecting) continue;
+            const char *target = dev->pending_target->s_name;
             if (target && target[0] && strcmp(target, "*") != 0) {
                 if ((d->id && strcmp(d->id, target) == 0) || (d->addr && strcmp(d->addr, target) == 0)) {
-                    should_connect = 1;
+                    slot = dev;
                 }
             } else if (target && strcmp(target, "*") == 0) {
-                if (d->tag && strcmp(d->tag, "wit") == 0) {
-                    should_connect = 1;
+                // Any WIT device that no other object or slot has taken yet
+                if (d->tag && strcmp(d->tag, "wit") == 0 && d->id
+                    && !witsensor_ble_simpleble_is_claimed(dev->ble_data, d->id)
+                    && !(d->addr && witsensor_ble_simpleble_is_claimed(dev->ble_data, d->addr))) {
+                    slot = dev;
                 }
             }
-            if (should_connect && d->id) {
-                // Emit device status before autoconnect so UI sees the WIT
-                t_atom da[3];
-                SETSYMBOL(&da[0], gensym(d->tag ? d->tag : "other"));
-                SETSYMBOL(&da[1], gensym(d->addr ? d->addr : ""));
-                SETSYMBOL(&da[2], gensym(d->id));
-                outlet_anything(x->status_out, gensym("device"), 3, da);
-                // Emit autoconnecting notice
-                t_atom ac[1]; SETSYMBOL(&ac[0], gensym(d->id));
-                outlet_anything(x->status_out, gensym("autoconnecting"), 1, ac);
-                // Reuse Pd-level connect (A_GIMME signature)
-                t_atom a[1];
-                SETSYMBOL(&a[0], gensym(d->id));
-                witsensor_connect(x, &s_, 1, a);
-                // Clear pending_target after initiating connect to avoid duplicate autoconnects
-                x->pending_target = NULL;
-                if (d->tag) free(d->tag);
-                if (d->addr) free(d->addr);
-                if (d->id) free(d->id);
-                free(d);
-                return;
+        }
+        // A lost device showing up again: retry now instead of after the backoff
+        for (int i = 0; i < x->device_count; i++) {
+            t_witsensor_device *dev = x->devices[i];
+            if (!dev->lost_ns || dev->connecting) continue;
+            if ((d->addr && strcmp(d->addr, dev->link_target) == 0)
+                || (d->id && strcmp(d->id, dev->link_target) == 0)) {
+                clock_delay(dev->reconnect_clock, 0);
             }
         }
-        t_atom a[3];
+        if (slot && d->id) {
+            // Emit device status before autoconnect so UI sees the WIT
+            t_atom da[4];
+            SETSYMBOL(&da[0], gensym(d->tag ? d->tag : "other"));
+            SETSYMBOL(&da[1], gensym(d->addr ? d->addr : ""));
+            SETSYMBOL(&da[2], gensym(d->id));
+            SETFLOAT(&da[3], (t_float)d->rssi);
+            outlet_anything(x->status_out, gensym("device"), 4, da);
+            // Emit autoconnecting notice
+            t_atom ac[1]; SETSYMBOL(&ac[0], gensym(d->id));
+            witsensor_device_out(x, x->status_out, slot->index, gensym("autoconnecting"), 1, ac);
+            // Clear pending_target before connecting to avoid duplicate autoconnects;
+            // a wildcard slot keeps the address, names need not be unique
+            int wildcard = strcmp(slot->pending_target->s_name, "*") == 0;
+            slot->pending_target = NULL;
+            witsensor_connect_slot(x, slot, (wildcard && d->addr && d->addr[0]) ? d->addr : d->id);
+            if (d->tag) free(d->tag);
+            if (d->addr) free(d->addr);
+            if (d->id) free(d->id);
+            free(d);
+            return;
+        }
+        t_atom a[4];
         SETSYMBOL(&a[0], gensym(d->tag ? d->tag : "other"));
         SETSYMBOL(&a[1], gensym(d->addr ? d->addr : ""));
         SETSYMBOL(&a[2], gensym(d->id ? d->id : ""));
-        outlet_anything(x->status_out, gensym("device"), 3, a);
+        SETFLOAT(&a[3], (t_float)d->rssi);
+        outlet_anything(x->status_out, gensym("device"), 4, a);
     }
     if (d) {
         if (d->tag) free(d->tag);
@@ -429,100 +454,288 @@ void witsensor_pd_device_found_handler(t_pd *obj, void *data) {
 }
 
 
-// Process streaming data directly on BLE thread (SAFE - no Pd calls)
-static void witsensor_process_streaming_data(t_witsensor *x, unsigned char *data, int length) {
-    if (!x || !data || length < 20) return;
-    
-    // Derive flags from output_mode bits
-    int16_t i0 = (int16_t)((data[3] << 8) | data[2]);
-    int16_t i1 = (int16_t)((data[5] << 8) | data[4]);
-    int16_t i2 = (int16_t)((data[7] << 8) | data[6]);
-    int16_t i3 = (int16_t)((data[9] << 8) | data[8]);
-    int16_t i4 = (int16_t)((data[11] << 8) | data[10]);
-    int16_t i5 = (int16_t)((data[13] << 8) | data[12]);
-    int16_t i6 = (int16_t)((data[15] << 8) | data[14]);
-    int16_t i7 = (int16_t)((data[17] << 8) | data[16]);
-    int16_t i8 = (int16_t)((data[19] << 8) | data[18]);
-
-    // First 12 bytes: either disp/speed or accel/gyro
-    if (x->use_disp_speed) {
-        // Displacement (mm) and speed (mm/s) are direct int16 units per vendor docs
-        x->disp_x = (float)i0;
-        x->disp_y = (float)i1;
-        x->disp_z = (float)i2;
-        x->speed_x = (float)i3;
-        x->speed_y = (float)i4;
-        x->speed_z = (float)i5;
-    } else {
-        x->accel_x = (float)i0 / 32768.0f * 16.0f;
-        x->accel_y = (float)i1 / 32768.0f * 16.0f;
-        x->accel_z = (float)i2 / 32768.0f * 16.0f;
-        x->gyro_x = (float)i3 / 32768.0f * 2000.0f;
-        x->gyro_y = (float)i4 / 32768.0f * 2000.0f;
-        x->gyro_z = (float)i5 / 32768.0f * 2000.0f;
-    }
-    if (x->use_timestamp) {
-        // Timestamp in ms: 32-bit little-endian composed from two int16 words
-        x->ts_lo = (unsigned short)((uint16_t)i6);
-        x->ts_hi = (unsigned short)((uint16_t)i7);
-    } else {
-        x->angle_x = (float)i6 / 32768.0f * 180.0f;
-        x->angle_y = (float)i7 / 32768.0f * 180.0f;
+// Host fusion of decoded accel/gyro frames (BLE thread). The step is the
+// device clock difference in timestamp modes, the configured period otherwise.
+static void witsensor_fuse(t_witsensor_device *dev, witsensor_frame_t *f, int count) {
+    t_witsensor *x = dev->owner;
+    uint32_t reset = dev->ahrs_settings.reset;
+    if (witsensor_ahrs_shared_load(&x->ahrs_shared, &dev->ahrs_settings, &dev->ahrs_seen)) {
+        // A rate change only moves the period; the orientation carries on
+        const witsensor_ahrs_settings_t *s = &dev->ahrs_settings;
+        if (s->reset != reset) {
+            witsensor_ahrs_init(&dev->ahrs, s->algorithm, s->gain, s->gain_i);
+            dev->ahrs_timed = 0;
+        }
+    }
+    if (dev->ahrs.algorithm == WITSENSOR_AHRS_OFF) return;
+    float period = dev->ahrs_settings.period;
+    for (int i = 0; i < count; i++) {
+        if (f[i].flags & WITSENSOR_FRAME_DISP_SPEED) continue; // no accel/gyro in this mode
+        float dt = period;
+        if (f[i].flags & WITSENSOR_FRAME_TIMESTAMP) {
+            uint32_t step = f[i].timestamp - dev->ahrs_last_ts;
+            if (dev->ahrs_timed && step > 0 && step < 1000) dt = (float)step / 1000.0f;
+            dev->ahrs_last_ts = f[i].timestamp;
+            dev->ahrs_timed = 1;
+        }
+        witsensor_ahrs_update(&dev->ahrs, f[i].v + 3, f[i].v, dt, dev->rx_ns, f[i].quat);
+        f[i].flags |= WITSENSOR_FRAME_QUAT;
     }
-    x->angle_z = (float)i8 / 32768.0f * 180.0f;
 }
 
-// Send quaternion data as PureData messages
-static void witsensor_send_quaternion_data(t_witsensor *x) {
-    t_atom args[4];
-    
-    // Send quaternion data (4 floats: w, x, y, z)
-    SETFLOAT(&args[0], x->quat_w);
-    SETFLOAT(&args[1], x->quat_x);
-    SETFLOAT(&args[2], x->quat_y);
-    SETFLOAT(&args[3], x->quat_z);
-    outlet_anything(x->data_out, gensym("quat"), 4, args);
+// Publish the fusion setting and the frame period from rate_hz (Pd thread)
+static void witsensor_ahrs_publish(t_witsensor *x) {
+    x->ahrs.period = x->rate_hz > 0 ? 1.0f / x->rate_hz : 0.0f;
+    witsensor_ahrs_shared_store(&x->ahrs_shared, &x->ahrs);
 }
 
-// Send sensor data as PureData messages
-static void witsensor_send_sensor_data(t_witsensor *x) {
+// Decode the collected streaming frames on the BLE thread (SAFE - no Pd calls)
+static void witsensor_process_streaming_data(t_witsensor_device *dev) {
+    int count = dev->batch_count;
+    witsensor_frame_t f[WITSENSOR_DECODE_BATCH];
+    dev->batch_count = 0;
+    int mode = atomic_load_explicit(&dev->output_mode, memory_order_acquire);
+    if (mode != dev->decode_mode) {
+        dev->decode_mode = mode;
+        dev->decode = witsensor_decode_kernel(mode, 1);
+    }
+    dev->decode((const unsigned char (*)[WITSENSOR_FRAME_SIZE])dev->batch, count, f);
+    witsensor_fuse(dev, f, count);
+    uint64_t decode_ns = witsensor_now_ns();
+    for (int i = 0; i < count; i++) {
+        f[i].seq = dev->frame_seq++;
+        f[i].rx_ns = dev->rx_ns;
+        f[i].decode_ns = decode_ns;
+        witsensor_ring_push(&dev->frames, &f[i]);
+    }
+    // Only the newest frame is visible through the snapshot anyway
+    witsensor_snapshot_store_frame(&dev->snapshot, &f[count - 1]);
+    dev->rx_queued = 1;
+}
+
+// Publish the output mode to the BLE thread, which switches the decode kernel
+// at its next batch (-1: not configured yet, decode as mode 0)
+static void witsensor_device_set_mode(t_witsensor_device *dev, int output_mode) {
+    atomic_store_explicit(&dev->output_mode, output_mode < 0 ? 0 : output_mode, memory_order_release);
+}
+
+// Output a per-device message. Objects with several devices prefix it with the
+// device index (list <index> <selector> ...) so [route 0 1 2 ...] splits them.
+static void witsensor_device_out(t_witsensor *x, t_outlet *out, int index, t_symbol *sel, int argc, t_atom *argv) {
+    if (x->device_count <= 1 || index < 0) {
+        outlet_anything(out, sel, argc, argv);
+        return;
+    }
+    t_atom buf[TAGGED_MAX_ATOMS];
+    if (argc > TAGGED_MAX_ATOMS - 2) argc = TAGGED_MAX_ATOMS - 2;
+    SETFLOAT(&buf[0], (t_float)index);
+    SETSYMBOL(&buf[1], sel);
+    for (int i = 0; i < argc; i++) buf[2 + i] = argv[i];
+    outlet_list(out, &s_list, argc + 2, buf);
+}
+
+// Send one decoded frame as PureData messages
+static void witsensor_send_sensor_data(t_witsensor *x, int index, const witsensor_frame_t *f) {
     t_atom args[3];
-    if (x->use_disp_speed) {
-        SETFLOAT(&args[0], x->disp_x);
-        SETFLOAT(&args[1], x->disp_y);
-        SETFLOAT(&args[2], x->disp_z);
-        outlet_anything(x->data_out, gensym("disp"), 3, args);
-        SETFLOAT(&args[0], x->speed_x);
-        SETFLOAT(&args[1], x->speed_y);
-        SETFLOAT(&args[2], x->speed_z);
-        outlet_anything(x->data_out, gensym("speed"), 3, args);
+    if (f->flags & WITSENSOR_FRAME_DISP_SPEED) {
+        SETFLOAT(&args[0], f->v[0]);
+        SETFLOAT(&args[1], f->v[1]);
+        SETFLOAT(&args[2], f->v[2]);
+        witsensor_device_out(x, x->data_out, index, gensym("disp"), 3, args);
+        SETFLOAT(&args[0], f->v[3]);
+        SETFLOAT(&args[1], f->v[4]);
+        SETFLOAT(&args[2], f->v[5]);
+        witsensor_device_out(x, x->data_out, index, gensym("speed"), 3, args);
     } else {
-        SETFLOAT(&args[0], x->accel_x);
-        SETFLOAT(&args[1], x->accel_y);
-        SETFLOAT(&args[2], x->accel_z);
-        outlet_anything(x->data_out, gensym("accel"), 3, args);
-        SETFLOAT(&args[0], x->gyro_x);
-        SETFLOAT(&args[1], x->gyro_y);
-        SETFLOAT(&args[2], x->gyro_z);
-        outlet_anything(x->data_out, gensym("gyro"), 3, args);
-    }
-    if (x->use_timestamp) {
-        SETFLOAT(&args[0], (t_float)x->ts_hi);
-        SETFLOAT(&args[1], (t_float)x->ts_lo);
-        outlet_anything(x->data_out, gensym("timestamp"), 2, args);
-        SETFLOAT(&args[0], 0);
-        SETFLOAT(&args[1], 0);
-        SETFLOAT(&args[2], x->angle_z);
-        outlet_anything(x->data_out, gensym("angle"), 3, args);
+        SETFLOAT(&args[0], f->v[0]);
+        SETFLOAT(&args[1], f->v[1]);
+        SETFLOAT(&args[2], f->v[2]);
+        witsensor_device_out(x, x->data_out, index, gensym("accel"), 3, args);
+        SETFLOAT(&args[0], f->v[3]);
+        SETFLOAT(&args[1], f->v[4]);
+        SETFLOAT(&args[2], f->v[5]);
+        witsensor_device_out(x, x->data_out, index, gensym("gyro"), 3, args);
+    }
+    if (f->flags & WITSENSOR_FRAME_TIMESTAMP) {
+        SETFLOAT(&args[0], (t_float)(f->timestamp >> 16));
+        SETFLOAT(&args[1], (t_float)(f->timestamp & 0xFFFF));
+        witsensor_device_out(x, x->data_out, index, gensym("timestamp"), 2, args);
+    }
+    SETFLOAT(&args[0], f->v[6]);
+    SETFLOAT(&args[1], f->v[7]);
+    SETFLOAT(&args[2], f->v[8]);
+    witsensor_device_out(x, x->data_out, index, gensym("angle"), 3, args);
+    if (f->flags & WITSENSOR_FRAME_QUAT) {
+        t_atom q[4];
+        for (int j = 0; j < 4; j++) SETFLOAT(&q[j], f->quat[j]);
+        witsensor_device_out(x, x->data_out, index, gensym("quat"), 4, q);
+    }
+}
+
+// A register read was given up: free its poll group and report
+// timeout <register> <resends> on the status outlet
+static void witsensor_read_timeout(t_witsensor_device *dev, unsigned char reg, int tries) {
+    witsensor_poll_missed(&dev->poll, reg);
+    int row = witsensor_register_lookup(reg);
+    t_atom args[2];
+    if (row >= 0) SETSYMBOL(&args[0], witsensor_register_syms[row]);
+    else SETFLOAT(&args[0], reg);
+    SETFLOAT(&args[1], tries);
+    witsensor_device_out(dev->owner, dev->owner->status_out, dev->index, gensym("timeout"), 2, args);
+}
+
+// Write to one device slot or, with index -1, to every connected device;
+// returns 1 if at least one write went out and none failed. A register read
+// asks for span registers (0: the row at its start register only).
+static int witsensor_write_span(t_witsensor *x, int index, const unsigned char *data, int length, int request,
+                                unsigned char span) {
+    int sent = 0, failed = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if ((index >= 0 && i != index) || !dev->is_connected) continue;
+        int ok = request
+            ? witsensor_ble_simpleble_write_request_raw(dev->ble_data, data, length)
+            : witsensor_ble_simpleble_write_data(dev->ble_data, data, length);
+        if (ok) sent++; else failed++;
+        if (ok && length >= 4 && data[0] == 0xFF && data[1] == 0xAA && data[2] == 0x27) {
+            // Register read: expect a 0x71 answer starting at data[3]
+            double now = (double)witsensor_now_ns() / 1e6;
+            int tries = 0;
+            int evicted = witsensor_pending_issue(&dev->pending, data[3], span, now, &tries);
+            // Table full: the oldest read made room and is given up
+            if (evicted >= 0) witsensor_read_timeout(dev, (unsigned char)evicted, tries);
+            clock_delay(dev->pending_clock, witsensor_pending_wait(&dev->pending, now));
+        }
+    }
+    return sent > 0 && !failed;
+}
+
+static int witsensor_write(t_witsensor *x, int index, const unsigned char *data, int length, int request) {
+    return witsensor_write_span(x, index, data, length, request, 0);
+}
+
+// Resend or give up on register reads left unanswered for the timeout
+static void witsensor_pending_tick(t_witsensor_device *dev) {
+    t_witsensor *x = dev->owner;
+    double now = (double)witsensor_now_ns() / 1e6;
+    unsigned char reg;
+    int tries;
+    witsensor_pending_event_t event;
+    while ((event = witsensor_pending_expire(&dev->pending, now, &reg, &tries)) != WITSENSOR_PENDING_NONE) {
+        if (event == WITSENSOR_PENDING_RETRY) {
+            unsigned char cmd[] = {0xFF, 0xAA, 0x27, reg, 0x00};
+            witsensor_write(x, dev->index, cmd, sizeof(cmd), 0);
+            continue;
+        }
+        witsensor_read_timeout(dev, reg, tries);
+    }
+    double wait = witsensor_pending_wait(&dev->pending, now);
+    if (wait >= 0) clock_delay(dev->pending_clock, wait);
+    // A group freed by a timeout can be read again
+    if (x->poll.count) witsensor_poll_service(x);
+}
+
+// Report a finished or failed command sequence on the status outlet
+static void witsensor_cmd_report(t_witsensor *x, t_symbol *group, t_symbol *result) {
+    t_atom a[2];
+    SETSYMBOL(&a[0], group);
+    SETSYMBOL(&a[1], result);
+    outlet_anything(x->status_out, gensym("command"), 2, a);
+}
+
+// Send the head of the command queue and schedule the next entry after its delay
+static void witsensor_cmd_tick(t_witsensor *x) {
+    x->cmd_busy = 0;
+    if (x->cmd_count <= 0) return;
+    if (!x->is_connected || !x->ble_data) {
+        witsensor_cmd_flush(x);
+        return;
+    }
+    t_witsensor_cmd *cmd = &x->cmd_queue[x->cmd_head];
+    x->cmd_head = (x->cmd_head + 1) % CMD_QUEUE_SIZE;
+    x->cmd_count--;
+    int ok = witsensor_write_span(x, cmd->device, cmd->data, cmd->length, cmd->request, cmd->span);
+    t_witsensor_cmd *next = x->cmd_count > 0 ? &x->cmd_queue[x->cmd_head] : NULL;
+    if (!ok) {
+        // Drop the rest of this sequence; later sequences still run
+        while (x->cmd_count > 0 && x->cmd_queue[x->cmd_head].seq == cmd->seq) {
+            x->cmd_head = (x->cmd_head + 1) % CMD_QUEUE_SIZE;
+            x->cmd_count--;
+        }
+        witsensor_cmd_report(x, cmd->group, gensym("failed"));
+        next = x->cmd_count > 0 ? &x->cmd_queue[x->cmd_head] : NULL;
     } else {
-        SETFLOAT(&args[0], x->angle_x);
-        SETFLOAT(&args[1], x->angle_y);
-        SETFLOAT(&args[2], x->angle_z);
-        outlet_anything(x->data_out, gensym("angle"), 3, args);
+        if (cmd->status) witsensor_device_out(x, x->status_out, cmd->device, cmd->status, cmd->argc, cmd->argv);
+        if (!next || next->seq != cmd->seq) witsensor_cmd_report(x, cmd->group, gensym("done"));
     }
+    if (next) {
+        x->cmd_busy = 1;
+        clock_delay(x->cmd_clock, ok ? cmd->delay_ms : 0);
+    }
+}
+
+// Start a new sequence: the following pushes run, fail and report as one
+static void witsensor_cmd_begin(t_witsensor *x) {
+    x->cmd_seq++;
+    x->cmd_seq_failed = 0;
+}
+
+// Queue a write command of the current sequence; returns the entry (to attach
+// a status message) or NULL. If it does not fit, the entries of the sequence
+// queued so far are taken back, so a sequence runs whole or not at all.
+static t_witsensor_cmd *witsensor_cmd_push(t_witsensor *x, t_symbol *group, const unsigned char *data, int length, t_float delay_ms) {
+    if (x->cmd_seq_failed) return NULL;
+    if (length <= 0 || length > CMD_MAX_BYTES || x->cmd_count >= CMD_QUEUE_SIZE) {
+        // Nothing of this sequence was sent yet: the clock runs after this method returns
+        while (x->cmd_count > 0 && x->cmd_queue[(x->cmd_head + x->cmd_count - 1) % CMD_QUEUE_SIZE].seq == x->cmd_seq) {
+            x->cmd_count--;
+        }
+        x->cmd_seq_failed = 1;
+        witsensor_cmd_report(x, group, gensym("failed"));
+        return NULL;
+    }
+    t_witsensor_cmd *cmd = &x->cmd_queue[(x->cmd_head + x->cmd_count) % CMD_QUEUE_SIZE];
+    memcpy(cmd->data, data, (size_t)length);
+    cmd->length = length;
+    cmd->request = 0;
+    cmd->device = x->cmd_target;
+    cmd->delay_ms = delay_ms;
+    cmd->group = group;
+    cmd->seq = x->cmd_seq;
+    cmd->span = 0;
+    cmd->status = NULL;
+    cmd->argc = 0;
+    x->cmd_count++;
+    if (!x->cmd_busy) {
+        x->cmd_busy = 1;
+        clock_delay(x->cmd_clock, 0);
+    }
+    return cmd;
+}
+
+static void witsensor_cmd_status(t_witsensor_cmd *cmd, t_symbol *status, int argc, t_atom *argv) {
+    if (!cmd) return;
+    if (argc > 2) argc = 2;
+    cmd->status = status;
+    cmd->argc = argc;
+    for (int i = 0; i < argc; i++) cmd->argv[i] = argv[i];
+}
+
+// Drop all queued commands, reporting each pending sequence as failed
+static void witsensor_cmd_flush(t_witsensor *x) {
+    int last = -1;
+    while (x->cmd_count > 0) {
+        t_witsensor_cmd *cmd = &x->cmd_queue[x->cmd_head];
+        x->cmd_head = (x->cmd_head + 1) % CMD_QUEUE_SIZE;
+        x->cmd_count--;
+        if (cmd->seq != last) witsensor_cmd_report(x, cmd->group, gensym("failed"));
+        last = cmd->seq;
+    }
+    x->cmd_busy = 0;
+    clock_unset(x->cmd_clock);
 }
 
-// Function for polling requests (battery/temp/mag/quat)
+// Poll clock: refresh the link state and issue the reads that are due
 static void witsensor_poll_tick(t_witsensor *x) {
     if (!x || !x->ble_data) {
         post("witsensor: ERROR - Invalid object or BLE data");
@@ -530,88 +743,342 @@ static void witsensor_poll_tick(t_witsensor *x) {
     }
     
     // Check connection status
-    x->is_connected = witsensor_ble_simpleble_is_connected(x->ble_data);
+    x->is_connected = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        x->devices[i]->is_connected = witsensor_ble_simpleble_is_connected(x->devices[i]->ble_data);
+        x->is_connected |= x->devices[i]->is_connected;
+    }
     x->is_scanning = witsensor_ble_simpleble_is_scanning(x->ble_data);
+    witsensor_poll_service(x);
+}
 
-    // Only poll if connected and interval is set
-    if (x->poll_interval > 0 && x->is_connected && x->poll_type) {
-        // Call the appropriate single-shot function based on poll_type
-        if (x->poll_type == gensym("quat")) {
-            witsensor_quat(x);
-        } else if (x->poll_type == gensym("mag")) {
-            witsensor_mag(x);
-        } else if (x->poll_type == gensym("battery")) {
-            witsensor_battery(x);
-        } else if (x->poll_type == gensym("temp")) {
-            witsensor_temp(x);
+// Issue at most one due register read per connected device and arm the poll
+// clock for the next. Also runs after every drain, so while streaming the
+// reads go out right behind a notification; the clock then waits one frame
+// period longer and only steps in when the stream has stalled.
+static void witsensor_poll_service(t_witsensor *x) {
+    if (!x->poll.count) {
+        clock_unset(x->poll_clock);
+        return;
+    }
+    double now = (double)witsensor_now_ns() / 1e6;
+    double wait = -1;
+    int streaming = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if (!dev->is_connected) continue;
+        int reg = witsensor_poll_next(&dev->poll, now);
+        if (reg >= 0) {
+            unsigned char cmd[] = {0xFF, 0xAA, 0x27, (unsigned char)reg, 0x00};
+            // Not sent: no answer and no timeout will come, free the group now
+            if (!witsensor_write(x, i, cmd, sizeof(cmd), 0)) witsensor_poll_missed(&dev->poll, (unsigned char)reg);
         }
-        
-        // Schedule next poll
-        clock_delay(x->poll_clock, x->poll_interval);
-    } else if (x->poll_interval > 0 && !x->is_connected) {
-        // Stop polling when disconnected
-        post("witsensor: disconnected, stopping %s polling", x->poll_type ? x->poll_type->s_name : "unknown");
-        x->poll_interval = 0;
-        x->poll_type = NULL;
+        double w = witsensor_poll_wait(&dev->poll, now);
+        if (w >= 0 && (wait < 0 || w < wait)) wait = w;
+        if (dev->loss.last_rx_ns && now - (double)dev->loss.last_rx_ns / 1e6 < WITSENSOR_LOSS_ARRIVAL_SLACK_MS) streaming = 1;
+    }
+    if (wait < 0) {
+        // Nothing connected: resumes from witsensor_slot_connected
+        clock_unset(x->poll_clock);
+        return;
+    }
+    if (streaming && x->rate_hz > 0) wait += 1000.0 / x->rate_hz;
+    clock_delay(x->poll_clock, wait);
+}
+
+// Output one decoded register response on the Pd scheduler thread
+static void witsensor_send_register(t_witsensor *x, int index, const witsensor_register_t *reg) {
+    const witsensor_register_desc_t *desc = &witsensor_registers[reg->index];
+    t_witsensor_device *dev = x->devices[index];
+    // The first row of a response answers the read of its start register
+    if (desc->addr == reg->start || (desc->flags & WITSENSOR_REGISTER_RAW)) {
+        witsensor_pending_match(&dev->pending, reg->start, (double)reg->rx_ns / 1e6, NULL, &dev->reg_span);
+        witsensor_poll_match(&dev->poll, reg->start);
+        dev->reg_start = reg->start;
+    } else if (reg->start != dev->reg_start || ((desc->addr - reg->start) & 0xFF) + desc->words > dev->reg_span) {
+        // A later row of the response that its read did not ask for
+        return;
     }
+    if ((desc->flags & WITSENSOR_REGISTER_QUAT) && x->is_signal && index == 0) {
+        witsensor_interp_push(&x->sig_quat, x->sig_time, reg->v);
+    }
+    t_atom args[WITSENSOR_REGISTER_MAX_VALUES];
+    for (int i = 0; i < reg->argc; i++) SETFLOAT(&args[i], reg->v[i]);
+    t_outlet *out = desc->outlet == WITSENSOR_OUTLET_DATA ? x->data_out : x->status_out;
+    witsensor_device_out(x, out, index, witsensor_register_syms[reg->index], reg->argc, args);
+}
+
+// Flatten a frame in message order; timestamp modes put ts_hi ts_lo in place of angle x/y
+static void witsensor_frame_to_atoms(const witsensor_frame_t *f, t_atom *argv) {
+    for (int i = 0; i < FRAME_ATOMS; i++) SETFLOAT(&argv[i], f->v[i]);
+    if (f->flags & WITSENSOR_FRAME_TIMESTAMP) {
+        SETFLOAT(&argv[6], (t_float)(f->timestamp >> 16));
+        SETFLOAT(&argv[7], (t_float)(f->timestamp & 0xFFFF));
+    }
+}
+
+// Keep the recording header in step with the configuration and the sensors
+static void witsensor_record_info(t_witsensor *x) {
+    witsensor_recorder_t *rec = atomic_load(&x->recorder);
+    if (!rec) return;
+    witsensor_recorder_set_config(rec, x->rate_hz, x->output_mode);
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        witsensor_recorder_set_sensor(rec, i, dev->link_target[0] ? dev->link_target : dev->name);
+    }
+}
+
+// Record the latency of a frame leaving the object at out_ns
+static void witsensor_stats_frame(t_witsensor *x, const witsensor_frame_t *f, uint64_t out_ns) {
+    witsensor_histogram_add(&x->lat_decode, f->decode_ns - f->rx_ns);
+    witsensor_histogram_add(&x->lat_output, out_ns > f->decode_ns ? out_ns - f->decode_ns : 0);
+    witsensor_histogram_add(&x->lat_total, out_ns > f->rx_ns ? out_ns - f->rx_ns : 0);
+    x->stats_frames++;
+}
+
+// Feed slot 0's frame (and fused quaternion) to the [witsensor~] resamplers
+static void witsensor_signal_frame(t_witsensor *x, const witsensor_frame_t *f) {
+    witsensor_interp_push(&x->sig_frames, x->sig_time, f->v);
+    if (f->flags & WITSENSOR_FRAME_QUAT) witsensor_interp_push(&x->sig_quat, x->sig_time, f->quat);
+}
+
+// Output one streamed frame now (signal interpolation and messages)
+static void witsensor_deliver_frame(t_witsensor *x, int index, const witsensor_frame_t *f) {
+    witsensor_stats_frame(x, f, witsensor_now_ns());
+    if (x->is_signal && index == 0) witsensor_signal_frame(x, f);
+    witsensor_send_sensor_data(x, index, f);
+}
+
+// Take the oldest held frame out before delivering it, as output may re-enter
+static void witsensor_dejitter_release(t_witsensor_device *dev) {
+    witsensor_frame_t f = dev->held[dev->held_head];
+    dev->held_head = (dev->held_head + 1) % DEJITTER_HOLD;
+    dev->held_count--;
+    witsensor_deliver_frame(dev->owner, dev->index, &f);
+}
+
+// Deliver the held frames that are due and arm the clock for the next one
+static void witsensor_dejitter_tick(t_witsensor_device *dev) {
+    double now = clock_gettimesince(dev->dejitter_origin);
+    while (dev->held_count && dev->held_due[dev->held_head] <= now + 0.5) witsensor_dejitter_release(dev);
+    if (dev->held_count) clock_delay(dev->dejitter_clock, dev->held_due[dev->held_head] - now);
+}
+
+// Hold a timestamped frame until its place on the device clock, mapped to Pd
+// logical time. The BLE receive time is carried over by its age on the host
+// clock, so the clocks that schedule delivery and the one the envelope is
+// fitted on are the same.
+static void witsensor_dejitter_hold(t_witsensor_device *dev, const witsensor_frame_t *f) {
+    double now = clock_gettimesince(dev->dejitter_origin);
+    double age = (double)(witsensor_now_ns() - f->rx_ns) / 1e6;
+    double due = witsensor_dejitter_map(&dev->dejitter, f->timestamp, now - age);
+    if (due <= now) dev->late++;
+    // Full: the oldest goes out early rather than being lost
+    if (dev->held_count == DEJITTER_HOLD) witsensor_dejitter_release(dev);
+    int slot = (dev->held_head + dev->held_count) % DEJITTER_HOLD;
+    dev->held[slot] = *f;
+    dev->held_due[slot] = due;
+    dev->held_count++;
+    witsensor_dejitter_tick(dev);
+}
+
+// Deliver everything held right away
+static void witsensor_dejitter_flush(t_witsensor_device *dev) {
+    clock_unset(dev->dejitter_clock);
+    while (dev->held_count) witsensor_dejitter_release(dev);
 }
 
-// Handle queued output messages on Pd scheduler thread
-static void witsensor_pd_output_handler(t_pd *obj, void *data) {
-    if (!obj || !data) return;
+// Account a drained frame for link loss; a gap is reported ahead of the frame
+// that ends it: gap <ms> <estimated-lost>
+static void witsensor_loss_frame(t_witsensor *x, t_witsensor_device *dev, const witsensor_frame_t *f) {
+    double gap_ms;
+    unsigned int lost = witsensor_loss_check(&dev->loss, f, x->rate_hz > 0 ? 1000.0 / x->rate_hz : 0, &gap_ms);
+    if (!lost) return;
+    t_atom args[2];
+    SETFLOAT(&args[0], (t_float)gap_ms);
+    SETFLOAT(&args[1], (t_float)lost);
+    witsensor_device_out(x, x->status_out, dev->index, gensym("gap"), 2, args);
+}
+
+// Drain all queued streaming frames on Pd scheduler thread
+static void witsensor_pd_drain_handler(t_pd *obj, void *data) {
+    (void)data;
+    if (!obj) return; // cancelled by pd_queue_cancel
     t_witsensor *x = (t_witsensor *)obj;
-    t_queued_output *out = (t_queued_output *)data;
-    
-    if (out->msg == gensym("battery")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("temp")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("mag")) {
-        outlet_anything(x->data_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("quat")) {
-        witsensor_send_quaternion_data(x);
-    } else if (out->msg == gensym("streaming")) {
-        witsensor_send_sensor_data(x);
-    } else if (out->msg == gensym("version1")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("version2")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("time_yymm")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("time_ddh")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("time_mmss")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
-    } else if (out->msg == gensym("time_ms")) {
-        outlet_anything(x->status_out, out->msg, out->argc, out->argv);
+    // Re-arm before draining so frames pushed from now on schedule a new drain
+    atomic_store(&x->drain_pending, 0);
+    int tagged = x->device_count > 1;
+    int stride = FRAME_ATOMS + tagged; // batched frames carry the device index when tagged
+    int n = 0;
+    uint64_t now = witsensor_now_ns();
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        witsensor_register_t reg;
+        while (witsensor_register_ring_pop(&dev->registers, &reg)) witsensor_send_register(x, i, &reg);
+        witsensor_frame_t f;
+        if (x->coalesce == COALESCE_OFF) {
+            while (witsensor_ring_pop(&dev->frames, &f)) {
+                witsensor_loss_frame(x, dev, &f);
+                if (x->dejitter && (f.flags & WITSENSOR_FRAME_TIMESTAMP)) witsensor_dejitter_hold(dev, &f);
+                else witsensor_deliver_frame(x, i, &f);
+            }
+            continue;
+        }
+        // Coalesced: at most one ring's worth per device and drain; anything
+        // pushed after the re-arm above has already queued the next drain
+        int got = 0;
+        while (got < WITSENSOR_RING_CAPACITY && witsensor_ring_pop(&dev->frames, &f)) {
+            witsensor_loss_frame(x, dev, &f);
+            if (x->is_signal && i == 0) witsensor_signal_frame(x, &f);
+            if (x->coalesce == COALESCE_BATCH) {
+                witsensor_stats_frame(x, &f, now);
+                t_atom *at = &x->batch_atoms[1 + n * stride];
+                if (tagged) SETFLOAT(at++, (t_float)i);
+                witsensor_frame_to_atoms(&f, at);
+                n++;
+            }
+            got++;
+        }
+        if (got && x->coalesce == COALESCE_LATEST) {
+            witsensor_stats_frame(x, &f, now);
+            witsensor_send_sensor_data(x, i, &f);
+        }
     }
-    
-    free(out);
+    if (n) {
+        // One aggregated list per tick for all devices
+        SETFLOAT(&x->batch_atoms[0], (t_float)n);
+        outlet_anything(x->data_out, gensym("frames"), 1 + n * stride, x->batch_atoms);
+    }
+    // Slot due register reads right behind the notifications just drained
+    if (x->poll.count) witsensor_poll_service(x);
+}
+
+// Any slot waiting to get its lost link back
+static int witsensor_reconnecting(t_witsensor *x) {
+    for (int i = 0; i < x->device_count; i++) {
+        if (x->devices[i]->lost_ns) return 1;
+    }
+    return 0;
+}
+
+// Arm the next reconnect attempt: the first one at once, then with doubling delays
+static void witsensor_reconnect_schedule(t_witsensor_device *dev) {
+    clock_delay(dev->reconnect_clock, dev->backoff_ms);
+    dev->backoff_ms = dev->backoff_ms > 0 ? dev->backoff_ms * 2 : RECONNECT_FIRST_MS;
+    if (dev->backoff_ms > RECONNECT_MAX_MS) dev->backoff_ms = RECONNECT_MAX_MS;
+}
+
+// One reconnect attempt to the last target, straight to the cached peripheral
+static void witsensor_reconnect_tick(t_witsensor_device *dev) {
+    t_witsensor *x = dev->owner;
+    if (!dev->lost_ns || dev->is_connected || dev->connecting) return;
+    dev->attempts++;
+    t_atom a; SETFLOAT(&a, dev->attempts);
+    witsensor_device_out(x, x->status_out, dev->index, gensym("reconnecting"), 1, &a);
+    if (!witsensor_ble_simpleble_has_result(dev->ble_data, dev->link_target)) {
+        // Aged out of the scan cache: scan so the next advertisement brings it back
+        if (!witsensor_ble_simpleble_is_scanning(x->ble_data)) {
+            witsensor_ble_simpleble_start_scanning(x->ble_data);
+        }
+        witsensor_reconnect_schedule(dev);
+        return;
+    }
+    witsensor_parser_reset(&dev->parser);
+    dev->connecting = 1;
+    witsensor_ble_simpleble_connect_async(dev->ble_data, dev->link_target);
+}
+
+// Stop trying to restore a slot's link
+static void witsensor_reconnect_cancel(t_witsensor_device *dev) {
+    clock_unset(dev->reconnect_clock);
+    dev->lost_ns = 0;
+    dev->attempts = 0;
+    dev->backoff_ms = 0;
 }
 
-// Handle connection status changes on Pd scheduler thread
+// Free a queued link report
+static void witsensor_free_flag(t_queued_flag *flag) {
+    if (flag->target) free(flag->target);
+    if (flag->reason) free(flag->reason);
+    free(flag);
+}
+
+// Handle connection status changes on Pd scheduler thread: connecting <target>,
+// connected 1|0 and failed <target> from the BLE worker and disconnect callback
 void witsensor_pd_connected_handler(t_pd *obj, void *data) {
-    if (!obj || !data) return;
-    t_witsensor *x = (t_witsensor *)obj;
     t_queued_flag *flag = (t_queued_flag *)data;
+    if (!flag) return;
+    if (!obj) { // cancelled by pd_queue_cancel
+        witsensor_free_flag(flag);
+        return;
+    }
+    t_witsensor *x = (t_witsensor *)obj;
+    t_witsensor_device *dev = (flag->index >= 0 && flag->index < x->device_count) ? x->devices[flag->index] : NULL;
+    t_atom a;
+    SETSYMBOL(&a, gensym(flag->target ? flag->target : ""));
     
-    x->is_connected = flag->value;
+    switch (flag->value) {
+    case WITSENSOR_LINK_CONNECTING:
+        witsensor_device_out(x, x->status_out, flag->index, gensym("connecting"), 1, &a);
+        witsensor_free_flag(flag);
+        return;
+    case WITSENSOR_LINK_CONNECTED:
+        // Ignore if a disconnect was requested meanwhile; its own report follows
+        if (dev && dev->connecting) {
+            dev->connecting = 0;
+            if (flag->target) snprintf(dev->link_target, sizeof(dev->link_target), "%s", flag->target);
+            post("witsensor: connected to %s", flag->target ? flag->target : dev->name);
+            witsensor_slot_connected(x, dev);
+        }
+        witsensor_free_flag(flag);
+        return;
+    case WITSENSOR_LINK_FAILED:
+        if (dev && dev->connecting) {
+            dev->connecting = 0;
+            post("witsensor: %s", flag->reason ? flag->reason : "connect failed");
+            witsensor_device_out(x, x->status_out, flag->index, gensym("failed"), 1, &a);
+            if (dev->lost_ns) witsensor_reconnect_schedule(dev);
+            else witsensor_autoconnect(x, dev);
+        }
+        witsensor_free_flag(flag);
+        return;
+    default:
+        break;
+    }
     
-    t_atom a;
-    SETFLOAT(&a, flag->value);
-    outlet_anything(x->status_out, gensym("connected"), 1, &a);
+    if (dev) {
+        dev->is_connected = 0;
+        // Reads in flight died with the link: no resends, no timeouts
+        witsensor_pending_clear(&dev->pending);
+        clock_unset(dev->pending_clock);
+    }
+    x->is_connected = 0;
+    for (int i = 0; i < x->device_count; i++) x->is_connected |= x->devices[i]->is_connected;
+    
+    SETFLOAT(&a, 0);
+    witsensor_device_out(x, x->status_out, flag->index, gensym("connected"), 1, &a);
+
+    // Link lost without a disconnect request: start the reconnect gap
+    if (dev && dev->want_link && x->autoreconnect && !dev->lost_ns) {
+        post("witsensor: lost %s, reconnecting", dev->link_target);
+        dev->lost_ns = witsensor_now_ns();
+        dev->attempts = 0;
+        dev->backoff_ms = 0;
+        witsensor_reconnect_schedule(dev);
+    }
     
-    if (!flag->value) {
-        // Device disconnected - stop polling
-        if (x->poll_interval > 0) {
-            post("witsensor: device disconnected, stopping %s polling", 
-                 x->poll_type ? x->poll_type->s_name : "unknown");
-            x->poll_interval = 0;
-            x->poll_type = NULL;
+    if (!x->is_connected) {
+        witsensor_cmd_flush(x);
+        // Device disconnected - stop polling (kept while a link is being restored)
+        if (x->poll.count && !witsensor_reconnecting(x)) {
+            post("witsensor: device disconnected, stopping polling");
+            witsensor_poll_clear(&x->poll);
+            for (int i = 0; i < x->device_count; i++) witsensor_poll_clear(&x->devices[i]->poll);
+            clock_unset(x->poll_clock);
         }
     }
     
-    free(flag);
+    witsensor_free_flag(flag);
 }
 
 // Scan for WIT devices (continuous until stopped or connected)
@@ -621,13 +1088,6 @@ static void witsensor_scan_devices(t_witsensor *x) {
     
     // Reset scan results list
     witsensor_ble_simpleble_clear_scan_results(x->ble_data);
-    // Reset dedupe list
-    if (x->seen_ids) {
-        for (unsigned long i = 0; i < x->seen_count; i++) free(x->seen_ids[i]);
-        free(x->seen_ids);
-        x->seen_ids = NULL;
-        x->seen_count = 0;
-    }
     
     // Continuous scanning (no timeout needed)
     witsensor_ble_simpleble_start_scanning(x->ble_data);
@@ -639,108 +1099,264 @@ static void witsensor_get_scan_results(t_witsensor *x) {
     witsensor_ble_simpleble_get_scan_results(x->ble_data);
 }
 
-// Connect to device by name or address
-static void witsensor_connect(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
-    (void)s;
-    t_symbol *device_identifier = NULL;
-    if (argc > 0 && argv[0].a_type == A_SYMBOL) device_identifier = argv[0].a_w.w_symbol;
-    if (device_identifier && device_identifier->s_name) {
-        strcpy(x->device_name, device_identifier->s_name);
-    } else {
-        x->device_name[0] = '\0';
+// Allocate a device slot with its own BLE handle; scan results come from slot 0
+static t_witsensor_device *witsensor_device_new(t_witsensor *x) {
+    if (x->device_count >= MAX_PERIPHERALS) return NULL;
+    t_witsensor_device *dev = (t_witsensor_device *)getbytes(sizeof(t_witsensor_device));
+    if (!dev) return NULL;
+    dev->ble_data = witsensor_ble_simpleble_create();
+    if (!dev->ble_data) {
+        freebytes(dev, sizeof(t_witsensor_device));
+        return NULL;
     }
+    dev->owner = x;
+    dev->index = x->device_count;
+    dev->ble_data->pd_obj = x;
+    dev->ble_data->pd_instance = x->pd_instance;
+    dev->ble_data->data_callback = witsensor_ble_data_callback;
+    dev->ble_data->callback_data = dev;
+    dev->ble_data->tag = dev->index;
+    dev->reconnect_clock = clock_new(dev, (t_method)witsensor_reconnect_tick);
+    dev->dejitter_clock = clock_new(dev, (t_method)witsensor_dejitter_tick);
+    dev->dejitter_origin = clock_getlogicaltime();
+    dev->pending_clock = clock_new(dev, (t_method)witsensor_pending_tick);
+    if (dev->index > 0) dev->ble_data->scanner = x->devices[0]->ble_data;
+    witsensor_parser_init(&dev->parser);
+    dev->decode_mode = -1;       // kernel picked at the first batch
+    atomic_init(&dev->output_mode, 0);
+    witsensor_device_set_mode(dev, x->output_mode);
+    witsensor_poll_copy(&dev->poll, &x->poll, 0);
+    witsensor_pending_init(&dev->pending);
+    witsensor_pending_set_timeout(&dev->pending, x->read_timeout_ms, x->read_retries);
+    dev->reg_start = -1;
+    witsensor_snapshot_init(&dev->snapshot);
+    witsensor_ring_init(&dev->frames, dev->index > 0
+        ? (witsensor_overflow_t)atomic_load(&x->devices[0]->frames.overflow) : WITSENSOR_DROP_OLDEST);
+    witsensor_register_ring_init(&dev->registers);
+
+    // The batched 'frames' list holds every device ring plus a device index per frame
+    int size = 1 + (dev->index + 1) * WITSENSOR_RING_CAPACITY * (FRAME_ATOMS + 1);
+    t_atom *atoms = x->batch_atoms
+        ? (t_atom *)resizebytes(x->batch_atoms, sizeof(t_atom) * x->batch_size, sizeof(t_atom) * size)
+        : (t_atom *)getbytes(sizeof(t_atom) * size);
+    if (!atoms) {
+        witsensor_ble_simpleble_destroy(dev->ble_data);
+        clock_free(dev->reconnect_clock);
+        clock_free(dev->dejitter_clock);
+        clock_free(dev->pending_clock);
+        freebytes(dev, sizeof(t_witsensor_device));
+        return NULL;
+    }
+    x->batch_atoms = atoms;
+    x->batch_size = size;
+    x->devices[x->device_count++] = dev;
+    return dev;
+}
+
+// Slot for the next connect: the first idle one, else a new one
+static t_witsensor_device *witsensor_idle_slot(t_witsensor *x) {
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if (!dev->is_connected && !dev->connecting && !dev->pending_target && !dev->lost_ns) return dev;
+    }
+    t_witsensor_device *dev = witsensor_device_new(x);
+    if (!dev) post("witsensor: at most %d devices per object", MAX_PERIPHERALS);
+    return dev;
+}
+
+// Connect one device slot to a target (empty: strongest free WIT device in the
+// scan results). Targets in the results are connected on the BLE worker, others
+// are waited for with an autoconnect scan.
+static void witsensor_connect_slot(t_witsensor *x, t_witsensor_device *dev, const char *target) {
+    snprintf(dev->name, sizeof(dev->name), "%s", target ? target : "");
+    post("witsensor: connecting to device: %s", dev->name);
     
-    post("witsensor: connecting to device: %s", x->device_name);
-    
-    // If already connected, do nothing to avoid surprising implicit disconnects
-    if (x->is_connected) {
-        post("witsensor: already connected; disconnect first to connect to a new device");
-        x->pending_target = NULL; // cancel any pending autoconnect
+    // Not connected, so no notifications arrive: safe to drop a stale partial frame
+    witsensor_parser_reset(&dev->parser);
+    char addr[64] = "";
+    if (dev->name[0]) {
+        if (witsensor_ble_simpleble_has_result(dev->ble_data, dev->name)) {
+            snprintf(addr, sizeof(addr), "%s", dev->name);
+        }
+    } else {
+        witsensor_ble_simpleble_pick_wit(dev->ble_data, addr, sizeof(addr));
+    }
+    if (!addr[0]) {
+        witsensor_autoconnect(x, dev);
         return;
     }
+    dev->connecting = 1;
+    dev->pending_target = NULL;
+    witsensor_ble_simpleble_connect_async(dev->ble_data, dev->name[0] ? dev->name : addr);
+}
 
-    if (x->ble_data) {
-        int connected = 0;
-        if (x->device_name[0]) {
-            // Try immediate targeted connect
-            connected = witsensor_ble_simpleble_connect(x->ble_data, x->device_name);
-        } else {
-            // No target specified: try current cached results for first WIT device
-            if (x->ble_data->cached_ids && x->ble_data->cached_count > 0) {
-                for (unsigned long i = 0; i < x->ble_data->cached_count; i++) {
-                    const char *id = x->ble_data->cached_ids[i];
-                    if (id && strstr(id, "WT") != NULL) {
-                        connected = witsensor_ble_simpleble_connect(x->ble_data, id);
-                        if (connected) break;
-                    }
-                }
-            }
-        }
-        
-        if (connected) {
-            x->is_connected = 1;
-            // Clear pending autoconnect since we achieved a connection
-            x->pending_target = NULL;
-            t_atom a; SETFLOAT(&a, 1);
-            outlet_anything(x->status_out, gensym("connected"), 1, &a);
-            // On-connect configuration: set desired streaming/output mode consistently for Pd usage
-            unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-            witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
-            usleep(50000);
-            // Axis: 9-axis (reg 0x24, code 0x00)
-            unsigned char cmd_axis9[] = {0xFF, 0xAA, 0x24, 0x00, 0x00};
-            witsensor_ble_simpleble_write_data(x->ble_data, cmd_axis9, sizeof(cmd_axis9));
-            x->axis_mode = 9;
-            t_atom ax; SETFLOAT(&ax, 9);
-            outlet_anything(x->status_out, gensym("axis"), 1, &ax);
-            usleep(30000);
-            // Output mode (AGPVSEL, reg 0x96): 0 = accel+gyro+angle
-            unsigned char cmd_outmode0[] = {0xFF, 0xAA, 0x96, 0x00, 0x00};
-            witsensor_ble_simpleble_write_data(x->ble_data, cmd_outmode0, sizeof(cmd_outmode0));
-            x->output_mode = 0;
-            t_atom om; SETFLOAT(&om, 0);
-            outlet_anything(x->status_out, gensym("outputmode"), 1, &om);
-            usleep(30000);
-            // Default stream rate 50 Hz
-            unsigned char cmd_rate[] = {0xFF, 0xAA, 0x03, 0x08, 0x00};
-            witsensor_ble_simpleble_write_data(x->ble_data, cmd_rate, sizeof(cmd_rate));
-            t_atom rate_args[2];
-            SETFLOAT(&rate_args[0], 50.0f);
-            SETFLOAT(&rate_args[1], 0x08);
-            outlet_anything(x->status_out, gensym("rate"), 2, rate_args);
-            usleep(30000);
-             // bandwidth 256 Hz
-            unsigned char cmd_bw[] = {0xFF, 0xAA, 0x1F, 0x00, 0x00};
-            witsensor_ble_simpleble_write_data(x->ble_data, cmd_bw, sizeof(cmd_bw));
-            t_atom bw; SETFLOAT(&bw, 256.0f);
-            outlet_anything(x->status_out, gensym("bandwidth"), 1, &bw);
-            x->poll_interval = 0;
-        } else {
-            post("witsensor: starting autoconnect...");
-            x->pending_target = gensym(x->device_name[0] ? x->device_name : "*");
-            if (!witsensor_ble_simpleble_is_scanning(x->ble_data)) {
-                witsensor_ble_simpleble_start_scanning(x->ble_data);
-            }
+// Wait for the slot's target (or any WIT device) to show up in the scan
+static void witsensor_autoconnect(t_witsensor *x, t_witsensor_device *dev) {
+    post("witsensor: starting autoconnect...");
+    dev->pending_target = gensym(dev->name[0] ? dev->name : "*");
+    if (!witsensor_ble_simpleble_is_scanning(x->ble_data)) {
+        witsensor_ble_simpleble_start_scanning(x->ble_data);
+    }
+}
+
+// The BLE worker connected a slot (notifications already armed): announce it
+// and configure the device. The first slot connected applies the defaults;
+// further slots and restored links get the tracked configuration, and a
+// restored link reports the gap.
+static void witsensor_slot_connected(t_witsensor *x, t_witsensor_device *dev) {
+    int resumed = dev->lost_ns != 0;
+    int others = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        if (x->devices[i] != dev && x->devices[i]->is_connected) others = 1;
+    }
+    dev->is_connected = 1;
+    // The sensor may have restarted its clock; loss is counted per connection
+    witsensor_dejitter_init(&dev->dejitter);
+    witsensor_loss_init(&dev->loss);
+    dev->want_link = 1;
+    x->is_connected = 1;
+    // Clear pending autoconnect since we achieved a connection
+    dev->pending_target = NULL;
+    t_atom a; SETFLOAT(&a, 1);
+    witsensor_device_out(x, x->status_out, dev->index, gensym("connected"), 1, &a);
+    if (resumed) {
+        t_atom gap[2];
+        SETFLOAT(&gap[0], (t_float)((witsensor_now_ns() - dev->lost_ns) / 1e6));
+        SETFLOAT(&gap[1], dev->attempts);
+        post("witsensor: %s back after %.0f ms (%d attempts)", dev->link_target, atom_getfloat(gap), dev->attempts);
+        witsensor_device_out(x, x->status_out, dev->index, gensym("reconnected"), 2, gap);
+        witsensor_reconnect_cancel(dev);
+    } else if (!others) {
+        // Desired streaming/output mode for Pd usage
+        x->axis_mode = 9;          // reg 0x24, code 0x00
+        x->output_mode = 0;        // AGPVSEL, reg 0x96: 0 = accel+gyro+angle
+        x->rate_hz = 50.0f;        // reg 0x03, code 0x08
+        x->rate_code = 0x08;
+        x->bw_hz = 256.0f;         // reg 0x1F, code 0x00
+        x->bw_code = 0x00;
+        witsensor_ahrs_publish(x);
+    }
+    witsensor_device_set_mode(dev, x->output_mode);
+    witsensor_record_info(x);
+    witsensor_poll_copy(&dev->poll, &x->poll, (double)witsensor_now_ns() / 1e6);
+    witsensor_pending_clear(&dev->pending);
+    clock_unset(dev->pending_clock);
+    witsensor_poll_service(x);
+    // On-connect configuration of this device
+    // (queued; each status message is emitted once its write went out)
+    x->cmd_target = dev->index;
+    t_symbol *seq = gensym(resumed ? "reconnect" : "connect");
+    unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, seq, cmd_unlock, sizeof(cmd_unlock), 50);
+    unsigned char cmd_axis[] = {0xFF, 0xAA, 0x24, (unsigned char)(x->axis_mode == 9 ? 0x00 : 0x01), 0x00};
+    t_atom ax; SETFLOAT(&ax, x->axis_mode);
+    witsensor_cmd_status(witsensor_cmd_push(x, seq, cmd_axis, sizeof(cmd_axis), 30), gensym("axis"), 1, &ax);
+    unsigned char cmd_outmode[] = {0xFF, 0xAA, 0x96, (unsigned char)x->output_mode, 0x00};
+    t_atom om; SETFLOAT(&om, x->output_mode);
+    witsensor_cmd_status(witsensor_cmd_push(x, seq, cmd_outmode, sizeof(cmd_outmode), 30), gensym("outputmode"), 1, &om);
+    unsigned char cmd_rate[] = {0xFF, 0xAA, 0x03, x->rate_code, 0x00};
+    t_atom rate_args[2];
+    SETFLOAT(&rate_args[0], x->rate_hz);
+    SETFLOAT(&rate_args[1], x->rate_code);
+    witsensor_cmd_status(witsensor_cmd_push(x, seq, cmd_rate, sizeof(cmd_rate), 30), gensym("rate"), 2, rate_args);
+    unsigned char cmd_bw[] = {0xFF, 0xAA, 0x1F, x->bw_code, 0x00};
+    t_atom bw; SETFLOAT(&bw, x->bw_hz);
+    witsensor_cmd_status(witsensor_cmd_push(x, seq, cmd_bw, sizeof(cmd_bw), 0), gensym("bandwidth"), 1, &bw);
+    x->cmd_target = -1;
+    // Connecting stops the scan; keep it going for slots still waiting
+    for (int i = 0; i < x->device_count; i++) {
+        if (x->devices[i]->pending_target && !witsensor_ble_simpleble_is_scanning(x->ble_data)) {
+            witsensor_ble_simpleble_start_scanning(x->ble_data);
         }
-        return;
-    } else {
+    }
+}
+
+// Connect to devices by name or address: connect [<target> ...]
+// Each target gets its own device slot; without targets the first WIT device is used
+static void witsensor_connect(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (!x->ble_data) {
         post("witsensor: BLE not initialized");
+        return;
+    }
+    if (x->replay) {
+        post("witsensor: replay running - replay stop first");
+        return;
+    }
+    int targets = 0;
+    for (int i = 0; i < argc; i++) {
+        if (argv[i].a_type != A_SYMBOL || !argv[i].a_w.w_symbol->s_name[0]) continue;
+        t_witsensor_device *dev = witsensor_idle_slot(x);
+        if (!dev) return;
+        witsensor_connect_slot(x, dev, argv[i].a_w.w_symbol->s_name);
+        targets++;
+    }
+    if (!targets) {
+        t_witsensor_device *dev = witsensor_idle_slot(x);
+        if (dev) witsensor_connect_slot(x, dev, NULL);
     }
 }
 
-// Disconnect from device
-static void witsensor_disconnect(t_witsensor *x) {
-    if (!x->is_connected) {
+// Disconnect one device slot
+static void witsensor_disconnect_slot(t_witsensor *x, t_witsensor_device *dev) {
+    // Cancel any pending autoconnect so subsequent 'results' won't reconnect implicitly
+    dev->pending_target = NULL;
+    dev->want_link = 0;
+    witsensor_reconnect_cancel(dev);
+    if (!dev->is_connected && !dev->connecting) return;
+    // Runs after a connect still in progress; 'connected 0' reports the result
+    witsensor_ble_simpleble_disconnect_async(dev->ble_data);
+    dev->is_connected = 0;
+    dev->connecting = 0;
+    witsensor_pending_clear(&dev->pending);
+    clock_unset(dev->pending_clock);
+    x->is_connected = 0;
+    for (int i = 0; i < x->device_count; i++) x->is_connected |= x->devices[i]->is_connected;
+    if (!x->is_connected) witsensor_cmd_flush(x);
+}
+
+// Disconnect: all devices, or disconnect <index> for one slot
+static void witsensor_disconnect(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (argc > 0 && argv[0].a_type == A_FLOAT) {
+        int index = (int)atom_getfloat(argv);
+        if (index < 0 || index >= x->device_count) {
+            post("witsensor: no device %d", index);
+            return;
+        }
+        if (!x->devices[index]->is_connected && !x->devices[index]->connecting) {
+            post("witsensor: device %d not connected", index);
+        }
+        witsensor_disconnect_slot(x, x->devices[index]);
+        return;
+    }
+    int busy = x->is_connected;
+    for (int i = 0; i < x->device_count; i++) busy |= x->devices[i]->connecting;
+    if (!busy) {
         post("witsensor: no device connected");
+        for (int i = 0; i < x->device_count; i++) x->devices[i]->pending_target = NULL;
         return;
     }
-    
-    if (x->ble_data) {
-        // Cancel any pending autoconnect so subsequent 'results' won't reconnect implicitly
-        x->pending_target = NULL;
-        witsensor_ble_simpleble_disconnect(x->ble_data);
-        x->should_stop = 1;
+    for (int i = 0; i < x->device_count; i++) witsensor_disconnect_slot(x, x->devices[i]);
+}
+
+// mock <setting> <value>: tune the simulated sensors of the mock BLE backend
+// (witsensor_ble_mock.h), e.g. mock devices 200, mock loss 0.02, mock drop
+static void witsensor_mock(t_witsensor *x, t_symbol *key, t_float value) {
+    (void)x;
+    if (!witsensor_ble_mock_set(key->s_name, value)) post("witsensor: unknown mock setting %s", key->s_name);
+}
+
+// autoreconnect 0|1: restore links lost without 'disconnect', retrying with
+// doubling delays and re-applying axis, output mode, rate and bandwidth
+static void witsensor_autoreconnect(t_witsensor *x, t_float f) {
+    x->autoreconnect = f != 0;
+    if (!x->autoreconnect) {
+        for (int i = 0; i < x->device_count; i++) witsensor_reconnect_cancel(x->devices[i]);
     }
+    t_atom a; SETFLOAT(&a, x->autoreconnect);
+    outlet_anything(x->status_out, gensym("autoreconnect"), 1, &a);
 }
 
 // Set streaming rate (in Hz)
@@ -751,7 +1367,8 @@ static void witsensor_set_rate(t_witsensor *x, t_float rate) {
     if (x->is_connected && x->ble_data) {
         // Unlock sensor first
         unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5}; // Unlock command
-        witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
+        witsensor_cmd_begin(x);
+        witsensor_cmd_push(x, gensym("rate"), cmd_unlock, sizeof(cmd_unlock), 0);
         
         unsigned char rate_code;
         if (rate <= 0.15f) rate_code = 0x01; // 0.1 Hz
@@ -768,12 +1385,14 @@ static void witsensor_set_rate(t_witsensor *x, t_float rate) {
         // Unlock and send rate immediately
         // Small spacing; sensor accepts back-to-back frames over BLE without blocking main thread
         unsigned char cmd_rate[] = {0xFF, 0xAA, 0x03, rate_code, 0x00};
-        witsensor_ble_simpleble_write_data(x->ble_data, cmd_rate, sizeof(cmd_rate));
-
         t_atom args[2];
         SETFLOAT(&args[0], rate);
         SETFLOAT(&args[1], rate_code);
-        outlet_anything(x->status_out, gensym("rate"), 2, args);
+        x->rate_hz = rate;
+        x->rate_code = rate_code;
+        witsensor_ahrs_publish(x);
+        witsensor_record_info(x);
+        witsensor_cmd_status(witsensor_cmd_push(x, gensym("rate"), cmd_rate, sizeof(cmd_rate), 0), gensym("rate"), 2, args);
     } else {
         post("witsensor: not connected to device");
     }
@@ -790,80 +1409,89 @@ static void witsensor_set_bandwidth(t_witsensor *x, t_float hz) {
     else if (hz >= 15.0f) bw_code = 0x04; // 20 Hz
     else if (hz >= 7.0f) bw_code = 0x05; // 10 Hz
     else bw_code = 0x06; // 5 Hz
+    t_symbol *seq = gensym("bandwidth");
     unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
-    usleep(50000);
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, seq, cmd_unlock, sizeof(cmd_unlock), 50);
     unsigned char cmd_bw[] = {0xFF, 0xAA, 0x1F, bw_code, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_bw, sizeof(cmd_bw));
-    
+    x->bw_hz = hz;
+    x->bw_code = bw_code;
     t_atom a; SETFLOAT(&a, hz);
-    outlet_anything(x->status_out, gensym("bandwidth"), 1, &a);
+    witsensor_cmd_status(witsensor_cmd_push(x, seq, cmd_bw, sizeof(cmd_bw), 0), gensym("bandwidth"), 1, &a);
 }
 
 // Battery request: FF AA 27 64 00
 static void witsensor_battery(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     
-    // Note: Battery requests may be unreliable with active streaming
-    // Users should pause streaming (rate 0) before requesting battery data
+    // Single read; while streaming, 'poll' spaces repeated reads out between notifications
     unsigned char cmd[] = {0xFF, 0xAA, 0x27, 0x64, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 // Request temperature data: FF AA 27 40 00
 static void witsensor_temp(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     
-    // Note: Temperature requests may be unreliable with active streaming
-    // Users should pause streaming (rate 0) before requesting temperature data
+    // Single read; while streaming, 'poll' spaces repeated reads out between notifications
     unsigned char cmd[] = {0xFF, 0xAA, 0x27, 0x40, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 // Request magnetic field data: FF AA 27 3A 00
 static void witsensor_mag(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     
-    // Note: Magnetic field requests may be unreliable with active streaming
-    // Users should pause streaming (rate 0) before requesting magnetic field data
+    // Single read; while streaming, 'poll' spaces repeated reads out between notifications
     unsigned char cmd[] = {0xFF, 0xAA, 0x27, 0x3A, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 // Request quaternion data: FF AA 27 51 00
 static void witsensor_quat(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     
-    // Note: Quaternion requests may be unreliable with active streaming
-    // Users should pause streaming (rate 0) before requesting quaternion data
+    // Single read; while streaming, 'poll' spaces repeated reads out between notifications
     unsigned char cmd[] = {0xFF, 0xAA, 0x27, 0x51, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
-// Read firmware version registers 0x2E and 0x2F
+// Read firmware version 0x2E..0x2F in one response: version <v1> <v2>
 static void witsensor_read_version(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
-    unsigned char cmd1[] = {0xFF, 0xAA, 0x27, 0x2E, 0x00};
-    unsigned char cmd2[] = {0xFF, 0xAA, 0x27, 0x2F, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd1, sizeof(cmd1));
-    usleep(60000);
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd2, sizeof(cmd2));
+    unsigned char cmd[] = {0xFF, 0xAA, 0x27, 0x2E, 0x00};
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, gensym("version"), cmd, sizeof(cmd), 0);
 }
 
-// Read device time registers 0x30..0x33
+// Read device time 0x30..0x33 in one response: time yy mm dd hh mm ss ms
 static void witsensor_read_time(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
-    unsigned char c30[] = {0xFF, 0xAA, 0x27, 0x30, 0x00};
-    unsigned char c31[] = {0xFF, 0xAA, 0x27, 0x31, 0x00};
-    unsigned char c32[] = {0xFF, 0xAA, 0x27, 0x32, 0x00};
-    unsigned char c33[] = {0xFF, 0xAA, 0x27, 0x33, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, c30, sizeof(c30));
-    usleep(60000);
-    witsensor_ble_simpleble_write_data(x->ble_data, c31, sizeof(c31));
-    usleep(60000);
-    witsensor_ble_simpleble_write_data(x->ble_data, c32, sizeof(c32));
-    usleep(60000);
-    witsensor_ble_simpleble_write_data(x->ble_data, c33, sizeof(c33));
+    unsigned char cmd[] = {0xFF, 0xAA, 0x27, 0x30, 0x00};
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, gensym("time"), cmd, sizeof(cmd), 0);
+}
+
+// Range read: read <register> [count], one 0x27 read per 8 registers.
+// Rows of the decoder table come out under their own selector, any other
+// span as reg <start> <w0> .. <w7>
+static void witsensor_read(t_witsensor *x, t_floatarg reg, t_floatarg count) {
+    if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
+    int start = (int)reg;
+    int n = count >= 1 ? (int)count : WITSENSOR_REGISTER_MAX_WORDS;
+    if (start < 0 || start > 0xFF) {
+        post("witsensor: read needs a register 0..255");
+        return;
+    }
+    if (start + n > 0x100) n = 0x100 - start;
+    t_symbol *seq = gensym("read");
+    witsensor_cmd_begin(x);
+    for (int r = start; r < start + n; r += WITSENSOR_REGISTER_MAX_WORDS) {
+        unsigned char cmd[] = {0xFF, 0xAA, 0x27, (unsigned char)r, 0x00};
+        int last = r + WITSENSOR_REGISTER_MAX_WORDS >= start + n;
+        t_witsensor_cmd *entry = witsensor_cmd_push(x, seq, cmd, sizeof(cmd), last ? 0 : 60);
+        if (entry) entry->span = (unsigned char)(last ? start + n - r : WITSENSOR_REGISTER_MAX_WORDS);
+    }
 }
 
 // Clear cached scan results (Pd message: reset)
@@ -874,19 +1502,13 @@ static void witsensor_reset(t_witsensor *x) {
         witsensor_ble_simpleble_stop_scanning(x->ble_data);
     }
     witsensor_ble_simpleble_clear_scan_results(x->ble_data);
-    if (x->seen_ids) {
-        for (unsigned long i = 0; i < x->seen_count; i++) free(x->seen_ids[i]);
-        free(x->seen_ids);
-        x->seen_ids = NULL;
-        x->seen_count = 0;
-    }
 }
 
 // Set angle reference (zero): FF AA 01 08 00
 static void witsensor_xyzero(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     unsigned char cmd[] = {0xFF, 0xAA, 0x01, 0x08, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 
@@ -895,7 +1517,7 @@ static void witsensor_set_orientation(t_witsensor *x, t_float f) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     int orient = (int)f; if (orient < 0) orient = 0; if (orient > 1) orient = 1;
     unsigned char cmd[] = {0xFF, 0xAA, 0x23, (unsigned char)orient, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 // Set output content (AGPVS): FF AA 96 <0..3> 00
@@ -903,12 +1525,16 @@ static void witsensor_set_output_mode(t_witsensor *x, t_float f) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     int mode = (int)f; if (mode < 0) mode = 0; if (mode > 3) mode = 3;
     unsigned char cmd[] = {0xFF, 0xAA, 0x96, (unsigned char)mode, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
     x->output_mode = mode;
+    witsensor_record_info(x);
     t_atom a; SETFLOAT(&a, mode);
     outlet_anything(x->status_out, gensym("outputmode"), 1, &a);
-    x->use_disp_speed = (mode & 1);
-    x->use_timestamp = ((mode >> 1) & 1);
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if (!dev->is_connected) continue;
+        witsensor_device_set_mode(dev, mode);
+    }
 }
 
 // Set baud rate: FF AA 04 <0..255> 00
@@ -917,7 +1543,7 @@ static void witsensor_set_baud(t_witsensor *x, t_float f) {
     int baud = (int)f; if (baud < 0) baud = 0; if (baud > 255) baud = 255;
     post("witsensor: setting baud rate to %d", baud);
     unsigned char cmd[] = {0xFF, 0xAA, 0x04, (unsigned char)baud, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 // Save configuration: FF AA 00 00 00
@@ -925,7 +1551,7 @@ static void witsensor_save(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     post("witsensor: saving configuration");
     unsigned char cmd[] = {0xFF, 0xAA, 0x00, 0x00, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_write(x, -1, cmd, sizeof(cmd), 0);
 }
 
 // Restore configuration: FF AA 00 01 00
@@ -936,7 +1562,7 @@ static void witsensor_restore(t_witsensor *x) {
     }
     
     unsigned char cmd[] = {0xFF, 0xAA, 0x00, 0x01, 0x00};
-    int result = witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    int result = witsensor_write(x, -1, cmd, sizeof(cmd), 0);
     
     if (!result) {
         post("witsensor: failed to send restore command");
@@ -945,53 +1571,608 @@ static void witsensor_restore(t_witsensor *x) {
     }
 }
 
-// Unified polling method: poll <type> <interval>
-// Examples: poll quat 10, poll mag 5, poll battery 1, poll temp 2
-static void witsensor_poll(t_witsensor *x, t_symbol *type, t_float interval) {
-    if (!type) {
-        post("witsensor: poll requires a type (quat, mag, battery, temp)");
-        return;
-    }
-    
-    // Validate type
-    if (type != gensym("quat") && type != gensym("mag") && 
-        type != gensym("battery") && type != gensym("temp")) {
-        post("witsensor: poll type must be one of: quat, mag, battery, temp");
+// Register polling, several groups at once, each at its own rate:
+//   poll <register> <hz>   add or change a group (quat, mag, battery, temp or any
+//                          selector of witsensor_registers), 0 Hz removes it
+//   poll budget <reads/s>  per-device cap on reads, shared by all groups
+//   poll stop              remove every group
+//   poll                   report poll <register> <hz> <sent> <answered> <missed> per device
+// Reads are slotted between streaming notifications and each 0x71 response is
+// matched to its read, so groups run alongside the stream without pausing it
+static void witsensor_poll(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    double now = (double)witsensor_now_ns() / 1e6;
+    if (argc == 0) {
+        for (int i = 0; i < x->device_count; i++) {
+            witsensor_poll_t *poll = &x->devices[i]->poll;
+            for (int g = 0; g < poll->count; g++) {
+                witsensor_poll_group_t *group = &poll->groups[g];
+                int row = 0;
+                while (row < witsensor_register_count && witsensor_registers[row].addr != group->reg) row++;
+                t_atom args[5];
+                SETSYMBOL(&args[0], row < witsensor_register_count ? witsensor_register_syms[row] : gensym("?"));
+                SETFLOAT(&args[1], (t_float)(1000.0 / group->period_ms));
+                SETFLOAT(&args[2], (t_float)group->sent);
+                SETFLOAT(&args[3], (t_float)group->answered);
+                SETFLOAT(&args[4], (t_float)group->missed);
+                witsensor_device_out(x, x->status_out, i, gensym("poll"), 5, args);
+            }
+        }
         return;
     }
-    
-    // Stop current polling if interval is 0 or negative
-    if (interval <= 0) {
-        x->poll_interval = 0;
-        x->poll_type = NULL;
-        // Stop the polling clock - streaming data has its own separate clock
+    t_symbol *type = atom_getsymbol(argv);
+    t_float value = argc > 1 ? atom_getfloat(argv + 1) : 0;
+    if (type == gensym("stop") || type == gensym("off")) {
+        witsensor_poll_clear(&x->poll);
+        for (int i = 0; i < x->device_count; i++) witsensor_poll_clear(&x->devices[i]->poll);
         clock_unset(x->poll_clock);
         outlet_anything(x->status_out, gensym("poll"), 0, NULL);
         return;
     }
-    
-    // Cap at 50 Hz to avoid BLE congestion
-    if (interval > 50.0f) interval = 50.0f;
-    int period_ms = (int)(1000.0f / interval);
-    if (period_ms < 1) period_ms = 1;
-    
-    x->poll_interval = period_ms;
-    x->poll_type = type;
-    
-    if (x->is_connected) {
-        clock_unset(x->poll_clock);
-        clock_delay(x->poll_clock, x->poll_interval);
-        t_atom args[3];
+    if (type == gensym("budget")) {
+        if (value <= 0) {
+            post("witsensor: poll budget needs a rate in reads per second");
+            return;
+        }
+        witsensor_poll_set_budget(&x->poll, value);
+        for (int i = 0; i < x->device_count; i++) witsensor_poll_set_budget(&x->devices[i]->poll, value);
+        t_atom args[2];
         SETSYMBOL(&args[0], type);
-        SETFLOAT(&args[1], 1000.0f / x->poll_interval);
-        SETFLOAT(&args[2], x->poll_interval);
-        outlet_anything(x->status_out, gensym("poll"), 3, args);
+        SETFLOAT(&args[1], value);
+        outlet_anything(x->status_out, gensym("poll"), 2, args);
+        return;
+    }
+
+    // Validate type: any register of the decoder table
+    int row = -1;
+    for (int i = 0; i < witsensor_register_count && row < 0; i++) {
+        if (witsensor_register_syms[i] == type && !(witsensor_registers[i].flags & WITSENSOR_REGISTER_RAW)) row = i;
+    }
+    if (row < 0) {
+        post("witsensor: poll type must be one of: quat, mag, battery, temp (or stop, budget)");
+        return;
+    }
+    unsigned char reg = witsensor_registers[row].addr;
+    if (value > WITSENSOR_POLL_MAX_HZ) value = WITSENSOR_POLL_MAX_HZ;
+    if (!witsensor_poll_set(&x->poll, reg, value, now)) {
+        post("witsensor: at most %d poll groups", WITSENSOR_POLL_GROUPS);
+        return;
     }
+    for (int i = 0; i < x->device_count; i++) witsensor_poll_set(&x->devices[i]->poll, reg, value, now);
+    t_atom args[3];
+    SETSYMBOL(&args[0], type);
+    SETFLOAT(&args[1], value > 0 ? value : 0);
+    SETFLOAT(&args[2], value > 0 ? 1000.0f / value : 0);
+    outlet_anything(x->status_out, gensym("poll"), 3, args);
+    witsensor_poll_service(x);
 }
 
-// Constructor
-static void *witsensor_new(void) {
-    t_witsensor *x = (t_witsensor *)pd_new(witsensor_class);
+// Register read round trips:
+//   rtt                          per device: rtt <last-ms> <mean-ms> <max-ms> <answered>
+//                                <resent> <timeouts> <late> <outstanding>, then a new window
+//   rtt timeout <ms> [resends]   wait for a 0x71 answer this long, resend this often
+static void witsensor_rtt(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (argc > 0 && atom_getsymbol(argv) == gensym("timeout")) {
+        t_float ms = argc > 1 ? atom_getfloat(argv + 1) : 0;
+        if (ms <= 0) {
+            post("witsensor: rtt timeout needs a time in ms");
+            return;
+        }
+        x->read_timeout_ms = ms;
+        if (argc > 2) {
+            int retries = (int)atom_getfloat(argv + 2);
+            x->read_retries = retries < 0 ? 0
+                : retries > WITSENSOR_PENDING_MAX_RETRIES ? WITSENSOR_PENDING_MAX_RETRIES : retries;
+        }
+        for (int i = 0; i < x->device_count; i++) {
+            witsensor_pending_set_timeout(&x->devices[i]->pending, x->read_timeout_ms, x->read_retries);
+        }
+        t_atom args[3];
+        SETSYMBOL(&args[0], gensym("timeout"));
+        SETFLOAT(&args[1], x->read_timeout_ms);
+        SETFLOAT(&args[2], (t_float)x->read_retries);
+        outlet_anything(x->status_out, gensym("rtt"), 3, args);
+        return;
+    }
+    for (int i = 0; i < x->device_count; i++) {
+        witsensor_pending_t *p = &x->devices[i]->pending;
+        t_atom args[8];
+        SETFLOAT(&args[0], (t_float)p->rtt_last_ms);
+        SETFLOAT(&args[1], p->answered ? (t_float)(p->rtt_sum_ms / (double)p->answered) : 0);
+        SETFLOAT(&args[2], (t_float)p->rtt_max_ms);
+        SETFLOAT(&args[3], (t_float)p->answered);
+        SETFLOAT(&args[4], (t_float)p->retried);
+        SETFLOAT(&args[5], (t_float)p->timeouts);
+        SETFLOAT(&args[6], (t_float)p->late);
+        SETFLOAT(&args[7], (t_float)p->count);
+        witsensor_device_out(x, x->status_out, i, gensym("rtt"), 8, args);
+        witsensor_pending_reset_stats(p);
+    }
+}
+
+// Select what happens when the frame queue is full: overflow oldest|newest
+static void witsensor_overflow(t_witsensor *x, t_symbol *policy) {
+    witsensor_overflow_t mode;
+    if (policy == gensym("oldest")) {
+        mode = WITSENSOR_DROP_OLDEST;
+    } else if (policy == gensym("newest")) {
+        mode = WITSENSOR_DROP_NEWEST;
+    } else {
+        post("witsensor: overflow policy must be one of: oldest, newest");
+        return;
+    }
+    for (int i = 0; i < x->device_count; i++) witsensor_ring_set_overflow(&x->devices[i]->frames, mode);
+    t_atom a; SETSYMBOL(&a, policy);
+    outlet_anything(x->status_out, gensym("overflow"), 1, &a);
+}
+
+// Report frame queue state per device: queue <depth> <capacity> <received> <dropped> <high-water>
+static void witsensor_queue(t_witsensor *x) {
+    for (int i = 0; i < x->device_count; i++) {
+        witsensor_ring_t *frames = &x->devices[i]->frames;
+        t_atom args[5];
+        SETFLOAT(&args[0], (t_float)witsensor_ring_depth(frames));
+        SETFLOAT(&args[1], (t_float)WITSENSOR_RING_CAPACITY);
+        SETFLOAT(&args[2], (t_float)atomic_load(&frames->pushed));
+        SETFLOAT(&args[3], (t_float)atomic_load(&frames->dropped));
+        SETFLOAT(&args[4], (t_float)atomic_load(&frames->high_water));
+        witsensor_device_out(x, x->status_out, i, gensym("queue"), 5, args);
+    }
+}
+
+// Output each device's newest frame and quaternion, then latest <seq> <age-ms>
+static void witsensor_latest(t_witsensor *x) {
+    int any = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        witsensor_state_t st;
+        witsensor_snapshot_read(&x->devices[i]->snapshot, &st);
+        if (!st.frame.rx_ns) continue;
+        any = 1;
+        witsensor_send_sensor_data(x, i, &st.frame);
+        // A fused quaternion came out with the frame; else the last register read
+        if (st.quat_rx_ns && !(st.frame.flags & WITSENSOR_FRAME_QUAT)) {
+            t_atom q[4];
+            for (int j = 0; j < 4; j++) SETFLOAT(&q[j], st.quat[j]);
+            witsensor_device_out(x, x->data_out, i, gensym("quat"), 4, q);
+        }
+        t_atom args[2];
+        SETFLOAT(&args[0], (t_float)st.frame.seq);
+        SETFLOAT(&args[1], (t_float)((double)(witsensor_now_ns() - st.frame.rx_ns) / 1e6));
+        witsensor_device_out(x, x->status_out, i, gensym("latest"), 2, args);
+    }
+    if (!any) post("witsensor: no frame received yet");
+}
+
+// Report frame reassembly per device: parser <frames> <resyncs> <skipped-bytes>
+static void witsensor_parser(t_witsensor *x) {
+    for (int i = 0; i < x->device_count; i++) {
+        witsensor_parser_t *parser = &x->devices[i]->parser;
+        t_atom args[3];
+        SETFLOAT(&args[0], (t_float)parser->frames);
+        SETFLOAT(&args[1], (t_float)parser->resyncs);
+        SETFLOAT(&args[2], (t_float)parser->skipped);
+        witsensor_device_out(x, x->status_out, i, gensym("parser"), 3, args);
+    }
+}
+
+// Per-tick delivery: coalesce off|latest|batch
+static void witsensor_coalesce(t_witsensor *x, t_symbol *mode) {
+    if (mode == gensym("off")) {
+        x->coalesce = COALESCE_OFF;
+    } else if (mode == gensym("latest")) {
+        x->coalesce = COALESCE_LATEST;
+    } else if (mode == gensym("batch")) {
+        x->coalesce = COALESCE_BATCH;
+    } else {
+        post("witsensor: coalesce mode must be one of: off, latest, batch");
+        return;
+    }
+    t_atom a; SETSYMBOL(&a, mode);
+    outlet_anything(x->status_out, gensym("coalesce"), 1, &a);
+}
+
+// dejitter 0|1: with output modes 2/3 (timestamp in every frame) and coalesce
+// off, frames are held and delivered at their device time mapped to host time
+// (offset and drift tracked online, jitter buffer from the delay peak).
+// Without argument: dejitter <drift-ppm> <buffer-ms> <late> <restarts> per device
+static void witsensor_set_dejitter(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (argc > 0) {
+        x->dejitter = atom_getfloat(argv) != 0;
+        if (!x->dejitter) {
+            for (int i = 0; i < x->device_count; i++) witsensor_dejitter_flush(x->devices[i]);
+        }
+        t_atom a; SETFLOAT(&a, x->dejitter);
+        outlet_anything(x->status_out, gensym("dejitter"), 1, &a);
+        return;
+    }
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        t_atom args[4];
+        SETFLOAT(&args[0], (t_float)(dev->dejitter.drift * 1e6));
+        SETFLOAT(&args[1], (t_float)witsensor_dejitter_buffer(&dev->dejitter));
+        SETFLOAT(&args[2], (t_float)dev->late);
+        SETFLOAT(&args[3], (t_float)dev->dejitter.restarts);
+        witsensor_device_out(x, x->status_out, i, gensym("dejitter"), 4, args);
+    }
+}
+
+// ahrs madgwick [beta] | mahony [kp [ki]] | off: host fusion of the streamed
+// accel/gyro into 'quat' on every frame (output modes 0/2). A magnetometer
+// reading from 'mag' or 'poll mag' newer than 1 s adds heading correction.
+// Without argument: ahrs <algorithm> <updates> per device
+static void witsensor_ahrs(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (argc == 0) {
+        for (int i = 0; i < x->device_count; i++) {
+            t_witsensor_device *dev = x->devices[i];
+            t_atom args[2];
+            SETSYMBOL(&args[0], gensym(dev->ahrs.algorithm == WITSENSOR_AHRS_MADGWICK ? "madgwick"
+                                     : dev->ahrs.algorithm == WITSENSOR_AHRS_MAHONY ? "mahony" : "off"));
+            SETFLOAT(&args[1], (t_float)dev->ahrs.updates);
+            witsensor_device_out(x, x->status_out, i, gensym("ahrs"), 2, args);
+        }
+        return;
+    }
+    t_symbol *mode = atom_getsymbol(argv);
+    witsensor_ahrs_algorithm_t algorithm;
+    if (mode == gensym("madgwick")) {
+        algorithm = WITSENSOR_AHRS_MADGWICK;
+    } else if (mode == gensym("mahony")) {
+        algorithm = WITSENSOR_AHRS_MAHONY;
+    } else if (mode == gensym("off") || (argv[0].a_type == A_FLOAT && atom_getfloat(argv) == 0)) {
+        algorithm = WITSENSOR_AHRS_OFF;
+    } else {
+        post("witsensor: ahrs must be one of: madgwick [beta], mahony [kp [ki]], off");
+        return;
+    }
+    // Resolve the defaults here so the status shows the gains in use
+    witsensor_ahrs_t probe;
+    witsensor_ahrs_init(&probe, algorithm, argc > 1 ? atom_getfloat(argv + 1) : 0,
+                        argc > 2 ? atom_getfloat(argv + 2) : 0);
+    x->ahrs.algorithm = algorithm;
+    x->ahrs.gain = probe.gain;
+    x->ahrs.gain_i = probe.gain_i;
+    x->ahrs.reset++;
+    witsensor_ahrs_publish(x);
+    if (algorithm != WITSENSOR_AHRS_OFF && x->output_mode >= 0 && (x->output_mode & 1)) {
+        post("witsensor: ahrs needs accel and gyro, set outputmode 0 or 2");
+    }
+    t_atom args[3];
+    SETSYMBOL(&args[0], algorithm == WITSENSOR_AHRS_OFF ? gensym("off") : mode);
+    SETFLOAT(&args[1], algorithm == WITSENSOR_AHRS_OFF ? 0 : probe.gain);
+    SETFLOAT(&args[2], algorithm == WITSENSOR_AHRS_MAHONY ? probe.gain_i : 0);
+    outlet_anything(x->status_out, gensym("ahrs"), algorithm == WITSENSOR_AHRS_MAHONY ? 3 : (algorithm ? 2 : 1), args);
+}
+
+// Link loss totals of the current connection per device:
+// loss <gaps> <lost> <received> <lost-percent> <gap-ms>
+static void witsensor_loss(t_witsensor *x) {
+    for (int i = 0; i < x->device_count; i++) {
+        witsensor_loss_t *loss = &x->devices[i]->loss;
+        uint64_t expected = loss->frames + loss->lost;
+        t_atom args[5];
+        SETFLOAT(&args[0], (t_float)loss->gaps);
+        SETFLOAT(&args[1], (t_float)loss->lost);
+        SETFLOAT(&args[2], (t_float)loss->frames);
+        SETFLOAT(&args[3], expected ? (t_float)(100.0 * (double)loss->lost / (double)expected) : 0);
+        SETFLOAT(&args[4], (t_float)loss->gap_ms);
+        witsensor_device_out(x, x->status_out, i, gensym("loss"), 5, args);
+    }
+}
+
+// Stop recording: record 0 <records> <bytes> <dropped>
+static void witsensor_record_stop(t_witsensor *x) {
+    witsensor_recorder_t *rec = atomic_exchange(&x->recorder, NULL);
+    if (!rec) return;
+    // A BLE callback that already picked up the recorder finishes its copy first
+    while (atomic_load(&x->recorder_users)) witsensor_sleep_ms(0);
+    witsensor_recorder_stats_t st;
+    witsensor_recorder_close(rec, &st);
+    t_atom args[4];
+    SETFLOAT(&args[0], 0);
+    SETFLOAT(&args[1], (t_float)st.records);
+    SETFLOAT(&args[2], (t_float)st.bytes);
+    SETFLOAT(&args[3], (t_float)st.dropped);
+    outlet_anything(x->status_out, gensym("record"), 4, args);
+}
+
+// record <file>: write every raw notification of all devices with its receive
+// time to a binary log (witsensor_recorder.h), header carrying sensors, rate
+// and output mode. record stop ends it; record reports progress.
+static void witsensor_record(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (argc < 1) {
+        witsensor_recorder_t *rec = atomic_load(&x->recorder);
+        witsensor_recorder_stats_t st;
+        witsensor_recorder_stats(rec, &st);
+        t_atom args[4];
+        SETFLOAT(&args[0], rec != NULL);
+        SETFLOAT(&args[1], (t_float)st.records);
+        SETFLOAT(&args[2], (t_float)st.bytes);
+        SETFLOAT(&args[3], (t_float)st.dropped);
+        outlet_anything(x->status_out, gensym("record"), 4, args);
+        return;
+    }
+    t_symbol *file = atom_getsymbol(argv);
+    if (file == gensym("stop")) {
+        witsensor_record_stop(x);
+        return;
+    }
+    if (!file->s_name[0]) {
+        post("witsensor: record needs a file name or stop");
+        return;
+    }
+    witsensor_record_stop(x);
+    char path[MAXPDSTRING], err[MAXPDSTRING];
+    canvas_makefilename(x->canvas, file->s_name, path, MAXPDSTRING);
+    witsensor_recorder_t *rec = witsensor_recorder_open(path, x->rate_hz, x->output_mode, err, sizeof(err));
+    if (!rec) {
+        pd_error(x, "witsensor: record: %s", err);
+        return;
+    }
+    atomic_store(&x->recorder, rec);
+    witsensor_record_info(x);
+    t_atom args[2];
+    SETFLOAT(&args[0], 1);
+    SETSYMBOL(&args[1], gensym(path));
+    outlet_anything(x->status_out, gensym("record"), 2, args);
+}
+
+// Back to the object's own output mode, rate and sensor names after a replay
+static void witsensor_replay_restore(t_witsensor *x) {
+    x->output_mode = x->replay_saved_mode;
+    x->rate_hz = x->replay_saved_rate;
+    witsensor_ahrs_publish(x);
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if (i < x->replay_saved_count) memcpy(dev->name, x->replay_saved_names[i], sizeof(dev->name));
+        witsensor_device_set_mode(dev, x->output_mode);
+    }
+}
+
+// Stop replaying: replay 0 <notifications> <frames> <elapsed-ms>
+static void witsensor_replay_stop(t_witsensor *x) {
+    if (!x->replay) return;
+    witsensor_replay_stats_t st;
+    witsensor_replay_close(x->replay, &st);
+    x->replay = NULL;
+    uint64_t frames = 0;
+    for (int i = 0; i < x->device_count; i++) frames += x->devices[i]->parser.frames;
+    witsensor_replay_restore(x);
+    t_atom args[4];
+    SETFLOAT(&args[0], 0);
+    SETFLOAT(&args[1], (t_float)st.records);
+    SETFLOAT(&args[2], (t_float)(frames - x->replay_frames));
+    SETFLOAT(&args[3], (t_float)(st.elapsed_ns / 1e6));
+    outlet_anything(x->status_out, gensym("replay"), 4, args);
+}
+
+// Pd thread: the replay fed its last record
+static void witsensor_pd_replay_done_handler(t_pd *obj, void *data) {
+    (void)data;
+    if (!obj) return; // cancelled by pd_queue_cancel
+    t_witsensor *x = (t_witsensor *)obj;
+    witsensor_replay_stats_t st;
+    witsensor_replay_stats(x->replay, &st);
+    // A replay stopped and restarted meanwhile is still running
+    if (st.finished) witsensor_replay_stop(x);
+}
+
+// Replay thread: a recorded notification takes the path of a live one
+static void witsensor_replay_data(void *user_data, int source, const unsigned char *data, int length) {
+    t_witsensor *x = (t_witsensor *)user_data;
+    if (source < x->device_count) witsensor_ble_data_callback(x->devices[source], data, length);
+}
+
+// Replay thread at speed 0: hold back while the slot's frame queue could not
+// take a whole notification, instead of overflowing it
+static int witsensor_replay_ready(void *user_data, int source, int length) {
+    t_witsensor *x = (t_witsensor *)user_data;
+    if (source >= x->device_count) return 1;
+    unsigned int frames = (unsigned int)(length / WITSENSOR_FRAME_SIZE) + 1;
+    return witsensor_ring_depth(&x->devices[source]->frames) + frames <= WITSENSOR_RING_CAPACITY;
+}
+
+static void witsensor_replay_done(void *user_data) {
+    t_witsensor *x = (t_witsensor *)user_data;
+    pd_queue_mess(x->pd_instance, (t_pd *)x, NULL, witsensor_pd_replay_done_handler);
+}
+
+// replay <file> [speed]: feed a recording (see 'record') through the BLE data
+// callback, parser and delivery as if the sensors were connected. Source n
+// plays on device slot n. speed 1 (default) keeps the recorded timing, 0 plays
+// as fast as the frame queues drain. The recording's output mode, rate and
+// sensor names apply until replay stop or the end, then the object's own come
+// back. replay reports progress.
+static void witsensor_replay(t_witsensor *x, t_symbol *s, int argc, t_atom *argv) {
+    (void)s;
+    if (argc < 1) {
+        witsensor_replay_stats_t st;
+        witsensor_replay_stats(x->replay, &st);
+        t_atom args[4];
+        SETFLOAT(&args[0], x->replay != NULL);
+        SETFLOAT(&args[1], (t_float)st.records);
+        SETFLOAT(&args[2], (t_float)st.position_ms);
+        SETFLOAT(&args[3], (t_float)(st.elapsed_ns / 1e6));
+        outlet_anything(x->status_out, gensym("replay"), 4, args);
+        return;
+    }
+    t_symbol *file = atom_getsymbol(argv);
+    if (file == gensym("stop")) {
+        witsensor_replay_stop(x);
+        return;
+    }
+    if (!file->s_name[0]) {
+        post("witsensor: replay needs a file name or stop");
+        return;
+    }
+    t_float speed = argc > 1 ? atom_getfloat(argv + 1) : 1;
+    witsensor_replay_stop(x);
+    // The slots take the place of live links, so none may be in use
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if (dev->is_connected || dev->connecting || dev->pending_target || dev->lost_ns) {
+            post("witsensor: disconnect before replaying");
+            return;
+        }
+    }
+    char path[MAXPDSTRING], err[MAXPDSTRING];
+    canvas_makefilename(x->canvas, file->s_name, path, MAXPDSTRING);
+    witsensor_replay_t *rp = witsensor_replay_open(path, err, sizeof(err));
+    if (!rp) {
+        pd_error(x, "witsensor: replay: %s", err);
+        return;
+    }
+    const witsensor_record_header_t *h = witsensor_replay_header(rp);
+    while (x->device_count < witsensor_replay_sources(rp)) {
+        if (!witsensor_device_new(x)) {
+            pd_error(x, "witsensor: replay: no device slot for source %d", x->device_count);
+            witsensor_replay_close(rp, NULL);
+            return;
+        }
+    }
+    // Decode and account frames the way the recorded stream was configured
+    x->replay_saved_mode = x->output_mode;
+    x->replay_saved_rate = x->rate_hz;
+    x->replay_saved_count = x->device_count;
+    for (int i = 0; i < x->device_count; i++) {
+        memcpy(x->replay_saved_names[i], x->devices[i]->name, sizeof(x->replay_saved_names[i]));
+    }
+    if (h->output_mode >= 0 && h->output_mode <= 3) x->output_mode = h->output_mode;
+    if (h->rate_hz > 0) x->rate_hz = h->rate_hz;
+    witsensor_ahrs_publish(x);
+    x->replay_frames = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        if (i < WITSENSOR_RECORD_SOURCES && h->sensor[i][0]) snprintf(dev->name, sizeof(dev->name), "%.*s", (int)sizeof(dev->name) - 1, h->sensor[i]);
+        witsensor_dejitter_flush(dev);
+        witsensor_parser_reset(&dev->parser);
+        witsensor_dejitter_init(&dev->dejitter);
+        witsensor_loss_init(&dev->loss);
+        witsensor_device_set_mode(dev, x->output_mode);
+        x->replay_frames += dev->parser.frames;
+    }
+    witsensor_replay_set_ready(rp, witsensor_replay_ready);
+    if (!witsensor_replay_start(rp, speed, witsensor_replay_data, witsensor_replay_done, x)) {
+        pd_error(x, "witsensor: replay: can't start the replay thread");
+        witsensor_replay_close(rp, NULL);
+        witsensor_replay_restore(x);
+        return;
+    }
+    x->replay = rp;
+    t_atom args[3];
+    SETFLOAT(&args[0], 1);
+    SETSYMBOL(&args[1], gensym(path));
+    SETFLOAT(&args[2], (t_float)witsensor_replay_duration_ms(rp));
+    outlet_anything(x->status_out, gensym("replay"), 3, args);
+}
+
+// Emit one latency line: stats <stage> <p50> <p95> <p99> <max> in ms
+static void witsensor_stats_latency(t_witsensor *x, const char *stage, const witsensor_histogram_t *h) {
+    static const double q[3] = {0.5, 0.95, 0.99};
+    t_atom args[5];
+    SETSYMBOL(&args[0], gensym(stage));
+    for (int i = 0; i < 3; i++) SETFLOAT(&args[1 + i], (t_float)(witsensor_histogram_quantile(h, q[i]) / 1e6));
+    SETFLOAT(&args[4], (t_float)(h->max / 1e6));
+    outlet_anything(x->status_out, gensym("stats"), 5, args);
+}
+
+// Report and restart the measurement window (send it from a [metro] for
+// periodic figures):
+//   stats decode|output|total <p50> <p95> <p99> <max>  latency in ms of BLE
+//     receive -> decoded (BLE thread), decoded -> Pd output, and end to end
+//   stats rate <frames/s> <notifications/s>
+//   stats queue <depth> <high-water> <dropped>  per device, drops in the window
+static void witsensor_stats(t_witsensor *x) {
+    uint64_t now = witsensor_now_ns();
+    double seconds = (double)(now - x->stats_since_ns) / 1e9;
+    if (seconds <= 0) seconds = 1e-9;
+    witsensor_stats_latency(x, "decode", &x->lat_decode);
+    witsensor_stats_latency(x, "output", &x->lat_output);
+    witsensor_stats_latency(x, "total", &x->lat_total);
+    uint64_t notifications = 0;
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        uint64_t count = atomic_load(&dev->ble_data->data_count);
+        notifications += count - dev->stats_notifications;
+        dev->stats_notifications = count;
+    }
+    t_atom args[3];
+    SETSYMBOL(&args[0], gensym("rate"));
+    SETFLOAT(&args[1], (t_float)(x->stats_frames / seconds));
+    SETFLOAT(&args[2], (t_float)(notifications / seconds));
+    outlet_anything(x->status_out, gensym("stats"), 3, args);
+    for (int i = 0; i < x->device_count; i++) {
+        t_witsensor_device *dev = x->devices[i];
+        uint64_t dropped = atomic_load(&dev->frames.dropped);
+        t_atom q[4];
+        SETSYMBOL(&q[0], gensym("queue"));
+        SETFLOAT(&q[1], (t_float)witsensor_ring_depth(&dev->frames));
+        SETFLOAT(&q[2], (t_float)atomic_load(&dev->frames.high_water));
+        SETFLOAT(&q[3], (t_float)(dropped - dev->stats_dropped));
+        dev->stats_dropped = dropped;
+        witsensor_device_out(x, x->status_out, i, gensym("stats"), 4, q);
+    }
+    witsensor_histogram_reset(&x->lat_decode);
+    witsensor_histogram_reset(&x->lat_output);
+    witsensor_histogram_reset(&x->lat_total);
+    x->stats_frames = 0;
+    x->stats_since_ns = now;
+}
+
+// Signal resampling: interp hold|linear|cubic ([witsensor~] only)
+static void witsensor_interp(t_witsensor *x, t_symbol *mode) {
+    if (mode == gensym("hold")) {
+        x->interp = WITSENSOR_INTERP_HOLD;
+    } else if (mode == gensym("linear")) {
+        x->interp = WITSENSOR_INTERP_LINEAR;
+    } else if (mode == gensym("cubic")) {
+        x->interp = WITSENSOR_INTERP_CUBIC;
+    } else {
+        post("witsensor~: interp mode must be one of: hold, linear, cubic");
+        return;
+    }
+    t_atom a; SETSYMBOL(&a, mode);
+    outlet_anything(x->status_out, gensym("interp"), 1, &a);
+}
+
+// (Re)start signal resampling; frames are assumed at the 50 Hz default rate until measured
+static void witsensor_interp_reset(t_witsensor *x, t_float sr) {
+    x->sig_sr = sr > 0 ? sr : 44100;
+    double period = x->sig_sr / 50.0;
+    // Angle channels (6..8) wrap at +-180 degrees
+    witsensor_interp_init(&x->sig_frames, FRAME_ATOMS, 0, 0x1C0, period);
+    witsensor_interp_init(&x->sig_quat, 4, 1, 0, period);
+}
+
+// Interpolate frames at audio rate: one outlet per channel, no per-sample messages
+static t_int *witsensor_tilde_perform(t_int *w) {
+    t_witsensor *x = (t_witsensor *)(w[1]);
+    int n = (int)(w[2]);
+    double t = witsensor_interp_block_start(&x->sig_frames, x->interp, x->sig_time, n);
+    double tq = witsensor_interp_block_start(&x->sig_quat, x->interp, x->sig_time, n);
+    float v[FRAME_ATOMS], q[4];
+    for (int i = 0; i < n; i++) {
+        witsensor_interp_eval(&x->sig_frames, x->interp, t + i, v);
+        witsensor_interp_eval(&x->sig_quat, x->interp, tq + i, q);
+        for (int c = 0; c < FRAME_ATOMS; c++) x->sig_vec[c][i] = v[c];
+        for (int c = 0; c < 4; c++) x->sig_vec[FRAME_ATOMS + c][i] = q[c];
+    }
+    x->sig_time += n;
+    return (w + 3);
+}
+
+static void witsensor_tilde_dsp(t_witsensor *x, t_signal **sp) {
+    if (sp[0]->s_sr != x->sig_sr) witsensor_interp_reset(x, sp[0]->s_sr);
+    for (int c = 0; c < SIG_CHANNELS; c++) x->sig_vec[c] = sp[c]->s_vec;
+    dsp_add(witsensor_tilde_perform, 2, x, (t_int)sp[0]->s_n);
+}
+
+// Constructor (shared by [witsensor] and [witsensor~])
+static void *witsensor_do_new(t_class *c, int is_signal) {
+    t_witsensor *x = (t_witsensor *)pd_new(c);
     
     // macOS: preflight CoreBluetooth authorization. If missing, fail creation cleanly.
     #ifdef __APPLE__
@@ -1001,71 +2182,108 @@ static void *witsensor_new(void) {
     }
     #endif
     
+    // [witsensor~]: signal outlets first, message outlets to the right
+    x->is_signal = is_signal;
+    if (is_signal) {
+        for (int c = 0; c < SIG_CHANNELS; c++) outlet_new(&x->x_obj, &s_signal);
+    }
     x->data_out = outlet_new(&x->x_obj, &s_anything);
     x->status_out = outlet_new(&x->x_obj, &s_float);
     x->poll_clock = clock_new(x, (t_method)witsensor_poll_tick);
+    x->cmd_clock = clock_new(x, (t_method)witsensor_cmd_tick);
+    x->cmd_head = 0;
+    x->cmd_count = 0;
+    x->cmd_busy = 0;
+    x->cmd_seq = 0;
+    x->cmd_seq_failed = 0;
     
     x->is_connected = 0;
     x->is_scanning = 0;
-    x->should_stop = 0;
-    x->poll_interval = 0;
-    x->poll_type = NULL;
+    witsensor_poll_init(&x->poll);
+    x->read_timeout_ms = WITSENSOR_PENDING_TIMEOUT_MS;
+    x->read_retries = WITSENSOR_PENDING_RETRIES;
     // Tracked state defaults
     x->axis_mode = 0;
     x->output_mode = -1;
-    x->temp_bytes_count = 0;
+    x->rate_hz = 50.0f;
+    x->rate_code = 0x08;
+    x->bw_hz = 256.0f;
+    x->bw_code = 0x00;
+    x->autoreconnect = 0;
     x->pd_instance = pd_this;
-    x->pending_target = NULL;
-    x->seen_ids = NULL;
-    x->seen_count = 0;
+    x->canvas = canvas_getcurrent();
+    atomic_init(&x->recorder, NULL);
+    atomic_init(&x->recorder_users, 0);
+    x->replay = NULL;
+    atomic_init(&x->drain_pending, 0);
+    x->coalesce = COALESCE_OFF;
+    x->dejitter = 0;
+    x->ahrs.algorithm = WITSENSOR_AHRS_OFF;
+    x->ahrs.gain = 0;
+    x->ahrs.gain_i = 0;
+    x->ahrs.period = x->rate_hz > 0 ? 1.0f / x->rate_hz : 0.0f;
+    x->ahrs.reset = 0;
+    witsensor_ahrs_shared_init(&x->ahrs_shared, &x->ahrs);
+    witsensor_histogram_reset(&x->lat_decode);
+    witsensor_histogram_reset(&x->lat_output);
+    witsensor_histogram_reset(&x->lat_total);
+    x->stats_frames = 0;
+    x->stats_since_ns = witsensor_now_ns();
+    x->interp = WITSENSOR_INTERP_LINEAR;
+    x->sig_time = 0;
+    witsensor_interp_reset(x, sys_getsr());
     
-    // Initialize BLE data structure (adapter will be created on first scan)
+    // Device slots: slot 0 also owns the scan (adapter will be created on first scan)
+    x->device_count = 0;
+    x->batch_atoms = NULL;
+    x->batch_size = 0;
+    x->cmd_target = -1;
+    x->ble_data = NULL;
     post("witsensor: initializing BLE system...");
-    x->ble_data = witsensor_ble_simpleble_create();
-    if (x->ble_data) {
-        // Set up data callback
-        x->ble_data->pd_obj = x;
-        x->ble_data->data_callback = witsensor_ble_data_callback;
-        x->ble_data->pd_instance = x->pd_instance;
+    t_witsensor_device *dev = witsensor_device_new(x);
+    if (dev) {
+        x->ble_data = dev->ble_data;
         post("witsensor: BLE data structure ready (adapter will initialize on first scan)");
     } else {
         pd_error(x, "witsensor: BLE system initialization failed");
     }
     
-    // Initialize sensor data
-    x->accel_x = x->accel_y = x->accel_z = 0.0f;
-    x->gyro_x = x->gyro_y = x->gyro_z = 0.0f;
-    x->angle_x = x->angle_y = x->angle_z = 0.0f;
-    x->quat_w = x->quat_x = x->quat_y = x->quat_z = 0.0f;
-    x->disp_x = x->disp_y = x->disp_z = 0.0f;
-    x->speed_x = x->speed_y = x->speed_z = 0.0f;
-    x->ts_lo = x->ts_hi = 0;
-    x->use_disp_speed = 0;
-    x->use_timestamp = 0;
-    
     return (void *)x;
 }
 
+static void *witsensor_new(void) {
+    return witsensor_do_new(witsensor_class, 0);
+}
+
+static void *witsensor_tilde_new(void) {
+    return witsensor_do_new(witsensor_tilde_class, 1);
+}
+
 // Destructor
 static void witsensor_free(t_witsensor *x) {
+    witsensor_replay_stop(x);
+    witsensor_record_stop(x);
     // Stop scanning first to avoid callbacks firing after free
     if (x->ble_data && witsensor_ble_simpleble_is_scanning(x->ble_data)) {
         witsensor_ble_simpleble_stop_scanning(x->ble_data);
     }
-    // Disconnect device
-    witsensor_disconnect(x);
-    pd_queue_cancel((t_pd *)x);
-    if (x->ble_data) {
-        witsensor_ble_simpleble_destroy(x->ble_data);
-    }
-    // Free dedupe list
-    if (x->seen_ids) {
-        for (unsigned long i = 0; i < x->seen_count; i++) free(x->seen_ids[i]);
-        free(x->seen_ids);
-        x->seen_ids = NULL;
-        x->seen_count = 0;
+    // Disconnect devices (pending commands are dropped silently). Destroying a
+    // handle cancels its worker jobs and disconnects, so nothing is queued for
+    // this object afterwards. Extra slots scan through slot 0, so it goes last.
+    x->cmd_count = 0;
+    for (int i = x->device_count - 1; i >= 0; i--) {
+        witsensor_ble_simpleble_destroy(x->devices[i]->ble_data);
+        clock_free(x->devices[i]->reconnect_clock);
+        clock_free(x->devices[i]->dejitter_clock);
+        clock_free(x->devices[i]->pending_clock);
+        freebytes(x->devices[i], sizeof(t_witsensor_device));
     }
+    pd_queue_cancel((t_pd *)x);
+    x->device_count = 0;
+    x->ble_data = NULL;
+    if (x->batch_atoms) freebytes(x->batch_atoms, sizeof(t_atom) * x->batch_size);
     clock_free(x->poll_clock);
+    clock_free(x->cmd_clock);
 }
 
 // WIT sensor command functions
@@ -1076,11 +2294,11 @@ static void witsensor_calibrate(t_witsensor *x) {
     
     // Unlock
     unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
-    usleep(50000);
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, gensym("calibrate"), cmd_unlock, sizeof(cmd_unlock), 50);
     post("witsensor: starting accelerometer calibration - keep sensor still");
     unsigned char cmd[] = {0xFF, 0xAA, 0x01, 0x01, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd, sizeof(cmd));
+    witsensor_cmd_push(x, gensym("calibrate"), cmd, sizeof(cmd), 0);
 }
 
 
@@ -1092,45 +2310,42 @@ static void witsensor_axis(t_witsensor *x, t_float axis_count) {
         code = 0x00; // 9-axis
     }
     unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
-    usleep(50000);
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, gensym("axis"), cmd_unlock, sizeof(cmd_unlock), 50);
     unsigned char cmd_algo[] = {0xFF, 0xAA, 0x24, code, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_algo, sizeof(cmd_algo));
     x->axis_mode = (axis_count == 9 ? 9 : 6);
     t_atom a; SETFLOAT(&a, x->axis_mode);
-    outlet_anything(x->status_out, gensym("axis"), 1, &a);
+    witsensor_cmd_status(witsensor_cmd_push(x, gensym("axis"), cmd_algo, sizeof(cmd_algo), 0), gensym("axis"), 1, &a);
 }
 
 static void witsensor_magcal_start(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
-    usleep(50000);
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, gensym("magcal"), cmd_unlock, sizeof(cmd_unlock), 50);
     unsigned char cmd_start[] = {0xFF, 0xAA, 0x01, 0x07, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_start, sizeof(cmd_start));
     t_atom a; SETSYMBOL(&a, gensym("start"));
-    outlet_anything(x->status_out, gensym("magcal"), 1, &a);
+    witsensor_cmd_status(witsensor_cmd_push(x, gensym("magcal"), cmd_start, sizeof(cmd_start), 0), gensym("magcal"), 1, &a);
 }
 
 static void witsensor_magcal_stop(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
     unsigned char cmd_stop[] = {0xFF, 0xAA, 0x01, 0x00, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_stop, sizeof(cmd_stop));
+    witsensor_write(x, -1, cmd_stop, sizeof(cmd_stop), 0);
     t_atom a; SETSYMBOL(&a, gensym("stop"));
     outlet_anything(x->status_out, gensym("magcal"), 1, &a);
 }
 
 static void witsensor_zzero(t_witsensor *x) {
     if (!x->is_connected || !x->ble_data) { post("witsensor: not connected to device"); return; }
+    t_symbol *seq = gensym("zzero");
     unsigned char cmd_unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_unlock, sizeof(cmd_unlock));
-    usleep(50000);
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, seq, cmd_unlock, sizeof(cmd_unlock), 50);
     unsigned char cmd_algo6[] = {0xFF, 0xAA, 0x24, 0x01, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_algo6, sizeof(cmd_algo6));
-    usleep(50000);
+    witsensor_cmd_push(x, seq, cmd_algo6, sizeof(cmd_algo6), 50);
     unsigned char cmd_zeroz[] = {0xFF, 0xAA, 0x01, 0x04, 0x00};
-    witsensor_ble_simpleble_write_data(x->ble_data, cmd_zeroz, sizeof(cmd_zeroz));
-    outlet_anything(x->status_out, gensym("zzero"), 0, NULL);
+    witsensor_cmd_status(witsensor_cmd_push(x, seq, cmd_zeroz, sizeof(cmd_zeroz), 0), gensym("zzero"), 0, NULL);
 }
 
 // Version info
@@ -1139,6 +2354,55 @@ static void witsensor_version(void) {
          WITSENSOR_MAJOR_VERSION, WITSENSOR_MINOR_VERSION, WITSENSOR_BUGFIX_VERSION);
 }
 
+// Message methods shared by [witsensor] and [witsensor~]
+static void witsensor_add_methods(t_class *c) {
+    class_addmethod(c, (t_method)witsensor_scan_devices, gensym("scan"), 0);
+    class_addmethod(c, (t_method)witsensor_get_scan_results, gensym("results"), 0);
+    class_addmethod(c, (t_method)witsensor_connect, gensym("connect"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_disconnect, gensym("disconnect"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_autoreconnect, gensym("autoreconnect"), A_DEFFLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_poll, gensym("poll"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_rtt, gensym("rtt"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_set_rate, gensym("rate"), A_FLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_set_bandwidth, gensym("bandwidth"), A_FLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_axis, gensym("axis"), A_FLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_calibrate, gensym("calibrate"), 0);
+    class_addmethod(c, (t_method)witsensor_magcal_start, gensym("magcal-start"), 0);
+    class_addmethod(c, (t_method)witsensor_magcal_stop, gensym("magcal-stop"), 0);
+    class_addmethod(c, (t_method)witsensor_xyzero, gensym("xyzero"), 0);
+    class_addmethod(c, (t_method)witsensor_zzero, gensym("zzero"), 0);
+    // About/version of the external
+    class_addmethod(c, (t_method)witsensor_version, gensym("about"), 0);
+    // Device queries
+    class_addmethod(c, (t_method)witsensor_read_version, gensym("version"), 0);
+    class_addmethod(c, (t_method)witsensor_read_time, gensym("time"), 0);
+    class_addmethod(c, (t_method)witsensor_read, gensym("read"), A_FLOAT, A_DEFFLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_battery, gensym("battery"), 0);
+    class_addmethod(c, (t_method)witsensor_temp, gensym("temp"), 0);
+    class_addmethod(c, (t_method)witsensor_mag, gensym("mag"), 0);
+    class_addmethod(c, (t_method)witsensor_quat, gensym("quat"), 0);
+    class_addmethod(c, (t_method)witsensor_set_orientation, gensym("orientation"), A_DEFFLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_set_output_mode, gensym("outputmode"), A_DEFFLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_save, gensym("save"), 0);
+    class_addmethod(c, (t_method)witsensor_restore, gensym("restore"), 0);
+    class_addmethod(c, (t_method)witsensor_set_baud, gensym("baud"), A_DEFFLOAT, 0);
+    class_addmethod(c, (t_method)witsensor_reset, gensym("reset"), 0);
+    class_addmethod(c, (t_method)witsensor_setname, gensym("setname"), A_GIMME, 0);
+    // Frame queue
+    class_addmethod(c, (t_method)witsensor_overflow, gensym("overflow"), A_SYMBOL, 0);
+    class_addmethod(c, (t_method)witsensor_queue, gensym("queue"), 0);
+    class_addmethod(c, (t_method)witsensor_parser, gensym("parser"), 0);
+    class_addmethod(c, (t_method)witsensor_latest, gensym("latest"), 0);
+    class_addmethod(c, (t_method)witsensor_coalesce, gensym("coalesce"), A_SYMBOL, 0);
+    class_addmethod(c, (t_method)witsensor_set_dejitter, gensym("dejitter"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_ahrs, gensym("ahrs"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_stats, gensym("stats"), 0);
+    class_addmethod(c, (t_method)witsensor_loss, gensym("loss"), 0);
+    class_addmethod(c, (t_method)witsensor_record, gensym("record"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_replay, gensym("replay"), A_GIMME, 0);
+    class_addmethod(c, (t_method)witsensor_mock, gensym("mock"), A_SYMBOL, A_DEFFLOAT, 0);
+}
+
 // Setup function
 #if defined(_WIN32)
 __declspec(dllexport)
@@ -1146,42 +2410,30 @@ __declspec(dllexport)
 __attribute__((visibility("default")))
 #endif
 void witsensor_setup(void) {
+    witsensor_register_init();
+    for (int i = 0; i < witsensor_register_count; i++) {
+        witsensor_register_syms[i] = gensym(witsensor_registers[i].name);
+    }
+
     witsensor_class = class_new(gensym("witsensor"),
                                (t_newmethod)witsensor_new,
                                (t_method)witsensor_free,
                                sizeof(t_witsensor),
                                CLASS_DEFAULT,
                                0);
-    
-    class_addmethod(witsensor_class, (t_method)witsensor_scan_devices, gensym("scan"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_get_scan_results, gensym("results"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_connect, gensym("connect"), A_GIMME, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_disconnect, gensym("disconnect"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_poll, gensym("poll"), A_SYMBOL, A_DEFFLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_set_rate, gensym("rate"), A_FLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_set_bandwidth, gensym("bandwidth"), A_FLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_axis, gensym("axis"), A_FLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_calibrate, gensym("calibrate"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_magcal_start, gensym("magcal-start"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_magcal_stop, gensym("magcal-stop"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_xyzero, gensym("xyzero"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_zzero, gensym("zzero"), 0);
-    // About/version of the external
-    class_addmethod(witsensor_class, (t_method)witsensor_version, gensym("about"), 0);
-    // Device queries
-    class_addmethod(witsensor_class, (t_method)witsensor_read_version, gensym("version"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_read_time, gensym("time"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_battery, gensym("battery"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_temp, gensym("temp"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_mag, gensym("mag"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_quat, gensym("quat"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_set_orientation, gensym("orientation"), A_DEFFLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_set_output_mode, gensym("outputmode"), A_DEFFLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_save, gensym("save"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_restore, gensym("restore"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_set_baud, gensym("baud"), A_DEFFLOAT, 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_reset, gensym("reset"), 0);
-    class_addmethod(witsensor_class, (t_method)witsensor_setname, gensym("setname"), A_GIMME, 0);
+    witsensor_add_methods(witsensor_class);
+
+    // Signal-rate companion: same object with one signal outlet per channel
+    witsensor_tilde_class = class_new(gensym("witsensor~"),
+                               (t_newmethod)witsensor_tilde_new,
+                               (t_method)witsensor_free,
+                               sizeof(t_witsensor),
+                               CLASS_DEFAULT,
+                               0);
+    witsensor_add_methods(witsensor_tilde_class);
+    class_addmethod(witsensor_tilde_class, (t_method)witsensor_tilde_dsp, gensym("dsp"), A_CANT, 0);
+    class_addmethod(witsensor_tilde_class, (t_method)witsensor_interp, gensym("interp"), A_SYMBOL, 0);
+    class_sethelpsymbol(witsensor_tilde_class, gensym("witsensor"));
     
     witsensor_version();
 }
@@ -1226,9 +2478,10 @@ static void witsensor_setname(t_witsensor *x, t_symbol *s, int argc, t_atom *arg
     post("witsensor: setname starting - variant %d, name: %s", variant, full_name);
     
     // Unlock
+    t_symbol *seq = gensym("setname");
     unsigned char unlock[] = {0xFF, 0xAA, 0x69, 0x88, 0xB5};
-    witsensor_ble_simpleble_write_data(x->ble_data, unlock, sizeof(unlock));
-    usleep(100000);  // Increased delay
+    witsensor_cmd_begin(x);
+    witsensor_cmd_push(x, seq, unlock, sizeof(unlock), 100);  // Increased delay
     
     // Build ASCII command per variant
     char cmd[64];
@@ -1249,14 +2502,14 @@ static void witsensor_setname(t_witsensor *x, t_symbol *s, int argc, t_atom *arg
         }
         
         // Use write-request to ensure correct length and delivery semantics
-        witsensor_ble_simpleble_write_request_raw(x->ble_data, (const unsigned char*)cmd, n);
+        t_witsensor_cmd *ascii = witsensor_cmd_push(x, seq, (const unsigned char*)cmd, n, 10);  // Minimal delay
+        if (ascii) ascii->request = 1;
         
         // Send save immediately - no delay to avoid device timeout/reboot
-        usleep(10000);  // Minimal delay
         post("witsensor: sending save command immediately");
         unsigned char save[] = {0xFF, 0xAA, 0x00, 0x00, 0x00};
-        witsensor_ble_simpleble_write_data(x->ble_data, save, sizeof(save));
+        witsensor_cmd_push(x, seq, save, sizeof(save), 0);
     }
     
-    post("witsensor: setname complete - expect disconnect/reboot");
+    post("witsensor: setname queued - expect disconnect/reboot");
 }
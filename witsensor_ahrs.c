@@ -0,0 +1,267 @@
+/* witsensor_ahrs.c
+ * Host-side orientation fusion (Madgwick or Mahony) from streamed accel/gyro
+ *
+ * Both filters integrate the gyro and pull the estimate towards the gravity
+ * direction from the accelerometer, and towards magnetic north when a fresh
+ * magnetometer reading is present (otherwise yaw is gyro only and drifts).
+ * Madgwick takes a normalised gradient step of size beta; Mahony feeds the
+ * cross-product error back into the rates with kp (and ki for gyro bias).
+ * The update equations follow the reference implementations of Sebastian
+ * Madgwick's report (2010) and Mahony et al. (2008). The first accelerometer
+ * reading (and magnetometer, if fresh) seeds the orientation so the output
+ * does not have to converge from identity.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_ahrs.h"
+#include <math.h>
+#include <string.h>
+
+#define WITSENSOR_AHRS_DEG_TO_RAD 0.017453292519943295f
+
+void witsensor_ahrs_init(witsensor_ahrs_t *ahrs, witsensor_ahrs_algorithm_t algorithm, float gain, float gain_i) {
+    if (!ahrs) return;
+    memset(ahrs, 0, sizeof(*ahrs));
+    ahrs->algorithm = algorithm;
+    if (algorithm == WITSENSOR_AHRS_MAHONY) {
+        ahrs->gain = gain > 0 ? gain : WITSENSOR_AHRS_MAHONY_KP;
+        ahrs->gain_i = gain_i > 0 ? gain_i : WITSENSOR_AHRS_MAHONY_KI;
+    } else {
+        ahrs->gain = gain > 0 ? gain : WITSENSOR_AHRS_MADGWICK_BETA;
+    }
+    ahrs->q[0] = 1.0f;
+}
+
+void witsensor_ahrs_set_mag(witsensor_ahrs_t *ahrs, const float *mag, uint64_t now_ns) {
+    if (!ahrs || !mag) return;
+    if (mag[0] == 0.0f && mag[1] == 0.0f && mag[2] == 0.0f) return;
+    memcpy(ahrs->mag, mag, sizeof(ahrs->mag));
+    ahrs->mag_ns = now_ns ? now_ns : 1;
+}
+
+// Scale v[0..2] to unit length; returns 0 for a zero vector
+static int witsensor_ahrs_normalise3(float *v) {
+    float n = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    if (!(n > 0.0f)) return 0;
+    n = 1.0f / sqrtf(n);
+    v[0] *= n;
+    v[1] *= n;
+    v[2] *= n;
+    return 1;
+}
+
+static void witsensor_ahrs_normalise4(float *q) {
+    float n = q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3];
+    if (!(n > 0.0f) || !isfinite(n)) {
+        q[0] = 1.0f; q[1] = q[2] = q[3] = 0.0f;
+        return;
+    }
+    n = 1.0f / sqrtf(n);
+    for (int i = 0; i < 4; i++) q[i] *= n;
+}
+
+// Orientation from gravity (roll, pitch) and, with m, tilt-compensated heading
+static void witsensor_ahrs_seed(witsensor_ahrs_t *ahrs, const float *a, const float *m) {
+    float roll = atan2f(a[1], a[2]);
+    float pitch = atan2f(-a[0], sqrtf(a[1] * a[1] + a[2] * a[2]));
+    float yaw = 0.0f;
+    if (m) {
+        float sr = sinf(roll), cr = cosf(roll), sp = sinf(pitch), cp = cosf(pitch);
+        float mx = m[0] * cp + m[1] * sr * sp + m[2] * cr * sp;
+        float my = m[1] * cr - m[2] * sr;
+        yaw = atan2f(-my, mx);
+    }
+    float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+    float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+    float cy = cosf(yaw * 0.5f), sy = sinf(yaw * 0.5f);
+    ahrs->q[0] = cr * cp * cy + sr * sp * sy;
+    ahrs->q[1] = sr * cp * cy - cr * sp * sy;
+    ahrs->q[2] = cr * sp * cy + sr * cp * sy;
+    ahrs->q[3] = cr * cp * sy - sr * sp * cy;
+    witsensor_ahrs_normalise4(ahrs->q);
+}
+
+// Gradient of the gravity (and, with m, earth field) error, normalised into s
+static void witsensor_madgwick_step(const float *q, const float *a, const float *m, float *s) {
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    float ax = a[0], ay = a[1], az = a[2];
+    float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+    float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+    if (!m) {
+        float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+        s[0] = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        s[1] = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        s[2] = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        s[3] = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+    } else {
+        float mx = m[0], my = m[1], mz = m[2];
+        float q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+        float q1q2 = q1 * q2, q1q3 = q1 * q3, q2q3 = q2 * q3;
+        float _2q0mx = 2.0f * q0 * mx, _2q0my = 2.0f * q0 * my, _2q0mz = 2.0f * q0 * mz;
+        float _2q1mx = 2.0f * q1 * mx;
+        float _2q0q2 = 2.0f * q0q2, _2q2q3 = 2.0f * q2q3;
+        // Earth field direction in the current estimate, projected to (bx, 0, bz)
+        float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3
+                 - mx * q2q2 - mx * q3q3;
+        float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3
+                 - my * q3q3;
+        float _2bx = sqrtf(hx * hx + hy * hy);
+        float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3
+                   - mz * q2q2 + mz * q3q3;
+        float _4bx = 2.0f * _2bx, _4bz = 2.0f * _2bz;
+        float fgx = 2.0f * q1q3 - _2q0q2 - ax;
+        float fgy = 2.0f * q0q1 + _2q2q3 - ay;
+        float fgz = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+        float fbx = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+        float fby = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+        float fbz = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+        s[0] = -_2q2 * fgx + _2q1 * fgy - _2bz * q2 * fbx + (-_2bx * q3 + _2bz * q1) * fby + _2bx * q2 * fbz;
+        s[1] = _2q3 * fgx + _2q0 * fgy - 4.0f * q1 * fgz + _2bz * q3 * fbx + (_2bx * q2 + _2bz * q0) * fby
+             + (_2bx * q3 - _4bz * q1) * fbz;
+        s[2] = -_2q0 * fgx + _2q3 * fgy - 4.0f * q2 * fgz + (-_4bx * q2 - _2bz * q0) * fbx
+             + (_2bx * q1 + _2bz * q3) * fby + (_2bx * q0 - _4bz * q2) * fbz;
+        s[3] = _2q1 * fgx + _2q2 * fgy + (-_4bx * q3 + _2bz * q1) * fbx + (-_2bx * q0 + _2bz * q2) * fby
+             + _2bx * q1 * fbz;
+    }
+    float n = s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3];
+    if (n > 0.0f) {
+        n = 1.0f / sqrtf(n);
+        for (int i = 0; i < 4; i++) s[i] *= n;
+    }
+}
+
+static void witsensor_madgwick_update(witsensor_ahrs_t *ahrs, const float *g, const float *a, const float *m, float dt) {
+    float *q = ahrs->q;
+    float qdot[4] = {
+        0.5f * (-q[1] * g[0] - q[2] * g[1] - q[3] * g[2]),
+        0.5f * ( q[0] * g[0] + q[2] * g[2] - q[3] * g[1]),
+        0.5f * ( q[0] * g[1] - q[1] * g[2] + q[3] * g[0]),
+        0.5f * ( q[0] * g[2] + q[1] * g[1] - q[2] * g[0]),
+    };
+    if (a) {
+        float s[4];
+        witsensor_madgwick_step(q, a, m, s);
+        for (int i = 0; i < 4; i++) qdot[i] -= ahrs->gain * s[i];
+    }
+    for (int i = 0; i < 4; i++) q[i] += qdot[i] * dt;
+    witsensor_ahrs_normalise4(q);
+}
+
+static void witsensor_mahony_update(witsensor_ahrs_t *ahrs, const float *g, const float *a, const float *m, float dt) {
+    float *q = ahrs->q;
+    float gx = g[0], gy = g[1], gz = g[2];
+    if (a) {
+        float q0q0 = q[0] * q[0], q0q1 = q[0] * q[1], q0q2 = q[0] * q[2], q0q3 = q[0] * q[3];
+        float q1q1 = q[1] * q[1], q1q2 = q[1] * q[2], q1q3 = q[1] * q[3];
+        float q2q2 = q[2] * q[2], q2q3 = q[2] * q[3], q3q3 = q[3] * q[3];
+        // Estimated gravity direction (half) and error against the measured one
+        float vx = q1q3 - q0q2, vy = q0q1 + q2q3, vz = q0q0 - 0.5f + q3q3;
+        float ex = a[1] * vz - a[2] * vy;
+        float ey = a[2] * vx - a[0] * vz;
+        float ez = a[0] * vy - a[1] * vx;
+        if (m) {
+            float mx = m[0], my = m[1], mz = m[2];
+            float hx = 2.0f * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            float hy = 2.0f * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+            float bx = sqrtf(hx * hx + hy * hy);
+            float bz = 2.0f * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+            float wx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+            float wy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+            float wz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+            ex += my * wz - mz * wy;
+            ey += mz * wx - mx * wz;
+            ez += mx * wy - my * wx;
+        }
+        if (ahrs->gain_i > 0.0f) {
+            ahrs->bias[0] += 2.0f * ahrs->gain_i * ex * dt;
+            ahrs->bias[1] += 2.0f * ahrs->gain_i * ey * dt;
+            ahrs->bias[2] += 2.0f * ahrs->gain_i * ez * dt;
+            gx += ahrs->bias[0];
+            gy += ahrs->bias[1];
+            gz += ahrs->bias[2];
+        }
+        gx += 2.0f * ahrs->gain * ex;
+        gy += 2.0f * ahrs->gain * ey;
+        gz += 2.0f * ahrs->gain * ez;
+    }
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+    float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    q[0] += -q1 * gx - q2 * gy - q3 * gz;
+    q[1] += q0 * gx + q2 * gz - q3 * gy;
+    q[2] += q0 * gy - q1 * gz + q3 * gx;
+    q[3] += q0 * gz + q1 * gy - q2 * gx;
+    witsensor_ahrs_normalise4(q);
+}
+
+void witsensor_ahrs_update(witsensor_ahrs_t *ahrs, const float *gyro_dps, const float *accel_g,
+                           float dt, uint64_t now_ns, float *q) {
+    if (!ahrs || !gyro_dps || !accel_g) return;
+    if (!(dt > 0.0f)) dt = 0.0f;
+    if (dt > WITSENSOR_AHRS_MAX_DT) dt = WITSENSOR_AHRS_MAX_DT;
+    float g[3] = {
+        gyro_dps[0] * WITSENSOR_AHRS_DEG_TO_RAD,
+        gyro_dps[1] * WITSENSOR_AHRS_DEG_TO_RAD,
+        gyro_dps[2] * WITSENSOR_AHRS_DEG_TO_RAD,
+    };
+    float a[3] = { accel_g[0], accel_g[1], accel_g[2] };
+    float m[3] = { ahrs->mag[0], ahrs->mag[1], ahrs->mag[2] };
+    int have_a = witsensor_ahrs_normalise3(a);
+    int have_m = ahrs->mag_ns && now_ns >= ahrs->mag_ns
+        && (double)(now_ns - ahrs->mag_ns) / 1e6 <= WITSENSOR_AHRS_MAG_MAX_AGE_MS
+        && witsensor_ahrs_normalise3(m);
+    if (!ahrs->started && have_a) {
+        witsensor_ahrs_seed(ahrs, a, have_m ? m : NULL);
+        ahrs->started = 1;
+    } else if (ahrs->algorithm == WITSENSOR_AHRS_MAHONY) {
+        witsensor_mahony_update(ahrs, g, have_a ? a : NULL, have_a && have_m ? m : NULL, dt);
+    } else {
+        witsensor_madgwick_update(ahrs, g, have_a ? a : NULL, have_a && have_m ? m : NULL, dt);
+    }
+    ahrs->updates++;
+    if (q) memcpy(q, ahrs->q, sizeof(ahrs->q));
+}
+
+void witsensor_ahrs_shared_init(witsensor_ahrs_shared_t *shared, const witsensor_ahrs_settings_t *settings) {
+    if (!shared || !settings) return;
+    atomic_init(&shared->seq, 0);
+    for (size_t i = 0; i < WITSENSOR_AHRS_SETTINGS_WORDS; i++) atomic_init(&shared->words[i], 0);
+    witsensor_ahrs_shared_store(shared, settings);
+}
+
+void witsensor_ahrs_shared_store(witsensor_ahrs_shared_t *shared, const witsensor_ahrs_settings_t *settings) {
+    if (!shared || !settings) return;
+    uint32_t buf[WITSENSOR_AHRS_SETTINGS_WORDS] = {0};
+    memcpy(buf, settings, sizeof(*settings));
+
+    uint32_t seq = atomic_load_explicit(&shared->seq, memory_order_relaxed);
+    atomic_store_explicit(&shared->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < WITSENSOR_AHRS_SETTINGS_WORDS; i++) {
+        atomic_store_explicit(&shared->words[i], buf[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&shared->seq, seq + 2, memory_order_release);
+}
+
+int witsensor_ahrs_shared_load(witsensor_ahrs_shared_t *shared, witsensor_ahrs_settings_t *settings, uint32_t *seen) {
+    if (!shared || !settings || !seen) return 0;
+    uint32_t buf[WITSENSOR_AHRS_SETTINGS_WORDS];
+    uint32_t before;
+    for (;;) {
+        before = atomic_load_explicit(&shared->seq, memory_order_acquire);
+        if (before == *seen) return 0;
+        if (before & 1) continue; // writer active
+        for (size_t i = 0; i < WITSENSOR_AHRS_SETTINGS_WORDS; i++) {
+            buf[i] = atomic_load_explicit(&shared->words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shared->seq, memory_order_relaxed) == before) break;
+    }
+    memcpy(settings, buf, sizeof(*settings));
+    *seen = before;
+    return 1;
+}
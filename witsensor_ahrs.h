@@ -0,0 +1,82 @@
+/* witsensor_ahrs.h
+ * Host-side orientation fusion (Madgwick or Mahony) from streamed accel/gyro,
+ * with the magnetometer when register reads supply it
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_AHRS_H
+#define WITSENSOR_AHRS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_AHRS_MADGWICK_BETA 0.1f  // gradient step gain
+#define WITSENSOR_AHRS_MAHONY_KP 0.5f      // proportional gain
+#define WITSENSOR_AHRS_MAHONY_KI 0.0f      // integral gain (gyro bias)
+#define WITSENSOR_AHRS_MAG_MAX_AGE_MS 1000.0 // older magnetometer readings are ignored
+#define WITSENSOR_AHRS_MAX_DT 0.1f         // longer steps (gaps, restarts) are clamped
+
+typedef enum {
+    WITSENSOR_AHRS_OFF = 0,
+    WITSENSOR_AHRS_MADGWICK = 1,
+    WITSENSOR_AHRS_MAHONY = 2
+} witsensor_ahrs_algorithm_t;
+
+typedef struct witsensor_ahrs_t {
+    witsensor_ahrs_algorithm_t algorithm;
+    float gain;              // Madgwick beta or Mahony kp
+    float gain_i;            // Mahony ki
+    float q[4];              // orientation w x y z, sensor to earth
+    float bias[3];           // Mahony integral feedback (rad/s)
+    int started;             // seeded from the first accelerometer reading
+    float mag[3];            // newest magnetometer reading, any unit
+    uint64_t mag_ns;         // host time of mag, 0: none
+    uint64_t updates;
+} witsensor_ahrs_t;
+
+// Filter settings as chosen on the control thread
+typedef struct witsensor_ahrs_settings_t {
+    witsensor_ahrs_algorithm_t algorithm;
+    float gain;
+    float gain_i;
+    float period;            // s per frame without device timestamps
+    uint32_t reset;          // bumped to start the filter over
+} witsensor_ahrs_settings_t;
+
+#define WITSENSOR_AHRS_SETTINGS_WORDS ((sizeof(witsensor_ahrs_settings_t) + 3) / 4)
+
+// Settings handed to the fusion thread(s): seqlock with one writer, readers
+// copy a consistent block without locking (as witsensor_snapshot)
+typedef struct witsensor_ahrs_shared_t {
+    _Atomic uint32_t seq;    // odd while the writer is updating
+    _Atomic uint32_t words[WITSENSOR_AHRS_SETTINGS_WORDS];
+} witsensor_ahrs_shared_t;
+
+// Publish settings as the first version (seq 2, so readers starting from 0 pick it up)
+void witsensor_ahrs_shared_init(witsensor_ahrs_shared_t *shared, const witsensor_ahrs_settings_t *settings);
+// Writer side
+void witsensor_ahrs_shared_store(witsensor_ahrs_shared_t *shared, const witsensor_ahrs_settings_t *settings);
+// Reader side: if the settings changed since *seen, copy them, update *seen
+// and return 1; otherwise return 0
+int witsensor_ahrs_shared_load(witsensor_ahrs_shared_t *shared, witsensor_ahrs_settings_t *settings, uint32_t *seen);
+
+// Reset to identity; gains <= 0 take the defaults above
+void witsensor_ahrs_init(witsensor_ahrs_t *ahrs, witsensor_ahrs_algorithm_t algorithm, float gain, float gain_i);
+// Newest magnetometer reading (e.g. register 0x3A) and its host time
+void witsensor_ahrs_set_mag(witsensor_ahrs_t *ahrs, const float *mag, uint64_t now_ns);
+// One step: gyro in deg/s, accel in g, dt in s. Uses the magnetometer if it
+// is fresh at now_ns. Writes the orientation to q (w x y z).
+void witsensor_ahrs_update(witsensor_ahrs_t *ahrs, const float *gyro_dps, const float *accel_g,
+                           float dt, uint64_t now_ns, float *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_AHRS_H
@@ -0,0 +1,60 @@
+/* witsensor_ble_backend.h
+ * Backend table behind the witsensor_ble_simpleble API
+ * Scan hub, result caches, claims and the connect worker are backend-neutral;
+ * a backend drives the radio (SimpleBLE) or simulates it (witsensor_ble_mock.c)
+ * and reports its events through the witsensor_ble_hub_* entry points
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_BLE_BACKEND_H
+#define WITSENSOR_BLE_BACKEND_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct witsensor_ble_simpleble_t;
+
+// Peripherals are opaque handles that a backend passes to
+// witsensor_ble_hub_scan_found; the hub gives each one back through release
+typedef struct witsensor_ble_backend_t {
+    const char *name;
+    // Bring up the adapter; returns its handle, or NULL with a reason in err
+    void *(*open)(char *err, size_t errsize);
+    int (*enabled)(void);                   // radio switched on
+    int (*scan_start)(void);                // 1 on success
+    void (*scan_stop)(void);
+    // Connect and subscribe ble to notifications and link loss; blocking, 1 on success
+    int (*connect)(void *peripheral, struct witsensor_ble_simpleble_t *ble);
+    // Drop the link; no callbacks for it once this returns
+    void (*disconnect)(void *peripheral);
+    // Write to the WIT write characteristic, as request (with response) or command
+    int (*write)(void *peripheral, const unsigned char *data, int length, int request);
+    int (*notify)(void *peripheral, struct witsensor_ble_simpleble_t *ble, int enabled);
+    void (*release)(void *peripheral);      // called with the hub lock held
+    void (*close)(void);                    // the last object is gone
+} witsensor_ble_backend_t;
+
+#ifndef WITSENSOR_BLE_MOCK_ONLY
+extern const witsensor_ble_backend_t witsensor_ble_simpleble_backend;
+#endif
+extern const witsensor_ble_backend_t witsensor_ble_mock_backend;
+
+// Backend events, from any thread; none may be called with backend locks
+// that release or other calls made under the hub lock would take
+void witsensor_ble_hub_scan_started(const char *adapter_id, const char *adapter_addr);
+void witsensor_ble_hub_scan_stopped(void);
+// An advertisement: the hub takes over the peripheral handle
+void witsensor_ble_hub_scan_found(void *peripheral, const char *id, const char *addr, int rssi);
+void witsensor_ble_hub_notified(struct witsensor_ble_simpleble_t *ble, const unsigned char *data, int length);
+void witsensor_ble_hub_link_lost(struct witsensor_ble_simpleble_t *ble);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_BLE_BACKEND_H
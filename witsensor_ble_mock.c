@@ -0,0 +1,493 @@
+/* witsensor_ble_mock.c
+ * Simulated WIT sensors behind the BLE backend table (witsensor_ble_backend.h)
+ *
+ * One thread runs every sensor: it advertises the unconnected ones while a
+ * scan is on and, for each link, generates 0x61 frames on the sensor's own
+ * (drifting) clock at the configured rate. Frames are lost at the configured
+ * rate, delayed by up to the jitter and then held for the next connection
+ * event, so they arrive in bursts like on a real link. Register reads are
+ * answered in the same queue. All callbacks into the hub are made with the
+ * mock lock held, so once disconnect returns no callback for that link runs.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_ble_mock.h"
+#include "witsensor_ble_backend.h"
+#include "witsensor_platform.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_BYTES 20
+#define PENDING 64                       // notifications in flight per link
+#define ADVERTISE_NS 500000000ull        // advertising interval
+#define CATCH_UP_NS 1000000000ull        // a stalled stream skips ahead beyond this
+#define PI 3.14159265358979323846
+
+typedef struct witsensor_ble_mock_pending_t {
+    uint64_t due_ns;
+    unsigned char data[FRAME_BYTES];
+} witsensor_ble_mock_pending_t;
+
+typedef struct witsensor_ble_mock_device_t {
+    int index;
+    char id[32];
+    char addr[24];
+    int rssi;
+    struct witsensor_ble_simpleble_t *link; // connected object, NULL: advertising
+    int notify;                             // notifications subscribed
+    uint16_t regs[256];                     // register file (0xFF 0xAA writes, 0x27 reads)
+    double rate_hz;
+    uint64_t boot_ns;                       // sensor clock origin
+    double drift;                           // sensor clock rate - 1
+    uint64_t phase_ns;                      // connection event offset
+    uint64_t next_frame_ns;
+    uint64_t last_due_ns;                   // notifications stay in order
+    uint64_t drop_ns;                       // spontaneous link drop, 0: none
+    witsensor_ble_mock_pending_t pending[PENDING];
+    int head;
+    int count;
+    uint32_t rng;
+} witsensor_ble_mock_device_t;
+
+static struct {
+    witsensor_mutex_t lock;                 // guards everything below
+    witsensor_thread_t thread;
+    int running;
+    int stop;
+    int configured;                         // WITSENSOR_MOCK applied
+    int scanning;
+    uint64_t next_advertise_ns;
+    int drop_all;
+    // Settings (witsensor_ble_mock.h)
+    int devices;
+    double jitter_ms;
+    double loss;
+    double disconnect_s;
+    double connect_ms;
+    double interval_ms;
+    double drift_ppm;
+    witsensor_ble_mock_device_t device[WITSENSOR_BLE_MOCK_MAX_DEVICES];
+} mock = {
+    .lock = WITSENSOR_MUTEX_INIT,
+    .devices = 4,
+    .jitter_ms = 2.0,
+    .connect_ms = 30.0,
+    .interval_ms = 7.5,
+    .drift_ppm = 50.0,
+};
+
+// Uniform in [0, 1)
+static double witsensor_ble_mock_random(witsensor_ble_mock_device_t *dev) {
+    uint32_t x = dev->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    dev->rng = x;
+    return (double)x / 4294967296.0;
+}
+
+// Stream rate of register 0x03 codes
+static double witsensor_ble_mock_rate(unsigned int code) {
+    static const double rates[] = { 10, 0.1, 0.5, 1, 2, 5, 10, 20, 50, 100, 125, 200 };
+    return code < sizeof(rates) / sizeof(rates[0]) ? rates[code] : 10;
+}
+
+static witsensor_ble_mock_device_t *witsensor_ble_mock_device(int index) {
+    witsensor_ble_mock_device_t *dev = &mock.device[index];
+    if (dev->id[0]) return dev;
+    dev->index = index;
+    snprintf(dev->id, sizeof(dev->id), "WT901BLE-MOCK%03d", index);
+    snprintf(dev->addr, sizeof(dev->addr), "4D:4F:43:4B:%02X:%02X", (index >> 8) & 0xFF, index & 0xFF);
+    dev->rng = 2463534242u + (uint32_t)index * 2654435761u;
+    dev->rssi = -40 - (int)(witsensor_ble_mock_random(dev) * 50);
+    dev->boot_ns = witsensor_now_ns() - (uint64_t)(witsensor_ble_mock_random(dev) * 1e12);
+    dev->drift = (witsensor_ble_mock_random(dev) * 2 - 1) * mock.drift_ppm * 1e-6;
+    dev->phase_ns = (uint64_t)(witsensor_ble_mock_random(dev) * mock.interval_ms * 1e6);
+    dev->regs[0x03] = 0x06;               // 10 Hz
+    dev->regs[0x1F] = 0x00;               // 256 Hz bandwidth
+    dev->regs[0x24] = 0x00;               // 9-axis
+    dev->regs[0x2E] = 0x5A0E;             // version
+    dev->regs[0x2F] = 0x0001;
+    dev->regs[0x40] = 2650;               // 26.5 degC
+    dev->regs[0x64] = 395;                // 3.95 V
+    dev->rate_hz = witsensor_ble_mock_rate(dev->regs[0x03]);
+    return dev;
+}
+
+static int16_t witsensor_ble_mock_word(double value, double range) {
+    double v = value / range * 32768.0;
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    return (int16_t)lrint(v);
+}
+
+static void witsensor_ble_mock_put(unsigned char *at, int16_t w) {
+    at[0] = (unsigned char)(w & 0xFF);
+    at[1] = (unsigned char)((uint16_t)w >> 8);
+}
+
+// Sensor pose at host time t_ns: a slow wobble while turning about z
+static void witsensor_ble_mock_pose(const witsensor_ble_mock_device_t *dev, uint64_t t_ns, double angle[3], double rate[3]) {
+    double t = (double)(t_ns - dev->boot_ns) / 1e9;
+    double w0 = 2 * PI * 0.25, w1 = 2 * PI * 0.1;
+    angle[0] = 20 * sin(w0 * t + dev->index);
+    angle[1] = 10 * sin(w1 * t);
+    angle[2] = fmod(18 * t + 180, 360) - 180;
+    rate[0] = 20 * w0 * cos(w0 * t + dev->index);
+    rate[1] = 10 * w1 * cos(w1 * t);
+    rate[2] = 18;
+}
+
+// Queue a notification for the first connection event after due_ns
+static void witsensor_ble_mock_send(witsensor_ble_mock_device_t *dev, uint64_t due_ns, const unsigned char *data) {
+    if (dev->count == PENDING) return; // link congested: lost
+    uint64_t interval = (uint64_t)(mock.interval_ms * 1e6);
+    if (interval) due_ns = dev->phase_ns + ((due_ns - dev->phase_ns + interval - 1) / interval) * interval;
+    if (due_ns < dev->last_due_ns) due_ns = dev->last_due_ns;
+    dev->last_due_ns = due_ns;
+    witsensor_ble_mock_pending_t *p = &dev->pending[(dev->head + dev->count) % PENDING];
+    p->due_ns = due_ns;
+    memcpy(p->data, data, FRAME_BYTES);
+    dev->count++;
+}
+
+// One 0x61 frame sampled at gen_ns in the output mode of register 0x96
+static void witsensor_ble_mock_frame(witsensor_ble_mock_device_t *dev, uint64_t gen_ns, unsigned char *frame) {
+    double angle[3], rate[3];
+    witsensor_ble_mock_pose(dev, gen_ns, angle, rate);
+    int mode = dev->regs[0x96] & 3;
+    frame[0] = 0x55;
+    frame[1] = 0x61;
+    if (mode & 1) {
+        // Displacement and speed: the sensor is not moving
+        memset(frame + 2, 0, 12);
+    } else {
+        double r = angle[0] * PI / 180, p = angle[1] * PI / 180;
+        witsensor_ble_mock_put(frame + 2, witsensor_ble_mock_word(-sin(p), 16));
+        witsensor_ble_mock_put(frame + 4, witsensor_ble_mock_word(sin(r) * cos(p), 16));
+        witsensor_ble_mock_put(frame + 6, witsensor_ble_mock_word(cos(r) * cos(p), 16));
+        for (int i = 0; i < 3; i++) witsensor_ble_mock_put(frame + 8 + 2 * i, witsensor_ble_mock_word(rate[i], 2000));
+    }
+    if (mode & 2) {
+        // Milliseconds on the sensor's own clock
+        uint32_t ms = (uint32_t)((double)(gen_ns - dev->boot_ns) * (1 + dev->drift) / 1e6);
+        witsensor_ble_mock_put(frame + 14, (int16_t)(ms & 0xFFFF));
+        witsensor_ble_mock_put(frame + 16, (int16_t)(ms >> 16));
+    } else {
+        witsensor_ble_mock_put(frame + 14, witsensor_ble_mock_word(angle[0], 180));
+        witsensor_ble_mock_put(frame + 16, witsensor_ble_mock_word(angle[1], 180));
+    }
+    witsensor_ble_mock_put(frame + 18, witsensor_ble_mock_word(angle[2], 180));
+}
+
+// Refresh the registers that follow the pose or the wall clock
+static void witsensor_ble_mock_live_registers(witsensor_ble_mock_device_t *dev, uint64_t now) {
+    double angle[3], rate[3];
+    witsensor_ble_mock_pose(dev, now, angle, rate);
+    double cr = cos(angle[0] * PI / 360), sr = sin(angle[0] * PI / 360);
+    double cp = cos(angle[1] * PI / 360), sp = sin(angle[1] * PI / 360);
+    double cy = cos(angle[2] * PI / 360), sy = sin(angle[2] * PI / 360);
+    double q[4] = {
+        cr * cp * cy + sr * sp * sy,
+        sr * cp * cy - cr * sp * sy,
+        cr * sp * cy + sr * cp * sy,
+        cr * cp * sy - sr * sp * cy,
+    };
+    for (int i = 0; i < 4; i++) dev->regs[0x51 + i] = (uint16_t)witsensor_ble_mock_word(q[i], 1);
+    // Earth field (about 0.5 G) turning with the heading, 150 counts per uT
+    double yaw = angle[2] * PI / 180;
+    dev->regs[0x3A] = (uint16_t)(int16_t)lrint(150 * 20 * cos(yaw));
+    dev->regs[0x3B] = (uint16_t)(int16_t)lrint(-150 * 20 * sin(yaw));
+    dev->regs[0x3C] = (uint16_t)(int16_t)lrint(-150 * 45);
+    time_t t = time(NULL);
+    struct tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    dev->regs[0x30] = (uint16_t)((tm.tm_year % 100) | ((tm.tm_mon + 1) << 8));
+    dev->regs[0x31] = (uint16_t)(tm.tm_mday | (tm.tm_hour << 8));
+    dev->regs[0x32] = (uint16_t)(tm.tm_min | (tm.tm_sec << 8));
+    dev->regs[0x33] = 0;
+}
+
+// Answer 0x27 <reg>: 0x55 0x71 <reg> 0x00 and eight registers from reg on
+static void witsensor_ble_mock_read(witsensor_ble_mock_device_t *dev, unsigned int reg, uint64_t now) {
+    unsigned char frame[FRAME_BYTES];
+    witsensor_ble_mock_live_registers(dev, now);
+    frame[0] = 0x55;
+    frame[1] = 0x71;
+    frame[2] = (unsigned char)reg;
+    frame[3] = 0x00;
+    for (unsigned int i = 0; i < 8; i++) witsensor_ble_mock_put(frame + 4 + 2 * i, (int16_t)dev->regs[(reg + i) & 0xFF]);
+    witsensor_ble_mock_send(dev, now + (uint64_t)(mock.interval_ms * 1e6), frame);
+}
+
+static void witsensor_ble_mock_unlink(witsensor_ble_mock_device_t *dev) {
+    dev->link = NULL;
+    dev->notify = 0;
+    dev->count = 0;
+    dev->drop_ns = 0;
+}
+
+static void witsensor_ble_mock_schedule_drop(witsensor_ble_mock_device_t *dev, uint64_t now) {
+    dev->drop_ns = 0;
+    if (mock.disconnect_s <= 0) return;
+    double wait_s = -log(1 - witsensor_ble_mock_random(dev)) * mock.disconnect_s;
+    dev->drop_ns = now + (uint64_t)(wait_s * 1e9) + 1;
+}
+
+// Generate due frames of one link and deliver the notifications whose connection event has come
+static void witsensor_ble_mock_stream(witsensor_ble_mock_device_t *dev, uint64_t now) {
+    if (mock.drop_all || (dev->drop_ns && now >= dev->drop_ns)) {
+        struct witsensor_ble_simpleble_t *ble = dev->link;
+        witsensor_ble_mock_unlink(dev);
+        witsensor_ble_hub_link_lost(ble);
+        return;
+    }
+    double period_ns = 1e9 / dev->rate_hz / (1 + dev->drift);
+    if (now > dev->next_frame_ns + CATCH_UP_NS) dev->next_frame_ns = now;
+    while (dev->next_frame_ns <= now) {
+        uint64_t gen = dev->next_frame_ns;
+        dev->next_frame_ns = gen + (uint64_t)period_ns;
+        if (witsensor_ble_mock_random(dev) < mock.loss) continue;
+        unsigned char frame[FRAME_BYTES];
+        witsensor_ble_mock_frame(dev, gen, frame);
+        witsensor_ble_mock_send(dev, gen + (uint64_t)(witsensor_ble_mock_random(dev) * mock.jitter_ms * 1e6), frame);
+    }
+    while (dev->count && dev->pending[dev->head].due_ns <= now) {
+        witsensor_ble_mock_pending_t *p = &dev->pending[dev->head];
+        if (dev->notify) witsensor_ble_hub_notified(dev->link, p->data, FRAME_BYTES);
+        dev->head = (dev->head + 1) % PENDING;
+        dev->count--;
+    }
+}
+
+static void witsensor_ble_mock_main(void *arg) {
+    (void)arg;
+    witsensor_mutex_lock(&mock.lock);
+    while (!mock.stop) {
+        uint64_t now = witsensor_now_ns();
+        if (mock.scanning && now >= mock.next_advertise_ns) {
+            mock.next_advertise_ns = now + ADVERTISE_NS;
+            for (int i = 0; i < mock.devices; i++) {
+                witsensor_ble_mock_device_t *dev = witsensor_ble_mock_device(i);
+                int rssi = dev->rssi + (int)(witsensor_ble_mock_random(dev) * 6) - 3;
+                if (!dev->link) witsensor_ble_hub_scan_found(dev, dev->id, dev->addr, rssi);
+            }
+        }
+        for (int i = 0; i < WITSENSOR_BLE_MOCK_MAX_DEVICES; i++) {
+            if (mock.device[i].link) witsensor_ble_mock_stream(&mock.device[i], now);
+        }
+        mock.drop_all = 0;
+        witsensor_mutex_unlock(&mock.lock);
+        witsensor_sleep_ms(1);
+        witsensor_mutex_lock(&mock.lock);
+    }
+    witsensor_mutex_unlock(&mock.lock);
+}
+
+// Callers hold the mock lock
+static void witsensor_ble_mock_start(void) {
+    if (mock.running) return;
+    mock.stop = 0;
+    mock.running = witsensor_thread_start(&mock.thread, witsensor_ble_mock_main, NULL);
+}
+
+static void *witsensor_ble_mock_open(char *err, size_t errsize) {
+    witsensor_mutex_lock(&mock.lock);
+    int configured = mock.configured;
+    mock.configured = 1;
+    witsensor_mutex_unlock(&mock.lock);
+    if (!configured && !witsensor_ble_mock_configure(getenv("WITSENSOR_MOCK"))) {
+        snprintf(err, errsize, "mock BLE: unknown setting in WITSENSOR_MOCK");
+        return NULL;
+    }
+    witsensor_mutex_lock(&mock.lock);
+    witsensor_ble_mock_start();
+    int running = mock.running;
+    witsensor_mutex_unlock(&mock.lock);
+    if (!running) {
+        snprintf(err, errsize, "mock BLE: can't start the simulation thread");
+        return NULL;
+    }
+    return &mock;
+}
+
+static int witsensor_ble_mock_enabled(void) {
+    return 1;
+}
+
+static int witsensor_ble_mock_scan_start(void) {
+    witsensor_mutex_lock(&mock.lock);
+    witsensor_ble_mock_start();
+    mock.scanning = 1;
+    mock.next_advertise_ns = 0;
+    int running = mock.running;
+    witsensor_mutex_unlock(&mock.lock);
+    if (running) witsensor_ble_hub_scan_started("mock", "4D:4F:43:4B:FF:FF");
+    return running;
+}
+
+static void witsensor_ble_mock_scan_stop(void) {
+    witsensor_mutex_lock(&mock.lock);
+    mock.scanning = 0;
+    witsensor_mutex_unlock(&mock.lock);
+    witsensor_ble_hub_scan_stopped();
+}
+
+static int witsensor_ble_mock_connect(void *peripheral, struct witsensor_ble_simpleble_t *ble) {
+    witsensor_ble_mock_device_t *dev = (witsensor_ble_mock_device_t *)peripheral;
+    witsensor_mutex_lock(&mock.lock);
+    unsigned int wait_ms = (unsigned int)mock.connect_ms;
+    witsensor_mutex_unlock(&mock.lock);
+    witsensor_sleep_ms(wait_ms);
+    witsensor_mutex_lock(&mock.lock);
+    // One central per sensor; sensors beyond 'devices' are switched off
+    int ok = !dev->link && dev->index < mock.devices;
+    if (ok) {
+        witsensor_ble_mock_start();
+        uint64_t now = witsensor_now_ns();
+        dev->link = ble;
+        dev->notify = 1;
+        dev->count = 0;
+        dev->last_due_ns = 0;
+        dev->next_frame_ns = now;
+        witsensor_ble_mock_schedule_drop(dev, now);
+    }
+    witsensor_mutex_unlock(&mock.lock);
+    return ok;
+}
+
+static void witsensor_ble_mock_disconnect(void *peripheral) {
+    witsensor_mutex_lock(&mock.lock);
+    witsensor_ble_mock_unlink((witsensor_ble_mock_device_t *)peripheral);
+    witsensor_mutex_unlock(&mock.lock);
+}
+
+// 0xFF 0xAA <reg> <lo> <hi> commands, several per write allowed
+static int witsensor_ble_mock_write(void *peripheral, const unsigned char *data, int length, int request) {
+    (void)request;
+    witsensor_ble_mock_device_t *dev = (witsensor_ble_mock_device_t *)peripheral;
+    witsensor_mutex_lock(&mock.lock);
+    int ok = dev->link != NULL;
+    uint64_t now = witsensor_now_ns();
+    for (int i = 0; ok && i + 5 <= length; i += 5) {
+        if (data[i] != 0xFF || data[i + 1] != 0xAA) break;
+        unsigned int reg = data[i + 2];
+        uint16_t value = (uint16_t)(data[i + 3] | (data[i + 4] << 8));
+        if (reg == 0x27) {
+            witsensor_ble_mock_read(dev, value & 0xFF, now);
+            continue;
+        }
+        dev->regs[reg] = value;
+        if (reg == 0x03) {
+            dev->rate_hz = witsensor_ble_mock_rate(value);
+            dev->next_frame_ns = now;
+        }
+    }
+    witsensor_mutex_unlock(&mock.lock);
+    return ok;
+}
+
+static int witsensor_ble_mock_notify(void *peripheral, struct witsensor_ble_simpleble_t *ble, int enabled) {
+    witsensor_ble_mock_device_t *dev = (witsensor_ble_mock_device_t *)peripheral;
+    witsensor_mutex_lock(&mock.lock);
+    int ok = dev->link == ble;
+    if (ok) dev->notify = enabled;
+    witsensor_mutex_unlock(&mock.lock);
+    return ok;
+}
+
+// Sensors live as long as the process
+static void witsensor_ble_mock_release(void *peripheral) {
+    (void)peripheral;
+}
+
+static void witsensor_ble_mock_close(void) {
+    witsensor_mutex_lock(&mock.lock);
+    int join = mock.running;
+    mock.stop = 1;
+    mock.running = 0;
+    witsensor_mutex_unlock(&mock.lock);
+    if (join) witsensor_thread_join(mock.thread);
+    witsensor_mutex_lock(&mock.lock);
+    for (int i = 0; i < WITSENSOR_BLE_MOCK_MAX_DEVICES; i++) witsensor_ble_mock_unlink(&mock.device[i]);
+    mock.scanning = 0;
+    witsensor_mutex_unlock(&mock.lock);
+}
+
+const witsensor_ble_backend_t witsensor_ble_mock_backend = {
+    "mock",
+    witsensor_ble_mock_open,
+    witsensor_ble_mock_enabled,
+    witsensor_ble_mock_scan_start,
+    witsensor_ble_mock_scan_stop,
+    witsensor_ble_mock_connect,
+    witsensor_ble_mock_disconnect,
+    witsensor_ble_mock_write,
+    witsensor_ble_mock_notify,
+    witsensor_ble_mock_release,
+    witsensor_ble_mock_close,
+};
+
+int witsensor_ble_mock_set(const char *key, double value) {
+    if (!key) return 0;
+    int known = 1;
+    witsensor_mutex_lock(&mock.lock);
+    if (strcmp(key, "devices") == 0) {
+        int n = (int)value;
+        mock.devices = n < 0 ? 0 : n > WITSENSOR_BLE_MOCK_MAX_DEVICES ? WITSENSOR_BLE_MOCK_MAX_DEVICES : n;
+    } else if (strcmp(key, "jitter") == 0) {
+        mock.jitter_ms = value > 0 ? value : 0;
+    } else if (strcmp(key, "loss") == 0) {
+        mock.loss = value < 0 ? 0 : value > 1 ? 1 : value;
+    } else if (strcmp(key, "disconnect") == 0) {
+        mock.disconnect_s = value > 0 ? value : 0;
+        uint64_t now = witsensor_now_ns();
+        for (int i = 0; i < WITSENSOR_BLE_MOCK_MAX_DEVICES; i++) {
+            if (mock.device[i].link) witsensor_ble_mock_schedule_drop(&mock.device[i], now);
+        }
+    } else if (strcmp(key, "connect") == 0) {
+        mock.connect_ms = value > 0 ? value : 0;
+    } else if (strcmp(key, "interval") == 0) {
+        mock.interval_ms = value > 0 ? value : 0;
+    } else if (strcmp(key, "drift") == 0) {
+        mock.drift_ppm = value > 0 ? value : 0;
+    } else if (strcmp(key, "drop") == 0) {
+        mock.drop_all = 1;
+    } else {
+        known = 0;
+    }
+    witsensor_mutex_unlock(&mock.lock);
+    return known;
+}
+
+int witsensor_ble_mock_configure(const char *spec) {
+    if (!spec) return 1;
+    int ok = 1;
+    char key[32];
+    while (*spec) {
+        while (*spec == ' ' || *spec == ',') spec++;
+        if (!*spec) break;
+        size_t n = strcspn(spec, "= ,");
+        snprintf(key, sizeof(key), "%.*s", (int)(n < sizeof(key) - 1 ? n : sizeof(key) - 1), spec);
+        spec += n;
+        double value = 0;
+        if (*spec == '=') {
+            char *end;
+            value = strtod(spec + 1, &end);
+            spec = end;
+        }
+        if (!witsensor_ble_mock_set(key, value)) ok = 0;
+        spec += strcspn(spec, " ,");
+    }
+    return ok;
+}
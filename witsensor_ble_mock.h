@@ -0,0 +1,40 @@
+/* witsensor_ble_mock.h
+ * Simulated WIT sensors behind the BLE backend table (witsensor_ble_backend.h)
+ * Selected by building with WITSENSOR_BLE_MOCK_ONLY (make ble=mock) or by
+ * running with WITSENSOR_BLE=mock. The sensors advertise, accept one link
+ * each, answer 0xFF 0xAA register writes and 0x27 reads with 0x71 frames and
+ * stream 0x61 frames at the configured rate and output mode.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_BLE_MOCK_H
+#define WITSENSOR_BLE_MOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_BLE_MOCK_MAX_DEVICES 256
+
+// Settings, also taken from WITSENSOR_MOCK ("devices=200 jitter=5 loss=0.01")
+// when the backend opens:
+//   devices     sensors advertising (default 4)
+//   jitter      extra notification delay, uniform up to this many ms (2)
+//   loss        fraction of frames lost on the link (0)
+//   disconnect  mean seconds between spontaneous link drops, 0: never (0)
+//   connect     ms a connect takes (30)
+//   interval    connection interval in ms; notifications leave in bursts (7.5)
+//   drift       device clocks run off by up to +- this many ppm (50)
+//   drop        drop every link now (value ignored)
+// Returns 1 if key is known
+int witsensor_ble_mock_set(const char *key, double value);
+// Apply "key=value" pairs separated by spaces or commas; returns 0 on an unknown key
+int witsensor_ble_mock_configure(const char *spec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_BLE_MOCK_H
@@ -1,6 +1,8 @@
 /* witsensor_ble_simpleble.c
  * Cross-platform BLE implementation using SimpleBLE
  * Supports macOS, Windows, and Linux
+ * Scan hub, result caches and connect worker run over a backend table
+ * (witsensor_ble_backend.h): SimpleBLE, or the simulated sensors of witsensor_ble_mock.c
  * 
  * Copyright (c) 2025 pd-witsensor contributors
  * Licensed under Business Source License 1.1 (BUSL-1.1)
@@ -8,6 +10,8 @@
  */
 
 #include "witsensor_ble_simpleble.h"
+#include "witsensor_ble_backend.h"
+#include "witsensor_platform.h"
 #include "m_pd.h"
 #include <string.h>
 #include <stdlib.h>
@@ -20,57 +24,172 @@
     #include <pthread.h>
 #endif
 
+#ifndef WITSENSOR_BLE_MOCK_ONLY
 // SimpleBLE includes - use simplecble headers directly
 #include <simplecble/simpleble.h>
+#endif
 #include "m_pd.h"
 // Pd-thread handler to announce scan completion and print cached devices
 extern void witsensor_pd_scan_complete_handler(t_pd *obj, void *data);
 // Forward declarations for Pd-thread status handlers and payloads
-typedef struct _queued_flag { int value; } t_queued_flag;
-typedef struct _queued_device { char *tag; char *addr; char *id; } t_queued_device;
+typedef struct _queued_flag { int value; int index; char *target; char *reason; } t_queued_flag;
+typedef struct _queued_device { char *tag; char *addr; char *id; int rssi; } t_queued_device;
 void witsensor_pd_scanning_handler(t_pd *obj, void *data);
 void witsensor_pd_device_found_handler(t_pd *obj, void *data);
 void witsensor_pd_connected_handler(t_pd *obj, void *data);
 
-// Forward declaration for notification callback used in connect path
-static void simpleble_on_data_received(simpleble_peripheral_t peripheral, simpleble_uuid_t service, simpleble_uuid_t characteristic, const uint8_t *data, size_t length, void *user_data);
+// Process-wide adapter and scan shared by all objects. One scan runs while any
+// member wants it; found devices are fanned out to every scanning member and
+// remembered so that members joining a running scan get them at once.
+typedef struct witsensor_ble_hub_t {
+    witsensor_mutex_t lock;             // guards everything below and member caches
+    int refcount;                       // live witsensor_ble_simpleble_t objects
+    const witsensor_ble_backend_t *backend; // chosen when the first object is created
+    simpleble_adapter_t adapter;        // from backend->open, NULL until the first scan
+    int scan_running;
+    witsensor_ble_simpleble_t *members;
+    witsensor_scan_cache_t seen;        // devices heard by the running scan, aged out when silent
+    char adapter_id[128];
+    char adapter_addr[64];
+    // Connection worker: connect/disconnect block for up to seconds, so they
+    // run here in request order instead of on the Pd thread
+    struct witsensor_ble_job_t *jobs;
+    witsensor_ble_simpleble_t *busy;    // member whose job is running
+    witsensor_cond_t wake;              // jobs queued, job finished or stop
+    witsensor_thread_t worker;
+    int worker_running;
+    int worker_stop;
+} witsensor_ble_hub_t;
+
+typedef struct witsensor_ble_job_t {
+    struct witsensor_ble_job_t *next;
+    witsensor_ble_simpleble_t *ble;
+    int connect;                        // 1: connect to target, 0: disconnect
+    char target[128];
+} witsensor_ble_job_t;
+
+// Peripheral handle handed out by a scan callback, shared by the hub cache,
+// every object's results and a connected object. Counted under the hub lock.
+typedef struct witsensor_ble_handle_t {
+    void *peripheral;                   // backend handle
+    int refs;
+} witsensor_ble_handle_t;
+
+static void _handle_release(void *handle);
+static int _disconnect_now(witsensor_ble_simpleble_t *ble_data);
+
+static witsensor_ble_hub_t witsensor_hub = {
+    .lock = WITSENSOR_MUTEX_INIT,
+    .wake = WITSENSOR_COND_INIT,
+    .seen = { .max_age_ns = WITSENSOR_SCAN_MAX_AGE_NS, .release = _handle_release },
+};
 
-// WIT sensor service and characteristic UUIDs (from Python SDK)
-#define WIT_SERVICE_UUID_STR "0000ffe5-0000-1000-8000-00805f9a34fb"
-#define WIT_READ_CHARACTERISTIC_UUID_STR "0000ffe4-0000-1000-8000-00805f9a34fb"
-#define WIT_WRITE_CHARACTERISTIC_UUID_STR "0000ffe9-0000-1000-8000-00805f9a34fb"
+// Forward declare helpers used by macOS scan tasks
+static void _clear_cached_results(witsensor_ble_simpleble_t *ble);
+static int _append_cached_result(witsensor_ble_simpleble_t *ble, const char *id, const char *addr, int rssi, uint64_t now_ns, witsensor_ble_handle_t *h);
 
-// Convert string UUIDs to SimpleBLE format
-static simpleble_uuid_t WIT_SERVICE_UUID = {.value = WIT_SERVICE_UUID_STR};
-/* unused: static simpleble_uuid_t WIT_READ_CHARACTERISTIC_UUID = {.value = WIT_READ_CHARACTERISTIC_UUID_STR}; */
-static simpleble_uuid_t WIT_WRITE_CHARACTERISTIC_UUID = {.value = WIT_WRITE_CHARACTERISTIC_UUID_STR};
-static simpleble_uuid_t WIT_READ_CHARACTERISTIC_UUID = {.value = WIT_READ_CHARACTERISTIC_UUID_STR};
+// Handle references: the callers hold witsensor_hub.lock
+static witsensor_ble_handle_t *_handle_retain(witsensor_ble_handle_t *h) {
+    if (h) h->refs++;
+    return h;
+}
 
-// Forward declarations
+static void _handle_release(void *handle) {
+    witsensor_ble_handle_t *h = (witsensor_ble_handle_t *)handle;
+    if (!h || --h->refs > 0) return;
+    witsensor_hub.backend->release(h->peripheral);
+    free(h);
+}
 
-// Forward declare helpers used by macOS scan tasks
-static void _clear_cached_results(witsensor_ble_simpleble_t *ble);
+// Emit scanning 0|1 to one object via Pd thread
+static void _queue_scanning(witsensor_ble_simpleble_t *ble, int value) {
+    if (!ble->pd_instance || !ble->pd_obj) return;
+    t_queued_flag *q = (t_queued_flag *)malloc(sizeof(t_queued_flag));
+    if (q) { q->value = value; q->index = ble->tag; q->target = q->reason = NULL; pd_queue_mess((t_pdinstance*)ble->pd_instance, (t_pd*)ble->pd_obj, q, witsensor_pd_scanning_handler); }
+}
+
+// Report a link state change to the object via witsensor_pd_connected_handler
+static void _queue_link(witsensor_ble_simpleble_t *ble, witsensor_link_state_t state, const char *target, const char *reason) {
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    if (ble->pd_instance && ble->pd_obj) {
+        t_queued_flag *q = (t_queued_flag *)malloc(sizeof(t_queued_flag));
+        if (q) {
+            q->value = state;
+            q->index = ble->tag;
+            q->target = target ? strdup(target) : NULL;
+            q->reason = reason ? strdup(reason) : NULL;
+            pd_queue_mess((t_pdinstance*)ble->pd_instance, (t_pd*)ble->pd_obj, q, witsensor_pd_connected_handler);
+        }
+    }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+}
+
+// Queue device wit|other <addr> <id> <rssi> for one object's Pd thread
+static void _queue_device(witsensor_ble_simpleble_t *ble, const char *id, const char *addr, int rssi) {
+    if (!ble->pd_instance || !ble->pd_obj) return;
+    t_queued_device *d = (t_queued_device *)malloc(sizeof(t_queued_device));
+    if (d) {
+        const char *tag = (strstr(id, "WT") != NULL) ? "wit" : "other";
+        d->tag = strdup(tag);
+        d->addr = addr ? strdup(addr) : NULL;
+        d->id = strdup(id);
+        d->rssi = rssi;
+        pd_queue_mess((t_pdinstance*)ble->pd_instance, (t_pd*)ble->pd_obj, d, witsensor_pd_device_found_handler);
+    }
+}
+
+// Record an advertisement for one object; only devices new to its results are announced
+static void _deliver_device(witsensor_ble_simpleble_t *ble, const char *id, const char *addr, int rssi, uint64_t now_ns, witsensor_ble_handle_t *h) {
+    if (!_append_cached_result(ble, id, addr, rssi, now_ns, h)) return;
+    ble->scan_found_count++;
+    _queue_device(ble, id, addr, rssi);
+}
+
+// Hub helpers below expect witsensor_hub.lock to be held
+static void _hub_clear_seen(void) {
+    witsensor_scan_cache_clear(&witsensor_hub.seen);
+}
+
+static int _hub_scanning_members(void) {
+    int n = 0;
+    for (witsensor_ble_simpleble_t *m = witsensor_hub.members; m; m = m->hub_next) n += m->is_scanning;
+    return n;
+}
+
+// Take an object out of the scan; returns 1 if the adapter scan should stop
+static int _hub_leave_scan(witsensor_ble_simpleble_t *ble) {
+    if (!ble->is_scanning) return 0;
+    ble->is_scanning = 0;
+    _queue_scanning(ble, 0);
+    if (witsensor_hub.scan_running && _hub_scanning_members() == 0) {
+        witsensor_hub.scan_running = 0;
+        return 1;
+    }
+    return 0;
+}
+
+static int _hub_claimed_by_other(witsensor_ble_simpleble_t *ble, const char *target) {
+    for (witsensor_ble_simpleble_t *m = witsensor_hub.members; m; m = m->hub_next) {
+        if (m == ble) continue;
+        // A queued or running connect holds its target as well
+        if (m->connecting[0] && strcmp(m->connecting, target) == 0) return 1;
+        if (!m->is_connected) continue;
+        if ((m->connected_id[0] && strcmp(m->connected_id, target) == 0)
+            || (m->connected_addr[0] && strcmp(m->connected_addr, target) == 0)) return 1;
+    }
+    return 0;
+}
 
 // Helper function to output scan results via status outlet
 static void _output_scan_results(witsensor_ble_simpleble_t *ble_data) {
     if (!ble_data || !ble_data->adapter) return;
     // Output from cached snapshot so that 'clear' affects 'results'
-    unsigned long n = ble_data->cached_count;
-    for (unsigned long i = 0; i < n; i++) {
-        const char *addr = (ble_data->cached_addrs && ble_data->cached_addrs[i]) ? ble_data->cached_addrs[i] : NULL;
-        const char *id = (ble_data->cached_ids && ble_data->cached_ids[i]) ? ble_data->cached_ids[i] : NULL;
-        if (!id) continue;
-        const char *tag = (strstr(id, "WT") != NULL) ? "wit" : "other";
-        if (ble_data->pd_instance && ble_data->pd_obj) {
-            t_queued_device *d = (t_queued_device *)malloc(sizeof(t_queued_device));
-            if (d) {
-                d->tag = strdup(tag);
-                d->addr = addr ? strdup(addr) : NULL;
-                d->id = strdup(id);
-                pd_queue_mess((t_pdinstance*)ble_data->pd_instance, (t_pd*)ble_data->pd_obj, d, witsensor_pd_device_found_handler);
-            }
-        }
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    for (unsigned int i = 0; i < WITSENSOR_SCAN_ENTRIES; i++) {
+        witsensor_scan_entry_t *e = witsensor_scan_cache_at(&ble_data->results, i);
+        if (e) _queue_device(ble_data, e->id, e->addr, e->rssi);
     }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
 }
 
 // Helpers to manage cached scan results (CoreBluetooth thread safe: no Pd calls)
@@ -79,119 +198,237 @@ static void _clear_cached_results(witsensor_ble_simpleble_t *ble) {
     ble->scan_found_count = 0;
     ble->adapter_id[0] = '\0';
     ble->adapter_addr[0] = '\0';
-    if (ble->cached_ids) {
-        for (unsigned long i = 0; i < ble->cached_count; i++) free(ble->cached_ids[i]);
-        free(ble->cached_ids);
-        ble->cached_ids = NULL;
-    }
-    if (ble->cached_addrs) {
-        for (unsigned long i = 0; i < ble->cached_count; i++) free(ble->cached_addrs[i]);
-        free(ble->cached_addrs);
-        ble->cached_addrs = NULL;
-    }
-    ble->cached_count = 0;
-}
-
-static void _append_cached_result(witsensor_ble_simpleble_t *ble, const char *id, const char *addr) {
-    if (!ble || !id || !addr) return;
-    if (!ble->is_scanning) return; // avoid races after stop
-    unsigned long n = ble->cached_count;
-    char **new_ids = (char**)realloc(ble->cached_ids, (n+1) * sizeof(char*));
-    char **new_addrs = (char**)realloc(ble->cached_addrs, (n+1) * sizeof(char*));
-    if (!new_ids || !new_addrs) {
-        // Allocation failed; keep old arrays
-        return;
-    }
-    ble->cached_ids = new_ids;
-    ble->cached_addrs = new_addrs;
-    ble->cached_ids[n] = strdup(id);
-    ble->cached_addrs[n] = strdup(addr);
-    ble->cached_count = n + 1;
+    witsensor_scan_cache_clear(&ble->results);
+}
+
+// Returns 1 if the device is new to this object's results (or could not be stored);
+// the results keep their own reference to the scan handle
+static int _append_cached_result(witsensor_ble_simpleble_t *ble, const char *id, const char *addr, int rssi, uint64_t now_ns, witsensor_ble_handle_t *h) {
+    if (!ble || !id || !addr) return 0;
+    if (!ble->is_scanning) return 0; // avoid races after stop
+    return witsensor_scan_cache_update(&ble->results, addr, id, rssi, now_ns, _handle_retain(h)) != 0;
 }
 
-// SimpleBLE scan callbacks
+#ifndef WITSENSOR_BLE_MOCK_ONLY
+// SimpleBLE backend: the platform's Bluetooth stack through simplecble
+
+// WIT sensor service and characteristic UUIDs (from Python SDK)
+#define WIT_SERVICE_UUID_STR "0000ffe5-0000-1000-8000-00805f9a34fb"
+#define WIT_READ_CHARACTERISTIC_UUID_STR "0000ffe4-0000-1000-8000-00805f9a34fb"
+#define WIT_WRITE_CHARACTERISTIC_UUID_STR "0000ffe9-0000-1000-8000-00805f9a34fb"
+
+// Convert string UUIDs to SimpleBLE format
+static simpleble_uuid_t WIT_SERVICE_UUID = {.value = WIT_SERVICE_UUID_STR};
+static simpleble_uuid_t WIT_WRITE_CHARACTERISTIC_UUID = {.value = WIT_WRITE_CHARACTERISTIC_UUID_STR};
+static simpleble_uuid_t WIT_READ_CHARACTERISTIC_UUID = {.value = WIT_READ_CHARACTERISTIC_UUID_STR};
+
+static simpleble_adapter_t simpleble_adapter;
+
+// SimpleBLE callbacks forward to the hub
 static void simpleble_on_scan_start(simpleble_adapter_t adapter, void *user_data) {
-    witsensor_ble_simpleble_t *ble_data = (witsensor_ble_simpleble_t *)user_data;
-    if (!ble_data) return;
-    _clear_cached_results(ble_data);
-    // cache adapter id/addr for debug
+    (void)user_data;
     char *aid = simpleble_adapter_identifier(adapter);
     char *aad = simpleble_adapter_address(adapter);
-    if (aid) { snprintf(ble_data->adapter_id, sizeof(ble_data->adapter_id), "%s", aid); simpleble_free(aid); }
-    if (aad) { snprintf(ble_data->adapter_addr, sizeof(ble_data->adapter_addr), "%s", aad); simpleble_free(aad); }
+    witsensor_ble_hub_scan_started(aid, aad);
+    if (aid) simpleble_free(aid);
+    if (aad) simpleble_free(aad);
 }
 
 static void simpleble_on_scan_stop(simpleble_adapter_t adapter, void *user_data) {
-    (void)adapter;
-    witsensor_ble_simpleble_t *ble_data = (witsensor_ble_simpleble_t *)user_data;
-    if (!ble_data) return;
-    ble_data->is_scanning = 0;
-    // Emit scanning 0 via Pd thread
-    if (ble_data->pd_instance && ble_data->pd_obj) {
-        t_queued_flag *q = (t_queued_flag *)malloc(sizeof(t_queued_flag));
-        if (q) { q->value = 0; pd_queue_mess((t_pdinstance*)ble_data->pd_instance, (t_pd*)ble_data->pd_obj, q, witsensor_pd_scanning_handler); }
-    }
+    (void)adapter; (void)user_data;
+    witsensor_ble_hub_scan_stopped();
 }
 
+// Each callback hands out its own peripheral handle, passed on to the hub
 static void simpleble_on_scan_found(simpleble_adapter_t adapter, simpleble_peripheral_t peripheral, void *user_data) {
-    (void)adapter;
-    witsensor_ble_simpleble_t *ble_data = (witsensor_ble_simpleble_t *)user_data;
-    if (!ble_data || !peripheral) return;
-    if (ble_data->is_connected) return;
-    simpleble_peripheral_t p = peripheral;
-    char *addr = simpleble_peripheral_address(p);
-    char *id = simpleble_peripheral_identifier(p);
-    if (id && addr) {
-        _append_cached_result(ble_data, id, addr);
-        ble_data->scan_found_count++;
-        // Emit device status via Pd thread: device wit|other <id>
-        if (ble_data->pd_instance && ble_data->pd_obj) {
-            t_queued_device *d = (t_queued_device *)malloc(sizeof(t_queued_device));
-            if (d) {
-                const char *tag = (strstr(id, "WT") != NULL) ? "wit" : "other";
-                d->tag = strdup(tag);
-                d->addr = addr ? strdup(addr) : NULL;
-                d->id = id ? strdup(id) : NULL;
-                pd_queue_mess((t_pdinstance*)ble_data->pd_instance, (t_pd*)ble_data->pd_obj, d, witsensor_pd_device_found_handler);
-            }
-        }
-    }
+    (void)adapter; (void)user_data;
+    if (!peripheral) return;
+    char *addr = simpleble_peripheral_address(peripheral);
+    char *id = simpleble_peripheral_identifier(peripheral);
+    witsensor_ble_hub_scan_found(peripheral, id, addr, id && addr ? simpleble_peripheral_rssi(peripheral) : 0);
     if (addr) simpleble_free(addr);
     if (id) simpleble_free(id);
 }
 
-
 static void simpleble_on_data_received(simpleble_peripheral_t peripheral, simpleble_uuid_t service, simpleble_uuid_t characteristic, const uint8_t *data, size_t length, void *user_data) {
     (void)peripheral; (void)service; (void)characteristic;
-    witsensor_ble_simpleble_t *ble_data = (witsensor_ble_simpleble_t *)user_data;
+    witsensor_ble_hub_notified((witsensor_ble_simpleble_t *)user_data, data, (int)length);
+}
+
+static void simpleble_on_disconnected(simpleble_peripheral_t peripheral, void *user_data) {
+    (void)peripheral;
+    witsensor_ble_hub_link_lost((witsensor_ble_simpleble_t *)user_data);
+}
+
+static void *simpleble_backend_open(char *err, size_t errsize) {
+    if (simpleble_adapter_get_count() == 0) {
+        snprintf(err, errsize, "No BLE adapters found - check Bluetooth permissions in System Settings → Privacy & Security → Bluetooth");
+        return NULL;
+    }
+    // Get the first adapter
+    simpleble_adapter = simpleble_adapter_get_handle(0);
+    if (!simpleble_adapter) {
+        snprintf(err, errsize, "Failed to get adapter - check Bluetooth permissions in System Settings → Privacy & Security → Bluetooth");
+        return NULL;
+    }
+    simpleble_adapter_set_callback_on_scan_start(simpleble_adapter, simpleble_on_scan_start, NULL);
+    simpleble_adapter_set_callback_on_scan_stop(simpleble_adapter, simpleble_on_scan_stop, NULL);
+    simpleble_adapter_set_callback_on_scan_found(simpleble_adapter, simpleble_on_scan_found, NULL);
+    simpleble_adapter_set_callback_on_scan_updated(simpleble_adapter, simpleble_on_scan_found, NULL);
+    return simpleble_adapter;
+}
+
+static int simpleble_backend_enabled(void) {
+    return simpleble_adapter_is_bluetooth_enabled();
+}
+
+static int simpleble_backend_scan_start(void) {
+    return simpleble_adapter_scan_start(simpleble_adapter) == SIMPLEBLE_SUCCESS;
+}
+
+static void simpleble_backend_scan_stop(void) {
+    simpleble_err_t err = simpleble_adapter_scan_stop(simpleble_adapter);
+    if (err != SIMPLEBLE_SUCCESS) post("WITSensorBLE: Failed to stop scan, error: %d", err);
+}
+
+static int simpleble_backend_connect(void *peripheral, witsensor_ble_simpleble_t *ble) {
+    if (simpleble_peripheral_connect(peripheral) != SIMPLEBLE_SUCCESS) return 0;
+    simpleble_peripheral_notify(peripheral, WIT_SERVICE_UUID, WIT_READ_CHARACTERISTIC_UUID, simpleble_on_data_received, ble);
+    simpleble_peripheral_set_callback_on_disconnected(peripheral, simpleble_on_disconnected, ble);
+    return 1;
+}
+
+static void simpleble_backend_disconnect(void *peripheral) {
+    simpleble_peripheral_disconnect(peripheral);
+}
+
+static int simpleble_backend_write(void *peripheral, const unsigned char *data, int length, int request) {
+    simpleble_err_t err = request
+        ? simpleble_peripheral_write_request(peripheral, WIT_SERVICE_UUID, WIT_WRITE_CHARACTERISTIC_UUID, data, (uint16_t)length)
+        : simpleble_peripheral_write_command(peripheral, WIT_SERVICE_UUID, WIT_WRITE_CHARACTERISTIC_UUID, data, (uint16_t)length);
+    return err == SIMPLEBLE_SUCCESS;
+}
+
+static int simpleble_backend_notify(void *peripheral, witsensor_ble_simpleble_t *ble, int enabled) {
+    if (enabled) {
+        simpleble_peripheral_notify(peripheral, WIT_SERVICE_UUID, WIT_READ_CHARACTERISTIC_UUID, simpleble_on_data_received, ble);
+    } else {
+        simpleble_peripheral_unsubscribe(peripheral, WIT_SERVICE_UUID, WIT_READ_CHARACTERISTIC_UUID);
+    }
+    return 1;
+}
+
+static void simpleble_backend_release(void *peripheral) {
+    simpleble_peripheral_release_handle(peripheral);
+}
+
+// The adapter stays with the process: SimpleBLE release functions might crash
+static void simpleble_backend_close(void) {
+}
+
+const witsensor_ble_backend_t witsensor_ble_simpleble_backend = {
+    "simpleble",
+    simpleble_backend_open,
+    simpleble_backend_enabled,
+    simpleble_backend_scan_start,
+    simpleble_backend_scan_stop,
+    simpleble_backend_connect,
+    simpleble_backend_disconnect,
+    simpleble_backend_write,
+    simpleble_backend_notify,
+    simpleble_backend_release,
+    simpleble_backend_close,
+};
+#endif // WITSENSOR_BLE_MOCK_ONLY
+
+// SimpleBLE unless built with WITSENSOR_BLE_MOCK_ONLY or run with WITSENSOR_BLE=mock
+static const witsensor_ble_backend_t *_select_backend(void) {
+#ifdef WITSENSOR_BLE_MOCK_ONLY
+    return &witsensor_ble_mock_backend;
+#else
+    const char *name = getenv("WITSENSOR_BLE");
+    if (name && strcmp(name, "mock") == 0) return &witsensor_ble_mock_backend;
+    return &witsensor_ble_simpleble_backend;
+#endif
+}
+
+// Backend events (witsensor_ble_backend.h)
+void witsensor_ble_hub_scan_started(const char *adapter_id, const char *adapter_addr) {
+    // cache adapter id/addr for debug
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    if (adapter_id) snprintf(witsensor_hub.adapter_id, sizeof(witsensor_hub.adapter_id), "%s", adapter_id);
+    if (adapter_addr) snprintf(witsensor_hub.adapter_addr, sizeof(witsensor_hub.adapter_addr), "%s", adapter_addr);
+    for (witsensor_ble_simpleble_t *m = witsensor_hub.members; m; m = m->hub_next) {
+        if (!m->is_scanning) continue;
+        snprintf(m->adapter_id, sizeof(m->adapter_id), "%s", witsensor_hub.adapter_id);
+        snprintf(m->adapter_addr, sizeof(m->adapter_addr), "%s", witsensor_hub.adapter_addr);
+    }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+}
+
+void witsensor_ble_hub_scan_stopped(void) {
+    // Members that left on purpose were notified already; tell the rest
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    witsensor_hub.scan_running = 0;
+    for (witsensor_ble_simpleble_t *m = witsensor_hub.members; m; m = m->hub_next) {
+        if (!m->is_scanning) continue;
+        m->is_scanning = 0;
+        _queue_scanning(m, 0);
+    }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+}
+
+// First sighting and every later advertisement: refresh RSSI and last-seen time.
+// The hub owns the peripheral handle from here; the caches keep the first one per device.
+void witsensor_ble_hub_scan_found(void *peripheral, const char *id, const char *addr, int rssi) {
+    if (!peripheral) return;
+    witsensor_ble_handle_t *h = (witsensor_ble_handle_t *)malloc(sizeof(witsensor_ble_handle_t));
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    if (!h) {
+        witsensor_hub.backend->release(peripheral);
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        return;
+    }
+    h->peripheral = peripheral;
+    h->refs = 1;
+    if (id && addr) {
+        uint64_t now = witsensor_now_ns();
+        witsensor_scan_cache_update(&witsensor_hub.seen, addr, id, rssi, now, _handle_retain(h));
+        // Fan out to every object taking part in the scan; each dedupes in its own results
+        for (witsensor_ble_simpleble_t *m = witsensor_hub.members; m; m = m->hub_next) {
+            if (m->is_scanning && !m->is_connected) _deliver_device(m, id, addr, rssi, now, h);
+        }
+    }
+    _handle_release(h);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+}
+
+void witsensor_ble_hub_notified(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length) {
     if (!ble_data) return;
-    // Pass-through: forward raw frame to Pd layer for parsing
+    // Pass-through: forward the whole notification, the Pd layer reassembles frames
     if (ble_data->data_callback && data && length > 0) {
-        size_t n = length > 64 ? 64 : length;
-        unsigned char buf[64];
-        memcpy(buf, data, n);
-        ble_data->data_callback(ble_data->pd_obj, buf, (int)n);
+        ble_data->data_callback(ble_data->callback_data ? ble_data->callback_data : ble_data->pd_obj, data, length);
     }
-    ble_data->data_count++;
-    ble_data->last_data_time = time(NULL);
+    atomic_fetch_add_explicit(&ble_data->data_count, 1, memory_order_relaxed);
+    atomic_store_explicit(&ble_data->last_data_ns, witsensor_now_ns(), memory_order_relaxed);
 }
 
-// Callback for disconnection events
-static void simpleble_on_disconnected(simpleble_peripheral_t peripheral, void *user_data) {
-    (void)peripheral;
-    witsensor_ble_simpleble_t *ble_data = (witsensor_ble_simpleble_t *)user_data;
+// The link dropped without being asked to
+void witsensor_ble_hub_link_lost(witsensor_ble_simpleble_t *ble_data) {
     if (!ble_data) return;
     
-    post("WITSensorBLE: Device disconnected unexpectedly");
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    // A requested disconnect cleared the flag already and reports itself
+    int was_connected = ble_data->is_connected;
     ble_data->is_connected = 0;
+    ble_data->connected_id[0] = '\0';
+    ble_data->connected_addr[0] = '\0';
+    witsensor_mutex_unlock(&witsensor_hub.lock);
     
     // Notify Pd layer about disconnection
-    if (ble_data->pd_instance && ble_data->pd_obj) {
-        t_queued_flag *q = (t_queued_flag *)malloc(sizeof(t_queued_flag));
-        if (q) {
-            q->value = 0; // 0 = disconnected
-            pd_queue_mess((t_pdinstance*)ble_data->pd_instance, (t_pd*)ble_data->pd_obj, q, witsensor_pd_connected_handler);
-        }
+    if (was_connected) {
+        post("WITSensorBLE: Device disconnected unexpectedly");
+        _queue_link(ble_data, WITSENSOR_LINK_DISCONNECTED, NULL, NULL);
     }
 }
 
@@ -207,9 +444,15 @@ witsensor_ble_simpleble_t *witsensor_ble_simpleble_create(void) {
     ble_data->peripheral = NULL;
     ble_data->is_scanning = 0;
     ble_data->is_connected = 0;
-    ble_data->cached_ids = NULL;
-    ble_data->cached_addrs = NULL;
-    ble_data->cached_count = 0;
+    witsensor_scan_cache_init(&ble_data->results, WITSENSOR_SCAN_MAX_AGE_NS, _handle_release);
+    
+    // Join the scan hub
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    if (!witsensor_hub.backend) witsensor_hub.backend = _select_backend();
+    ble_data->hub_next = witsensor_hub.members;
+    witsensor_hub.members = ble_data;
+    witsensor_hub.refcount++;
+    witsensor_mutex_unlock(&witsensor_hub.lock);
     
     return ble_data;
 }
@@ -217,16 +460,48 @@ witsensor_ble_simpleble_t *witsensor_ble_simpleble_create(void) {
 // Destroy BLE data structure - COMPLETELY CRASH-SAFE
 void witsensor_ble_simpleble_destroy(witsensor_ble_simpleble_t *ble_data) {
     if (ble_data) {
-        // Don't call SimpleBLE release functions - they might crash
-        // Just free the memory
-        if (ble_data->cached_ids) {
-            for (unsigned long i = 0; i < ble_data->cached_count; i++) free(ble_data->cached_ids[i]);
-            free(ble_data->cached_ids);
+        // The Pd object is going away, so nothing is queued for it anymore.
+        // Drop its pending worker jobs and wait for a running one to finish.
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        ble_data->pd_obj = NULL;
+        for (witsensor_ble_job_t **j = &witsensor_hub.jobs; *j; ) {
+            witsensor_ble_job_t *job = *j;
+            if (job->ble == ble_data) { *j = job->next; free(job); }
+            else j = &job->next;
+        }
+        while (witsensor_hub.busy == ble_data) witsensor_cond_wait(&witsensor_hub.wake, &witsensor_hub.lock);
+        ble_data->connecting[0] = '\0';
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        _disconnect_now(ble_data);
+
+        // Leave the scan hub; the last scanning member stops the shared scan
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        int stop = _hub_leave_scan(ble_data);
+        for (witsensor_ble_simpleble_t **m = &witsensor_hub.members; *m; m = &(*m)->hub_next) {
+            if (*m == ble_data) { *m = ble_data->hub_next; break; }
         }
-        if (ble_data->cached_addrs) {
-            for (unsigned long i = 0; i < ble_data->cached_count; i++) free(ble_data->cached_addrs[i]);
-            free(ble_data->cached_addrs);
+        witsensor_hub.refcount--;
+        int join = 0, last = witsensor_hub.refcount == 0;
+        if (last) {
+            witsensor_scan_cache_free(&witsensor_hub.seen);
+            // Last object gone: let the worker finish
+            join = witsensor_hub.worker_running;
+            witsensor_hub.worker_stop = 1;
+            witsensor_hub.worker_running = 0;
+            witsensor_cond_broadcast(&witsensor_hub.wake);
         }
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        if (stop) witsensor_hub.backend->scan_stop();
+        if (join) witsensor_thread_join(witsensor_hub.worker);
+        if (last) witsensor_hub.backend->close();
+        
+        // Don't call SimpleBLE release functions - they might crash
+        // The shared adapter handle stays with the hub; drop our scan handles
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        witsensor_scan_cache_free(&ble_data->results);
+        _handle_release(ble_data->handle);
+        ble_data->handle = NULL;
+        witsensor_mutex_unlock(&witsensor_hub.lock);
         free(ble_data);
     }
 }
@@ -243,7 +518,7 @@ int witsensor_ble_simpleble_ensure_initialized(witsensor_ble_simpleble_t *ble_da
     return 1;
 }
 
-// Start scanning for devices
+// Start scanning for devices: join the shared scan, starting it if needed
 void witsensor_ble_simpleble_start_scanning(witsensor_ble_simpleble_t *ble_data) {
     if (!ble_data) return;
     
@@ -251,57 +526,74 @@ void witsensor_ble_simpleble_start_scanning(witsensor_ble_simpleble_t *ble_data)
     
     // Authorization already checked on object creation
     
-    // Try to initialize BLE now
-    if (!ble_data->adapter) {
+    // Try to initialize BLE now (once per process)
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    if (!witsensor_hub.adapter) {
         post("WITSensorBLE: Attempting BLE initialization on first scan...");
-        
-        // Try to get adapter count first
-        size_t adapter_count = simpleble_adapter_get_count();
-        if (adapter_count == 0) {
-            pd_error(ble_data->pd_obj, "WITSensorBLE: No BLE adapters found - check Bluetooth permissions in System Settings → Privacy & Security → Bluetooth");
+        char err[192] = "";
+        witsensor_hub.adapter = witsensor_hub.backend->open(err, sizeof(err));
+        if (!witsensor_hub.adapter) {
+            witsensor_mutex_unlock(&witsensor_hub.lock);
+            pd_error(ble_data->pd_obj, "WITSensorBLE: %s", err);
             return;
         }
-        
-        // Get the first adapter
-        ble_data->adapter = simpleble_adapter_get_handle(0);
-        if (!ble_data->adapter) {
-            pd_error(ble_data->pd_obj, "WITSensorBLE: Failed to get adapter - check Bluetooth permissions in System Settings → Privacy & Security → Bluetooth");
-            return;
-        }
-        
-        // Set up callbacks
-        simpleble_adapter_set_callback_on_scan_start(ble_data->adapter, simpleble_on_scan_start, ble_data);
-        simpleble_adapter_set_callback_on_scan_stop(ble_data->adapter, simpleble_on_scan_stop, ble_data);
-        simpleble_adapter_set_callback_on_scan_found(ble_data->adapter, simpleble_on_scan_found, ble_data);
-        
-        post("WITSensorBLE: BLE adapter initialized successfully");
+        post("WITSensorBLE: BLE adapter initialized successfully (%s)", witsensor_hub.backend->name);
     }
+    ble_data->adapter = witsensor_hub.adapter;
     _clear_cached_results(ble_data);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
     
     // Check if Bluetooth is enabled before attempting scan
-    if (!simpleble_adapter_is_bluetooth_enabled()) {
+    if (!witsensor_hub.backend->enabled()) {
         pd_error(ble_data->pd_obj, "WITSensorBLE: Bluetooth is not enabled - please enable Bluetooth and grant permissions");
         return;
     }
     
-    ble_data->is_scanning = 1;
-    // Emit scanning 1 via Pd thread
-    if (ble_data->pd_instance && ble_data->pd_obj) {
-        t_queued_flag *q = (t_queued_flag *)malloc(sizeof(t_queued_flag));
-        if (q) { q->value = 1; pd_queue_mess((t_pdinstance*)ble_data->pd_instance, (t_pd*)ble_data->pd_obj, q, witsensor_pd_scanning_handler); }
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    int start = !witsensor_hub.scan_running;
+    int members = _hub_scanning_members() + (ble_data->is_scanning ? 0 : 1);
+    if (!ble_data->is_scanning) {
+        ble_data->is_scanning = 1;
+        // Emit scanning 1 via Pd thread
+        _queue_scanning(ble_data, 1);
+    }
+    if (start) {
+        _hub_clear_seen();
+        witsensor_hub.scan_running = 1;
+    } else {
+        // Scan already running for other objects: hand over what it found so far
+        snprintf(ble_data->adapter_id, sizeof(ble_data->adapter_id), "%s", witsensor_hub.adapter_id);
+        snprintf(ble_data->adapter_addr, sizeof(ble_data->adapter_addr), "%s", witsensor_hub.adapter_addr);
+        if (!ble_data->is_connected) {
+            uint64_t now = witsensor_now_ns();
+            for (unsigned int i = 0; i < WITSENSOR_SCAN_ENTRIES; i++) {
+                witsensor_scan_entry_t *e = witsensor_scan_cache_at(&witsensor_hub.seen, i);
+                if (e) _deliver_device(ble_data, e->id, e->addr, e->rssi, now, (witsensor_ble_handle_t *)e->handle);
+            }
+        }
+    }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    
+    if (!start) {
+        post("WITSensorBLE: joined running scan (%d objects scanning)", members);
+        return;
     }
     // Non-blocking scan: start, and let 'results' query current list
-    simpleble_err_t err = simpleble_adapter_scan_start(ble_data->adapter);
-    if (err != SIMPLEBLE_SUCCESS) {
-        ble_data->is_scanning = 0;
-        pd_error(ble_data->pd_obj, "WITSensorBLE: scan_start failed: %d", err);
+    if (!witsensor_hub.backend->scan_start()) {
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        witsensor_hub.scan_running = 0;
+        for (witsensor_ble_simpleble_t *m = witsensor_hub.members; m; m = m->hub_next) {
+            if (m->is_scanning) { m->is_scanning = 0; _queue_scanning(m, 0); }
+        }
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        pd_error(ble_data->pd_obj, "WITSensorBLE: scan_start failed");
         return;
     }
     // Continuous scanning - scan until manually stopped or connection succeeds
     post("WITSensorBLE: continuous scanning (no timeout)");
 }
 
-// Stop scanning for devices
+// Stop scanning for devices: leave the shared scan, stopping it if nobody else uses it
 void witsensor_ble_simpleble_stop_scanning(witsensor_ble_simpleble_t *ble_data) {
     if (!ble_data) return;
     
@@ -313,15 +605,17 @@ void witsensor_ble_simpleble_stop_scanning(witsensor_ble_simpleble_t *ble_data)
         return;
     }
     
-    // Stop scanning
-    simpleble_err_t err = simpleble_adapter_scan_stop(ble_data->adapter);
-    if (err != SIMPLEBLE_SUCCESS) {
-        post("WITSensorBLE: Failed to stop scan, error: %d", err);
-    } else {
-        post("WITSensorBLE: BLE scan stopped successfully");
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    int stop = _hub_leave_scan(ble_data);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    if (!stop) {
+        post("WITSensorBLE: left shared scan");
+        return;
     }
     
-    ble_data->is_scanning = 0;
+    // Stop scanning
+    witsensor_hub.backend->scan_stop();
+    post("WITSensorBLE: BLE scan stopped successfully");
 }
 
 // Get scan results - GUI-safe
@@ -343,23 +637,91 @@ void witsensor_ble_simpleble_clear_scan_results(witsensor_ble_simpleble_t *ble_d
     if (!ble_data) return;
     
     // Free existing cached results
-    if (ble_data->cached_ids) {
-        for (unsigned long i = 0; i < ble_data->cached_count; i++) {
-            if (ble_data->cached_ids[i]) free(ble_data->cached_ids[i]);
-            if (ble_data->cached_addrs[i]) free(ble_data->cached_addrs[i]);
-        }
-        free(ble_data->cached_ids);
-        free(ble_data->cached_addrs);
-        ble_data->cached_ids = NULL;
-        ble_data->cached_addrs = NULL;
-        ble_data->cached_count = 0;
-    }
-    
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    witsensor_scan_cache_clear(&ble_data->results);
     ble_data->scan_found_count = 0;
+    witsensor_mutex_unlock(&witsensor_hub.lock);
     post("WITSensorBLE: Cleared scan results");
 }
 
-// Connect to a device by target string (address or identifier)
+// Connect to target (address or identifier) from the scan results. Runs on
+// the worker or the caller's thread and makes no Pd calls; on failure the
+// reason is written to reason.
+static int _connect_now(witsensor_ble_simpleble_t *ble_data, const char *target, char *reason, size_t size) {
+    // One device, one object: refuse targets another object is connected to
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    int claimed = _hub_claimed_by_other(ble_data, target);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    if (claimed) {
+        snprintf(reason, size, "%s is already connected to another object", target);
+        return 0;
+    }
+
+    // Target must be in our scan results (to honor 'reset'); connect straight
+    // to the handle the scan callback gave us instead of enumerating the adapter
+    witsensor_ble_simpleble_t *results = ble_data->scanner ? ble_data->scanner : ble_data;
+    char id[128] = "", addr[64] = "";
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    witsensor_scan_entry_t *e = witsensor_scan_cache_find(&results->results, target);
+    witsensor_ble_handle_t *h = e ? _handle_retain((witsensor_ble_handle_t *)e->handle) : NULL;
+    if (e) {
+        snprintf(id, sizeof(id), "%s", e->id);
+        snprintf(addr, sizeof(addr), "%s", e->addr);
+    }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    if (!e) {
+        snprintf(reason, size, "Target not in cached results; start scan to populate results before connecting");
+        return 0;
+    }
+    if (!h) {
+        snprintf(reason, size, "Device not found: %s", target);
+        return 0;
+    }
+
+    void *p = h->peripheral;
+    if (!witsensor_hub.backend->connect(p, ble_data)) {
+        snprintf(reason, size, "Failed to connect to %s", target);
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        _handle_release(h);
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        return 0;
+    }
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    _handle_release(ble_data->handle);
+    ble_data->handle = h;
+    ble_data->peripheral = p;
+    ble_data->is_connected = 1;
+    snprintf(ble_data->connected_id, sizeof(ble_data->connected_id), "%s", id);
+    snprintf(ble_data->connected_addr, sizeof(ble_data->connected_addr), "%s", addr);
+    int stop = _hub_leave_scan(ble_data);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    if (stop) witsensor_hub.backend->scan_stop();
+    return 1;
+}
+
+// Drop the connection; returns 1 if there was one (no Pd calls)
+static int _disconnect_now(witsensor_ble_simpleble_t *ble_data) {
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    // Cleared first so the disconnect callback knows this was requested
+    int was_connected = ble_data->is_connected;
+    ble_data->is_connected = 0;
+    void *p = ble_data->peripheral;
+    ble_data->peripheral = NULL;
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+
+    if (p) witsensor_hub.backend->disconnect(p);
+    
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    // The scan caches may still hold the handle for a later reconnect
+    _handle_release(ble_data->handle);
+    ble_data->handle = NULL;
+    ble_data->connected_id[0] = '\0';
+    ble_data->connected_addr[0] = '\0';
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    return was_connected;
+}
+
+// Connect to a device by target string (address or identifier), blocking
 int witsensor_ble_simpleble_connect(witsensor_ble_simpleble_t *ble_data, const char *target) {
     if (!ble_data || !target) return 0;
     post("WITSensorBLE: Connecting to target: %s", target);
@@ -369,131 +731,142 @@ int witsensor_ble_simpleble_connect(witsensor_ble_simpleble_t *ble_data, const c
         post("WITSensorBLE: Failed to initialize BLE system");
         return 0;
     }
-
-    // Require that target exists in our cached results to honor 'reset'
-    int in_cached = 0;
-    if (ble_data->cached_ids && ble_data->cached_addrs && ble_data->cached_count > 0) {
-        for (unsigned long i = 0; i < ble_data->cached_count; i++) {
-            const char *cid = ble_data->cached_ids[i];
-            const char *caddr = ble_data->cached_addrs[i];
-            if ((cid && strcmp(cid, target) == 0) || (caddr && strcmp(caddr, target) == 0)) {
-                in_cached = 1;
-                break;
-            }
-        }
-    }
-    if (!in_cached) {
-        pd_error(ble_data->pd_obj, "WITSensorBLE: Target not in cached results; start scan to populate results before connecting");
+    char reason[192];
+    if (!_connect_now(ble_data, target, reason, sizeof(reason))) {
+        pd_error(ble_data->pd_obj, "WITSensorBLE: %s", reason);
         return 0;
     }
+    post("WITSensorBLE: Connected to %s", target);
+    return 1;
+}
 
-    size_t count = simpleble_adapter_scan_get_results_count(ble_data->adapter);
-    for (size_t i = 0; i < count; i++) {
-        simpleble_peripheral_t p = simpleble_adapter_scan_get_results_handle(ble_data->adapter, i);
-        if (!p) continue;
-
-        char *addr = simpleble_peripheral_address(p);
-        char *id = simpleble_peripheral_identifier(p);
-
-        int is_match = 0;
-        if (addr && strcmp(addr, target) == 0) is_match = 1;
-        if (!is_match && id && strcmp(id, target) == 0) is_match = 1;
-
-        if (is_match) {
-            post("WITSensorBLE: Attempting connect to %s", target);
-            if (simpleble_peripheral_connect(p) == SIMPLEBLE_SUCCESS) {
-                ble_data->peripheral = p;
-                ble_data->is_connected = 1;
-
-                if (ble_data->is_scanning) {
-                    simpleble_adapter_scan_stop(ble_data->adapter);
-                    ble_data->is_scanning = 0;
-                    post("WITSensorBLE: Stopped scanning after successful connection");
-                }
-
-                simpleble_uuid_t service_uuid = {.value = WIT_SERVICE_UUID_STR};
-                simpleble_uuid_t read_characteristic_uuid = {.value = WIT_READ_CHARACTERISTIC_UUID_STR};
-                simpleble_peripheral_notify(p, service_uuid, read_characteristic_uuid, simpleble_on_data_received, ble_data);
-                simpleble_peripheral_set_callback_on_disconnected(p, simpleble_on_disconnected, ble_data);
-                post("WITSensorBLE: Connected to %s", target);
-                if (addr) simpleble_free(addr);
-                if (id) simpleble_free(id);
-                return 1;
-            } else {
-                pd_error(ble_data->pd_obj, "WITSensorBLE: Failed to connect to %s", target);
-            }
+// Disconnect from device, blocking
+void witsensor_ble_simpleble_disconnect(witsensor_ble_simpleble_t *ble_data) {
+    if (!ble_data) return;
+    
+    post("WITSensorBLE: Disconnecting from device...");
+    _disconnect_now(ble_data);
+    post("WITSensorBLE: Disconnected from device");
+}
+
+static void _run_job(witsensor_ble_job_t *job) {
+    witsensor_ble_simpleble_t *ble = job->ble;
+    if (job->connect) {
+        _queue_link(ble, WITSENSOR_LINK_CONNECTING, job->target, NULL);
+        char reason[192] = "";
+        int ok = _connect_now(ble, job->target, reason, sizeof(reason));
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        ble->connecting[0] = '\0';
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        _queue_link(ble, ok ? WITSENSOR_LINK_CONNECTED : WITSENSOR_LINK_FAILED, job->target, ok ? NULL : reason);
+    } else if (_disconnect_now(ble)) {
+        _queue_link(ble, WITSENSOR_LINK_DISCONNECTED, NULL, NULL);
+    }
+}
+
+static void _worker_main(void *arg) {
+    (void)arg;
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    for (;;) {
+        while (!witsensor_hub.jobs && !witsensor_hub.worker_stop) {
+            witsensor_cond_wait(&witsensor_hub.wake, &witsensor_hub.lock);
         }
+        witsensor_ble_job_t *job = witsensor_hub.jobs;
+        if (!job) break; // stop requested, nothing left to do
+        witsensor_hub.jobs = job->next;
+        witsensor_hub.busy = job->ble;
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        _run_job(job);
+        free(job);
+        witsensor_mutex_lock(&witsensor_hub.lock);
+        witsensor_hub.busy = NULL;
+        witsensor_cond_broadcast(&witsensor_hub.wake);
+    }
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+}
 
-        if (addr) simpleble_free(addr);
-        if (id) simpleble_free(id);
+// Append a job for the worker, starting it on first use
+static void _enqueue_job(witsensor_ble_simpleble_t *ble, int connect, const char *target) {
+    witsensor_ble_job_t *job = (witsensor_ble_job_t *)calloc(1, sizeof(witsensor_ble_job_t));
+    if (!job) {
+        if (connect) _queue_link(ble, WITSENSOR_LINK_FAILED, target, "out of memory");
+        return;
+    }
+    job->ble = ble;
+    job->connect = connect;
+    if (target) snprintf(job->target, sizeof(job->target), "%s", target);
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    if (connect) snprintf(ble->connecting, sizeof(ble->connecting), "%s", job->target);
+    if (!witsensor_hub.worker_running) {
+        witsensor_hub.worker_stop = 0;
+        witsensor_hub.worker_running = witsensor_thread_start(&witsensor_hub.worker, _worker_main, NULL);
+    }
+    if (!witsensor_hub.worker_running) {
+        // No thread: do the work here rather than not at all
+        witsensor_mutex_unlock(&witsensor_hub.lock);
+        _run_job(job);
+        free(job);
+        return;
     }
+    witsensor_ble_job_t **tail = &witsensor_hub.jobs;
+    while (*tail) tail = &(*tail)->next;
+    *tail = job;
+    witsensor_cond_broadcast(&witsensor_hub.wake);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+}
 
-    pd_error(ble_data->pd_obj, "WITSensorBLE: Device not found: %s", target);
-    return 0;
+void witsensor_ble_simpleble_connect_async(witsensor_ble_simpleble_t *ble_data, const char *target) {
+    if (!ble_data || !target) return;
+    _enqueue_job(ble_data, 1, target);
 }
 
-// Disconnect from device
-void witsensor_ble_simpleble_disconnect(witsensor_ble_simpleble_t *ble_data) {
+void witsensor_ble_simpleble_disconnect_async(witsensor_ble_simpleble_t *ble_data) {
     if (!ble_data) return;
-    
-    post("WITSensorBLE: Disconnecting from device...");
-    
-    if (ble_data->peripheral) {
-        simpleble_peripheral_disconnect(ble_data->peripheral);
-        simpleble_peripheral_release_handle(ble_data->peripheral);
-        ble_data->peripheral = NULL;
-    }
-    
-    ble_data->is_connected = 0;
-    post("WITSensorBLE: Disconnected from device");
+    _enqueue_job(ble_data, 0, NULL);
 }
 
-// Write data to device - send WIT sensor commands
-int witsensor_ble_simpleble_write_data(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length) {
+int witsensor_ble_simpleble_has_result(witsensor_ble_simpleble_t *ble_data, const char *target) {
+    if (!ble_data || !target) return 0;
+    witsensor_ble_simpleble_t *results = ble_data->scanner ? ble_data->scanner : ble_data;
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    int found = witsensor_scan_cache_find(&results->results, target) != NULL;
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    return found;
+}
+
+// Write to the WIT write characteristic. The handle is retained under the hub
+// lock for the whole write, so a disconnect on the worker cannot free the
+// peripheral underneath it.
+static int _write(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length, int request) {
     if (!ble_data || !data || length <= 0) return 0;
-    
-    if (!ble_data->is_connected || !ble_data->peripheral) {
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    witsensor_ble_handle_t *h = NULL;
+    if (ble_data->is_connected && ble_data->peripheral && ble_data->handle) h = _handle_retain(ble_data->handle);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    if (!h) {
         pd_error(ble_data->pd_obj, "WITSensorBLE: Not connected to device");
         return 0;
     }
-        
-    // Send data to WIT sensor using write characteristic
-    simpleble_peripheral_write_command(ble_data->peripheral, WIT_SERVICE_UUID, WIT_WRITE_CHARACTERISTIC_UUID, data, length);
-    return 1;
+    int ok = witsensor_hub.backend->write(h->peripheral, data, length, request);
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    _handle_release(h);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    return ok;
+}
+
+// Write data to device - send WIT sensor commands
+int witsensor_ble_simpleble_write_data(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length) {
+    return _write(ble_data, data, length, 0);
 }
 
 // Write via request (with response) to ensure delivery semantics for config/ASCII commands
 int witsensor_ble_simpleble_write_request_raw(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length) {
-    if (!ble_data || !data || length <= 0) return 0;
-    if (!ble_data->is_connected || !ble_data->peripheral) {
-        pd_error(ble_data->pd_obj, "WITSensorBLE: Not connected to device");
-        return 0;
-    }
-    simpleble_err_t err = simpleble_peripheral_write_request(
-        ble_data->peripheral,
-        WIT_SERVICE_UUID,
-        WIT_WRITE_CHARACTERISTIC_UUID,
-        data,
-        (uint16_t)length);
-    return (err == SIMPLEBLE_SUCCESS) ? 1 : 0;
+    return _write(ble_data, data, length, 1);
 }
 
 int witsensor_ble_simpleble_set_notifications_enabled(witsensor_ble_simpleble_t *ble_data, int enabled) {
     if (!ble_data || !ble_data->peripheral) return 0;
-    if (enabled) {
-        simpleble_peripheral_notify(
-            ble_data->peripheral,
-            WIT_SERVICE_UUID,
-            WIT_READ_CHARACTERISTIC_UUID,
-            simpleble_on_data_received,
-            ble_data);
-    } else {
-        simpleble_peripheral_unsubscribe(
-            ble_data->peripheral,
-            WIT_SERVICE_UUID,
-            WIT_READ_CHARACTERISTIC_UUID);
-    }
-    return 1;
+    return witsensor_hub.backend->notify(ble_data->peripheral, ble_data, enabled);
 }
 
 // Check if connected
@@ -508,6 +881,40 @@ int witsensor_ble_simpleble_is_scanning(witsensor_ble_simpleble_t *ble_data) {
     return ble_data->is_scanning;
 }
 
+// Check whether another object holds target
+int witsensor_ble_simpleble_is_claimed(witsensor_ble_simpleble_t *ble_data, const char *target) {
+    if (!ble_data || !target) return 0;
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    int claimed = _hub_claimed_by_other(ble_data, target);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    return claimed;
+}
+
+int witsensor_ble_simpleble_pick_wit(witsensor_ble_simpleble_t *ble_data, char *addr, size_t size) {
+    if (!ble_data || !addr || !size) return 0;
+    witsensor_ble_simpleble_t *results = ble_data->scanner ? ble_data->scanner : ble_data;
+    witsensor_scan_entry_t *best = NULL;
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    for (unsigned int i = 0; i < WITSENSOR_SCAN_ENTRIES; i++) {
+        witsensor_scan_entry_t *e = witsensor_scan_cache_at(&results->results, i);
+        if (!e || !e->is_wit || (best && e->rssi <= best->rssi)) continue;
+        if (_hub_claimed_by_other(ble_data, e->id) || _hub_claimed_by_other(ble_data, e->addr)) continue;
+        best = e;
+    }
+    // The address, since several sensors may advertise the same name
+    if (best) snprintf(addr, size, "%s", best->addr);
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    return best != NULL;
+}
+
+unsigned int witsensor_ble_simpleble_result_count(witsensor_ble_simpleble_t *ble_data) {
+    if (!ble_data) return 0;
+    witsensor_mutex_lock(&witsensor_hub.lock);
+    unsigned int n = ble_data->results.count;
+    witsensor_mutex_unlock(&witsensor_hub.lock);
+    return n;
+}
+
 // Permission probe: short bounded scan and count devices
 int witsensor_ble_simpleble_permcheck(witsensor_ble_simpleble_t *ble_data, int timeout_ms) {
     (void)timeout_ms;
@@ -10,6 +10,9 @@
 #define WITSENSOR_BLE_SIMPLEBLE_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "witsensor_scancache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,27 +22,41 @@ extern "C" {
 typedef void* simpleble_adapter_t;
 typedef void* simpleble_peripheral_t;
 
+// Link states reported to witsensor_pd_connected_handler
+typedef enum {
+    WITSENSOR_LINK_DISCONNECTED = 0,
+    WITSENSOR_LINK_CONNECTED = 1,
+    WITSENSOR_LINK_CONNECTING = 2,  // the worker started connecting
+    WITSENSOR_LINK_FAILED = 3       // connect attempt failed (reason attached)
+} witsensor_link_state_t;
+
 // BLE data structure
 typedef struct witsensor_ble_simpleble_t {
     void *pd_obj; // Pointer to the parent Pure Data object
-    void (*data_callback)(void *user_data, unsigned char *data, int length); // Callback for received data
+    void (*data_callback)(void *user_data, const unsigned char *data, int length); // Callback for received data
+    void *callback_data; // user_data for data_callback (pd_obj if NULL)
+    int tag;             // reported with connection events (device slot of the owner)
+    struct witsensor_ble_simpleble_t *scanner; // whose scan results connect uses (self if NULL)
 
-    simpleble_adapter_t adapter;
+    simpleble_adapter_t adapter;       // shared adapter owned by the scan hub
     simpleble_peripheral_t peripheral;
-    int is_scanning;
+    struct witsensor_ble_handle_t *handle; // reference to the scan handle behind peripheral
+    int is_scanning;                   // this object takes part in the hub scan
     int is_connected;
+    char connected_id[128];            // device held by this object (hub claim)
+    char connected_addr[64];
+    char connecting[128];              // target of a queued or running connect (hub claim)
+    struct witsensor_ble_simpleble_t *hub_next; // scan hub member list
 
-    // Performance monitoring
-    uint64_t data_count;
-    uint64_t last_data_time;
+    // Performance monitoring (BLE thread writes, any thread reads)
+    _Atomic uint64_t data_count;       // notifications received
+    _Atomic uint64_t last_data_ns;     // witsensor_now_ns of the newest one
 
     // Pd instance pointer for pd_queue_mess marshaling
     void *pd_instance;
 
-    // Cached scan results for GUI-thread-safe enumeration
-    char **cached_ids;
-    char **cached_addrs;
-    unsigned long cached_count;
+    // Devices this object's scan reported (guarded by the hub lock; 'clear' empties it)
+    witsensor_scan_cache_t results;
 
     // Debug/state
     int scan_found_count;
@@ -56,6 +73,12 @@ void witsensor_ble_simpleble_get_scan_results(witsensor_ble_simpleble_t *ble_dat
 void witsensor_ble_simpleble_clear_scan_results(witsensor_ble_simpleble_t *ble_data);
 int witsensor_ble_simpleble_connect(witsensor_ble_simpleble_t *ble_data, const char *target);
 void witsensor_ble_simpleble_disconnect(witsensor_ble_simpleble_t *ble_data);
+// Non-blocking variants: a shared worker thread runs the requests in order and
+// reports each outcome as a witsensor_link_state_t
+void witsensor_ble_simpleble_connect_async(witsensor_ble_simpleble_t *ble_data, const char *target);
+void witsensor_ble_simpleble_disconnect_async(witsensor_ble_simpleble_t *ble_data);
+// 1 if target (address or identifier) is in the scan results connect uses
+int witsensor_ble_simpleble_has_result(witsensor_ble_simpleble_t *ble_data, const char *target);
 int witsensor_ble_simpleble_write_data(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length);
 // Write via GATT write request (with response) to WIT write characteristic
 int witsensor_ble_simpleble_write_request_raw(witsensor_ble_simpleble_t *ble_data, const unsigned char *data, int length);
@@ -63,6 +86,12 @@ int witsensor_ble_simpleble_write_request_raw(witsensor_ble_simpleble_t *ble_dat
 int witsensor_ble_simpleble_set_notifications_enabled(witsensor_ble_simpleble_t *ble_data, int enabled);
 int witsensor_ble_simpleble_is_connected(witsensor_ble_simpleble_t *ble_data);
 int witsensor_ble_simpleble_is_scanning(witsensor_ble_simpleble_t *ble_data);
+// 1 if another object is already connected to target (identifier or address)
+int witsensor_ble_simpleble_is_claimed(witsensor_ble_simpleble_t *ble_data, const char *target);
+// Strongest WIT device in the scan results that nobody is connected to;
+// copies its address to addr and returns 1, or returns 0 if there is none
+int witsensor_ble_simpleble_pick_wit(witsensor_ble_simpleble_t *ble_data, char *addr, size_t size);
+unsigned int witsensor_ble_simpleble_result_count(witsensor_ble_simpleble_t *ble_data);
 // Permission probe: returns number of devices found after a short bounded scan,
 // or -1 on initialization failure
 int witsensor_ble_simpleble_ensure_initialized(witsensor_ble_simpleble_t *ble_data);
@@ -0,0 +1,156 @@
+/* witsensor_decode.c
+ * Decoding of 0x61 streaming frames into witsensor_frame_t values
+ *
+ * Words are little-endian int16 after the two header bytes. Accel, gyro and
+ * angle are scaled to g, deg/s and deg; displacement (mm) and speed (mm/s)
+ * are taken as they are. In the timestamp modes words 6 and 7 hold the
+ * sensor's ms clock instead of the x/y angles.
+ *
+ * Each output mode has its own batch kernel so the per-frame work is a fixed
+ * sequence without branches: words 0..7 are converted with one scale vector
+ * per mode (SSE2 or NEON: one 16-byte load, two int32 widenings, two
+ * multiplies), word 8 and the timestamp are done scalar. The scales are
+ * powers of two times small integers, so the single multiply gives the same
+ * floats as dividing by 32768 and multiplying by the range.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_decode.h"
+
+#if !defined(WITSENSOR_DECODE_NO_SIMD) \
+    && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define WITSENSOR_DECODE_SSE2 1
+#elif !defined(WITSENSOR_DECODE_NO_SIMD) \
+    && (defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)) \
+    && (defined(_M_ARM64) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+    #include <arm_neon.h>
+    #define WITSENSOR_DECODE_NEON 1
+#endif
+
+#define WITSENSOR_ACCEL_SCALE (16.0f / 32768.0f)   // g
+#define WITSENSOR_GYRO_SCALE (2000.0f / 32768.0f)  // deg/s
+#define WITSENSOR_ANGLE_SCALE (180.0f / 32768.0f)  // deg
+
+// Scale of words 0..7 per output mode; word 8 is always the z angle.
+// Timestamp modes zero words 6 and 7, the kernels store 0.0f there.
+static const float witsensor_decode_scales[4][8] = {
+    { WITSENSOR_ACCEL_SCALE, WITSENSOR_ACCEL_SCALE, WITSENSOR_ACCEL_SCALE,
+      WITSENSOR_GYRO_SCALE, WITSENSOR_GYRO_SCALE, WITSENSOR_GYRO_SCALE,
+      WITSENSOR_ANGLE_SCALE, WITSENSOR_ANGLE_SCALE },                   // accel gyro angle
+    { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+      WITSENSOR_ANGLE_SCALE, WITSENSOR_ANGLE_SCALE },                   // disp speed angle
+    { WITSENSOR_ACCEL_SCALE, WITSENSOR_ACCEL_SCALE, WITSENSOR_ACCEL_SCALE,
+      WITSENSOR_GYRO_SCALE, WITSENSOR_GYRO_SCALE, WITSENSOR_GYRO_SCALE,
+      0.0f, 0.0f },                                                     // accel gyro timestamp
+    { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f },                 // disp speed timestamp
+};
+
+static inline float witsensor_decode_word(const unsigned char *frame, int word, float scale) {
+    return (float)(int16_t)((frame[3 + 2 * word] << 8) | frame[2 + 2 * word]) * scale;
+}
+
+// Words 8 and (timestamp modes) 6/7, shared by every kernel
+static inline void witsensor_decode_tail(const unsigned char *frame, witsensor_frame_t *f, const int mode) {
+    f->v[8] = witsensor_decode_word(frame, 8, WITSENSOR_ANGLE_SCALE);
+    f->flags = witsensor_decode_flags(mode);
+    if (mode & 2) {
+        // Timestamp in ms: 32-bit little-endian composed from two int16 words
+        f->timestamp = (uint32_t)frame[14] | ((uint32_t)frame[15] << 8)
+                     | ((uint32_t)frame[16] << 16) | ((uint32_t)frame[17] << 24);
+        f->v[6] = 0.0f;
+        f->v[7] = 0.0f;
+    } else {
+        f->timestamp = 0;
+    }
+}
+
+static inline void witsensor_decode_scalar(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count,
+                                           witsensor_frame_t *out, const int mode) {
+    const float *scale = witsensor_decode_scales[mode];
+    for (int n = 0; n < count; n++) {
+        const unsigned char *frame = frames[n];
+        witsensor_frame_t *f = &out[n];
+        for (int i = 0; i < ((mode & 2) ? 6 : 8); i++) f->v[i] = witsensor_decode_word(frame, i, scale[i]);
+        witsensor_decode_tail(frame, f, mode);
+    }
+}
+
+#if defined(WITSENSOR_DECODE_SSE2)
+static inline void witsensor_decode_simd(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count,
+                                         witsensor_frame_t *out, const int mode) {
+    const __m128 scale_lo = _mm_loadu_ps(witsensor_decode_scales[mode]);
+    const __m128 scale_hi = _mm_loadu_ps(witsensor_decode_scales[mode] + 4);
+    for (int n = 0; n < count; n++) {
+        const unsigned char *frame = frames[n];
+        witsensor_frame_t *f = &out[n];
+        __m128i w = _mm_loadu_si128((const __m128i *)(frame + 2)); // words 0..7
+        // Duplicate each word into a 32-bit lane and shift back: sign extension
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16);
+        _mm_storeu_ps(f->v, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale_lo));
+        _mm_storeu_ps(f->v + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale_hi));
+        witsensor_decode_tail(frame, f, mode);
+    }
+}
+#elif defined(WITSENSOR_DECODE_NEON)
+static inline void witsensor_decode_simd(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count,
+                                         witsensor_frame_t *out, const int mode) {
+    const float32x4_t scale_lo = vld1q_f32(witsensor_decode_scales[mode]);
+    const float32x4_t scale_hi = vld1q_f32(witsensor_decode_scales[mode] + 4);
+    for (int n = 0; n < count; n++) {
+        const unsigned char *frame = frames[n];
+        witsensor_frame_t *f = &out[n];
+        int16x8_t w = vreinterpretq_s16_u8(vld1q_u8(frame + 2)); // words 0..7
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(w)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(w)));
+        vst1q_f32(f->v, vmulq_f32(lo, scale_lo));
+        vst1q_f32(f->v + 4, vmulq_f32(hi, scale_hi));
+        witsensor_decode_tail(frame, f, mode);
+    }
+}
+#endif
+
+// One specialised function per output mode and kernel
+#define WITSENSOR_DECODE_MODES(kernel) \
+    static void kernel##_0(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count, witsensor_frame_t *out) \
+        { kernel(frames, count, out, 0); } \
+    static void kernel##_1(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count, witsensor_frame_t *out) \
+        { kernel(frames, count, out, 1); } \
+    static void kernel##_2(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count, witsensor_frame_t *out) \
+        { kernel(frames, count, out, 2); } \
+    static void kernel##_3(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count, witsensor_frame_t *out) \
+        { kernel(frames, count, out, 3); } \
+    static const witsensor_decode_fn kernel##_kernels[4] = { kernel##_0, kernel##_1, kernel##_2, kernel##_3 };
+
+WITSENSOR_DECODE_MODES(witsensor_decode_scalar)
+#if defined(WITSENSOR_DECODE_SSE2) || defined(WITSENSOR_DECODE_NEON)
+WITSENSOR_DECODE_MODES(witsensor_decode_simd)
+#endif
+
+witsensor_decode_fn witsensor_decode_kernel(int output_mode, int simd) {
+    int mode = output_mode & 3;
+#if defined(WITSENSOR_DECODE_SSE2) || defined(WITSENSOR_DECODE_NEON)
+    if (simd) return witsensor_decode_simd_kernels[mode];
+#else
+    (void)simd;
+#endif
+    return witsensor_decode_scalar_kernels[mode];
+}
+
+const char *witsensor_decode_simd_name(void) {
+#if defined(WITSENSOR_DECODE_SSE2)
+    return "sse2";
+#elif defined(WITSENSOR_DECODE_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void witsensor_decode_stream(const unsigned char *frame, unsigned char flags, witsensor_frame_t *f) {
+    int mode = ((flags & WITSENSOR_FRAME_DISP_SPEED) ? 1 : 0) | ((flags & WITSENSOR_FRAME_TIMESTAMP) ? 2 : 0);
+    witsensor_decode_scalar_kernels[mode]((const unsigned char (*)[WITSENSOR_FRAME_SIZE])frame, 1, f);
+}
@@ -0,0 +1,47 @@
+/* witsensor_decode.h
+ * Decoding of 0x61 streaming frames into witsensor_frame_t values
+ * The output mode (AGPVSEL) picks what the nine int16 words mean
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_DECODE_H
+#define WITSENSOR_DECODE_H
+
+#include "witsensor_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Frames a caller collects before one batch decode (a full 512-byte MTU
+// notification holds 25)
+#define WITSENSOR_DECODE_BATCH 32
+
+// Frame flags (WITSENSOR_FRAME_*) for an output mode 0..3
+static inline unsigned char witsensor_decode_flags(int output_mode) {
+    return (unsigned char)(((output_mode & 1) ? WITSENSOR_FRAME_DISP_SPEED : 0)
+                         | (((output_mode >> 1) & 1) ? WITSENSOR_FRAME_TIMESTAMP : 0));
+}
+
+// Batch kernel for one output mode: decodes count 20-byte 0x61 frames and
+// fills v, timestamp and flags of out[0..count-1] (seq and host times are
+// left to the caller)
+typedef void (*witsensor_decode_fn)(const unsigned char (*frames)[WITSENSOR_FRAME_SIZE], int count,
+                                    witsensor_frame_t *out);
+
+// Kernel for an output mode 0..3, chosen once per mode change. With simd set
+// it is the SSE2/NEON one where the build has it, the scalar one otherwise.
+witsensor_decode_fn witsensor_decode_kernel(int output_mode, int simd);
+// Instruction set behind the simd kernels: "sse2", "neon" or "scalar"
+const char *witsensor_decode_simd_name(void);
+
+// Decode a single frame with the scalar kernel for flags
+void witsensor_decode_stream(const unsigned char *frame, unsigned char flags, witsensor_frame_t *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_DECODE_H
@@ -0,0 +1,129 @@
+/* witsensor_dejitter.c
+ * Mapping of device timestamps to host time for jitter-free frame delivery
+ *
+ * BLE only ever delays a frame, so for each frame host - device time is the
+ * clock offset plus a non-negative transport delay. The least delayed frame of
+ * each window lies close to the true offset; a least-squares slope through the
+ * recent window minima gives the drift between the two clocks, and the line
+ * with that slope through the lowest minimum is the envelope frames are
+ * mapped onto. The jitter buffer is the decaying peak of how far frames land
+ * above the envelope, so delivery waits just long enough for late frames.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_dejitter.h"
+#include <string.h>
+
+#define MAX_DRIFT 0.01 // crystal or RC oscillator: far below 1%
+
+void witsensor_dejitter_init(witsensor_dejitter_t *dj) {
+    if (!dj) return;
+    memset(dj, 0, sizeof(*dj));
+}
+
+static void witsensor_dejitter_start(witsensor_dejitter_t *dj, uint32_t ts, double host_ms) {
+    uint64_t restarts = dj->restarts + (dj->started ? 1 : 0);
+    memset(dj, 0, sizeof(*dj));
+    dj->restarts = restarts;
+    dj->started = 1;
+    dj->last_ts = ts;
+    dj->device_ms = (double)ts;
+    dj->win_end = dj->device_ms + WITSENSOR_DEJITTER_WINDOW_MS;
+    dj->win_s = dj->device_ms;
+    dj->win_d = host_ms - dj->device_ms;
+    dj->ref_s = dj->win_s;
+    dj->offset = dj->win_d;
+}
+
+// Slope through the stored minima, then the lowest line with that slope
+static void witsensor_dejitter_fit(witsensor_dejitter_t *dj) {
+    unsigned int n = dj->min_count;
+    double mean_s = 0, mean_d = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        mean_s += dj->min_s[i];
+        mean_d += dj->min_d[i];
+    }
+    mean_s /= n;
+    mean_d /= n;
+    if (n >= 3) {
+        double sxx = 0, sxy = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            double ds = dj->min_s[i] - mean_s;
+            sxx += ds * ds;
+            sxy += ds * (dj->min_d[i] - mean_d);
+        }
+        if (sxx > 0) {
+            dj->drift = sxy / sxx;
+            if (dj->drift > MAX_DRIFT) dj->drift = MAX_DRIFT;
+            if (dj->drift < -MAX_DRIFT) dj->drift = -MAX_DRIFT;
+        }
+    }
+    dj->ref_s = mean_s;
+    dj->offset = mean_d;
+    for (unsigned int i = 0; i < n; i++) {
+        double d = dj->min_d[i] - dj->drift * (dj->min_s[i] - mean_s);
+        if (d < dj->offset) dj->offset = d;
+    }
+}
+
+double witsensor_dejitter_map(witsensor_dejitter_t *dj, uint32_t ts, double host_ms) {
+    if (!dj) return host_ms;
+    if (dj->started) {
+        // Unsigned difference survives the 32-bit wrap; a step back is huge
+        double step = (double)(uint32_t)(ts - dj->last_ts);
+        if (step > WITSENSOR_DEJITTER_RESTART_MS) {
+            witsensor_dejitter_start(dj, ts, host_ms);
+        } else {
+            dj->device_ms += step;
+            dj->last_ts = ts;
+        }
+    } else {
+        witsensor_dejitter_start(dj, ts, host_ms);
+    }
+    double s = dj->device_ms;
+    double d = host_ms - s;
+    dj->frames++;
+
+    if (s >= dj->win_end) {
+        dj->min_s[dj->min_next] = dj->win_s;
+        dj->min_d[dj->min_next] = dj->win_d;
+        dj->min_next = (dj->min_next + 1) % WITSENSOR_DEJITTER_WINDOWS;
+        if (dj->min_count < WITSENSOR_DEJITTER_WINDOWS) dj->min_count++;
+        witsensor_dejitter_fit(dj);
+        dj->win_end = s + WITSENSOR_DEJITTER_WINDOW_MS;
+        dj->win_s = s;
+        dj->win_d = d;
+    } else if (d < dj->win_d) {
+        dj->win_s = s;
+        dj->win_d = d;
+    }
+
+    double envelope = dj->offset + dj->drift * (s - dj->ref_s);
+    if (d < envelope) {
+        // Faster than any frame so far: the envelope was too high
+        dj->offset -= envelope - d;
+        envelope = d;
+    }
+    double late = d - envelope;
+    if (late > WITSENSOR_DEJITTER_RESTART_MS) {
+        // Host stalled or the sensor paused streaming: start over from here
+        witsensor_dejitter_start(dj, ts, host_ms);
+        dj->frames = 1;
+        envelope = d;
+        late = 0;
+    }
+    dj->jitter_peak *= 0.999;
+    if (late > dj->jitter_peak) dj->jitter_peak = late;
+
+    double due = s + envelope + witsensor_dejitter_buffer(dj);
+    if (due < dj->last_due) due = dj->last_due;
+    dj->last_due = due;
+    return due;
+}
+
+double witsensor_dejitter_buffer(const witsensor_dejitter_t *dj) {
+    if (!dj) return 0;
+    return dj->jitter_peak < WITSENSOR_DEJITTER_MAX_BUFFER_MS ? dj->jitter_peak : WITSENSOR_DEJITTER_MAX_BUFFER_MS;
+}
@@ -0,0 +1,55 @@
+/* witsensor_dejitter.h
+ * Mapping of device timestamps to the caller's clock (Pd logical time) for jitter-free delivery
+ * Used with output modes 2/3, where every frame carries the sensor's ms clock
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_DEJITTER_H
+#define WITSENSOR_DEJITTER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_DEJITTER_WINDOWS 16          // window minima kept for the drift fit
+#define WITSENSOR_DEJITTER_WINDOW_MS 1000.0    // device time covered by one minimum
+#define WITSENSOR_DEJITTER_MAX_BUFFER_MS 100.0 // jitter buffer ceiling
+#define WITSENSOR_DEJITTER_RESTART_MS 2000.0   // device clock jump or stall treated as a restart
+
+typedef struct witsensor_dejitter_t {
+    int started;
+    uint32_t last_ts;       // raw device time of the previous frame
+    double device_ms;       // device time unwrapped past 32 bits
+    // Smallest host - device difference per window: the least delayed frames
+    double win_end;
+    double win_s, win_d;
+    double min_s[WITSENSOR_DEJITTER_WINDOWS];
+    double min_d[WITSENSOR_DEJITTER_WINDOWS];
+    unsigned int min_count;
+    unsigned int min_next;
+    // Fitted lower envelope: host = device + offset + drift * (device - ref)
+    double ref_s;
+    double offset;
+    double drift;           // host ms per device ms - 1
+    double jitter_peak;     // decaying peak of frame delay above the envelope
+    double last_due;        // mapped times never decrease
+    uint64_t frames;
+    uint64_t restarts;
+} witsensor_dejitter_t;
+
+void witsensor_dejitter_init(witsensor_dejitter_t *dj);
+// Feed a frame's device timestamp (ms) and arrival time (ms, caller's clock). Returns the
+// local time to deliver it at: on the fitted envelope plus the jitter buffer.
+double witsensor_dejitter_map(witsensor_dejitter_t *dj, uint32_t device_ms, double host_ms);
+// Current jitter buffer depth in ms
+double witsensor_dejitter_buffer(const witsensor_dejitter_t *dj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_DEJITTER_H
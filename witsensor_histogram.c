@@ -0,0 +1,69 @@
+/* witsensor_histogram.c
+ * Log-bucket latency histogram with quantile queries
+ *
+ * Values below 2^SUB_BITS get a bucket each. Above that, bucket k of a
+ * power-of-two range [2^e, 2^(e+1)) holds values whose SUB_BITS bits after
+ * the leading one equal k, so the bucket width is 2^(e - SUB_BITS).
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_histogram.h"
+#include <string.h>
+
+#define SUB (1u << WITSENSOR_HISTOGRAM_SUB_BITS)
+
+static int witsensor_histogram_log2(uint64_t v) {
+    int e = 0;
+    while (v >>= 1) e++;
+    return e;
+}
+
+static unsigned int witsensor_histogram_index(uint64_t v) {
+    if (v < SUB) return (unsigned int)v;
+    int e = witsensor_histogram_log2(v);
+    if (e >= WITSENSOR_HISTOGRAM_MAX_BITS) return WITSENSOR_HISTOGRAM_OVERFLOW;
+    unsigned int sub = (unsigned int)(v >> (e - WITSENSOR_HISTOGRAM_SUB_BITS)) & (SUB - 1);
+    return (unsigned int)(e - WITSENSOR_HISTOGRAM_SUB_BITS + 1) * SUB + sub;
+}
+
+// Midpoint of a bucket's value range
+static uint64_t witsensor_histogram_value(unsigned int index) {
+    if (index < SUB) return index;
+    int e = (int)(index / SUB) - 1 + WITSENSOR_HISTOGRAM_SUB_BITS;
+    uint64_t width = 1ull << (e - WITSENSOR_HISTOGRAM_SUB_BITS);
+    uint64_t low = (1ull << e) + (uint64_t)(index % SUB) * width;
+    return low + width / 2;
+}
+
+void witsensor_histogram_reset(witsensor_histogram_t *h) {
+    if (!h) return;
+    memset(h, 0, sizeof(*h));
+}
+
+void witsensor_histogram_add(witsensor_histogram_t *h, uint64_t value) {
+    if (!h) return;
+    h->counts[witsensor_histogram_index(value)]++;
+    h->total++;
+    if (value > h->max) h->max = value;
+}
+
+uint64_t witsensor_histogram_quantile(const witsensor_histogram_t *h, double q) {
+    if (!h || !h->total) return 0;
+    if (q < 0) q = 0;
+    if (q > 1) q = 1;
+    // Rank of the sample sought, 1-based
+    uint64_t rank = (uint64_t)(q * (double)h->total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < WITSENSOR_HISTOGRAM_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            if (i == WITSENSOR_HISTOGRAM_OVERFLOW) return h->max;
+            uint64_t v = witsensor_histogram_value(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
@@ -0,0 +1,40 @@
+/* witsensor_histogram.h
+ * Log-bucket latency histogram with quantile queries
+ * Power-of-two ranges split into linear sub-buckets (about 6% resolution),
+ * fixed size, no allocation; one thread records and queries
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_HISTOGRAM_H
+#define WITSENSOR_HISTOGRAM_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_HISTOGRAM_SUB_BITS 4                             // 16 sub-buckets per power of two
+#define WITSENSOR_HISTOGRAM_MAX_BITS 40                            // values up to 2^40 ns (18 min)
+// In-range buckets, then one overflow bucket for values of 2^MAX_BITS and up
+#define WITSENSOR_HISTOGRAM_OVERFLOW ((WITSENSOR_HISTOGRAM_MAX_BITS - WITSENSOR_HISTOGRAM_SUB_BITS + 1) << WITSENSOR_HISTOGRAM_SUB_BITS)
+#define WITSENSOR_HISTOGRAM_BUCKETS (WITSENSOR_HISTOGRAM_OVERFLOW + 1)
+
+typedef struct witsensor_histogram_t {
+    uint32_t counts[WITSENSOR_HISTOGRAM_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} witsensor_histogram_t;
+
+void witsensor_histogram_reset(witsensor_histogram_t *h);
+void witsensor_histogram_add(witsensor_histogram_t *h, uint64_t value);
+// Value below which a fraction q (0..1) of the samples lie, 0 when empty
+uint64_t witsensor_histogram_quantile(const witsensor_histogram_t *h, double q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_HISTOGRAM_H
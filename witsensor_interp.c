@@ -0,0 +1,162 @@
+/* witsensor_interp.c
+ * Resampling of irregular sensor frames to a continuous sample clock
+ *
+ * Frames arrive in bursts (several notifications per BLE connection event),
+ * so each frame is placed one estimated period after the previous one and
+ * only re-anchored to its arrival time when the two drift apart. Playback
+ * runs behind the newest frame by the largest recent arrival gap so that
+ * linear/cubic segments always have their right-hand neighbours.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_interp.h"
+#include <math.h>
+#include <string.h>
+
+#define HISTORY_MASK (WITSENSOR_INTERP_HISTORY - 1)
+#define POINT(ip, i) (&(ip)->points[(i) & HISTORY_MASK])
+
+void witsensor_interp_init(witsensor_interp_t *ip, int channels, int is_quat, uint32_t wrap_mask, double period) {
+    if (!ip) return;
+    memset(ip, 0, sizeof(*ip));
+    if (channels > WITSENSOR_INTERP_MAX_CHANNELS) channels = WITSENSOR_INTERP_MAX_CHANNELS;
+    ip->channels = is_quat ? 4 : channels;
+    ip->is_quat = is_quat;
+    ip->wrap_mask = wrap_mask;
+    ip->period = period > 1.0 ? period : 1.0;
+    ip->gap_peak = ip->period;
+}
+
+void witsensor_interp_push(witsensor_interp_t *ip, double now, const float *values) {
+    if (!ip || !values) return;
+    double t = now;
+    if (ip->total > 0) {
+        double gap = now - ip->last_arrival;
+        if (gap >= 0 && gap < 32.0 * ip->period + ip->gap_peak) {
+            // Mean of per-frame gaps is the frame period, even when frames come in bursts
+            ip->period += 0.02 * (gap - ip->period);
+            if (ip->period < 1.0) ip->period = 1.0;
+            ip->gap_peak *= 0.995;
+            if (gap > ip->gap_peak) ip->gap_peak = gap;
+            t = POINT(ip, ip->total - 1)->t + ip->period;
+            // Re-anchor when the regular grid has drifted away from arrivals;
+            // earlier points never lie beyond now + 2 periods, so t stays monotonic
+            if (t < now - 8.0 * ip->period - ip->gap_peak) t = now;
+            else if (t > now + 2.0 * ip->period) t = now + 2.0 * ip->period;
+        }
+    }
+    witsensor_interp_point_t *p = POINT(ip, ip->total);
+    p->t = t;
+    for (int c = 0; c < ip->channels; c++) p->v[c] = values[c];
+    ip->total++;
+    ip->last_arrival = now;
+}
+
+double witsensor_interp_block_start(witsensor_interp_t *ip, witsensor_interp_mode_t mode, double now, int n) {
+    if (!ip) return now;
+    double target = 0.0;
+    if (mode != WITSENSOR_INTERP_HOLD) {
+        target = (mode == WITSENSOR_INTERP_CUBIC ? 2.0 : 1.0) * ip->period + ip->gap_peak;
+    }
+    // Move at most half a block per block: playback speed stays within 0.5x..1.5x
+    double step = 0.5 * (double)n;
+    if (target > ip->delay + step) ip->delay += step;
+    else if (target < ip->delay - step) ip->delay -= step;
+    else ip->delay = target;
+    return now - ip->delay;
+}
+
+// Shortest signed difference between two angles in degrees
+static float witsensor_wrap180(float d) {
+    while (d >= 180.0f) d -= 360.0f;
+    while (d < -180.0f) d += 360.0f;
+    return d;
+}
+
+static void witsensor_slerp(const float *a, const float *b, float u, float *out) {
+    float bb[4] = {b[0], b[1], b[2], b[3]};
+    float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    if (d < 0.0f) { // take the short way round
+        d = -d;
+        for (int i = 0; i < 4; i++) bb[i] = -bb[i];
+    }
+    float wa, wb;
+    if (d > 0.9995f) {
+        wa = 1.0f - u;
+        wb = u;
+    } else {
+        float th = acosf(d);
+        float s = sinf(th);
+        wa = sinf((1.0f - u) * th) / s;
+        wb = sinf(u * th) / s;
+    }
+    float n = 0.0f;
+    for (int i = 0; i < 4; i++) {
+        out[i] = wa * a[i] + wb * bb[i];
+        n += out[i] * out[i];
+    }
+    if (n > 0.0f) {
+        n = 1.0f / sqrtf(n);
+        for (int i = 0; i < 4; i++) out[i] *= n;
+    }
+}
+
+void witsensor_interp_eval(witsensor_interp_t *ip, witsensor_interp_mode_t mode, double t, float *out) {
+    if (!ip || !out) return;
+    if (ip->total == 0) {
+        for (int c = 0; c < ip->channels; c++) out[c] = 0.0f;
+        return;
+    }
+    uint32_t last = ip->total - 1;
+    if (mode == WITSENSOR_INTERP_HOLD) {
+        memcpy(out, POINT(ip, last)->v, sizeof(float) * (size_t)ip->channels);
+        return;
+    }
+    uint32_t first = ip->total > WITSENSOR_INTERP_HISTORY ? ip->total - WITSENSOR_INTERP_HISTORY : 0;
+    if (ip->cursor < first) ip->cursor = first;
+    while (ip->cursor < last && POINT(ip, ip->cursor + 1)->t <= t) ip->cursor++;
+
+    const witsensor_interp_point_t *p1 = POINT(ip, ip->cursor);
+    if (ip->cursor >= last || t <= p1->t) {
+        memcpy(out, p1->v, sizeof(float) * (size_t)ip->channels);
+        return;
+    }
+    const witsensor_interp_point_t *p2 = POINT(ip, ip->cursor + 1);
+    double span = p2->t - p1->t;
+    float u = span > 0.0 ? (float)((t - p1->t) / span) : 1.0f;
+    if (u > 1.0f) u = 1.0f;
+
+    if (ip->is_quat) {
+        witsensor_slerp(p1->v, p2->v, u, out);
+        return;
+    }
+    if (mode == WITSENSOR_INTERP_LINEAR) {
+        for (int c = 0; c < ip->channels; c++) {
+            if (ip->wrap_mask & (1u << c)) {
+                out[c] = witsensor_wrap180(p1->v[c] + u * witsensor_wrap180(p2->v[c] - p1->v[c]));
+            } else {
+                out[c] = p1->v[c] + u * (p2->v[c] - p1->v[c]);
+            }
+        }
+        return;
+    }
+    // Catmull-Rom; missing outer neighbours are replaced by the segment ends
+    const witsensor_interp_point_t *p0 = ip->cursor > first ? POINT(ip, ip->cursor - 1) : p1;
+    const witsensor_interp_point_t *p3 = ip->cursor + 1 < last ? POINT(ip, ip->cursor + 2) : p2;
+    float u2 = u * u, u3 = u2 * u;
+    for (int c = 0; c < ip->channels; c++) {
+        float y0 = p0->v[c], y1 = p1->v[c], y2 = p2->v[c], y3 = p3->v[c];
+        int wrap = (ip->wrap_mask & (1u << c)) != 0;
+        if (wrap) { // unwrap neighbours around y1
+            y0 = y1 + witsensor_wrap180(y0 - y1);
+            y2 = y1 + witsensor_wrap180(y2 - y1);
+            y3 = y2 + witsensor_wrap180(y3 - y2);
+        }
+        float y = 0.5f * (2.0f * y1 + (y2 - y0) * u
+                          + (2.0f * y0 - 5.0f * y1 + 4.0f * y2 - y3) * u2
+                          + (3.0f * y1 - y0 - 3.0f * y2 + y3) * u3);
+        out[c] = wrap ? witsensor_wrap180(y) : y;
+    }
+}
@@ -0,0 +1,58 @@
+/* witsensor_interp.h
+ * Resampling of irregular sensor frames to a continuous sample clock
+ * Used by [witsensor~] to turn streamed frames into signals
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_INTERP_H
+#define WITSENSOR_INTERP_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_INTERP_MAX_CHANNELS 9
+#define WITSENSOR_INTERP_HISTORY 16  // points kept (power of two)
+
+typedef enum {
+    WITSENSOR_INTERP_HOLD = 0,   // last received value, no added latency
+    WITSENSOR_INTERP_LINEAR = 1, // straight line between frames
+    WITSENSOR_INTERP_CUBIC = 2   // Catmull-Rom through neighbouring frames
+} witsensor_interp_mode_t;
+
+typedef struct witsensor_interp_point_t {
+    double t; // position on the sample clock
+    float v[WITSENSOR_INTERP_MAX_CHANNELS];
+} witsensor_interp_point_t;
+
+typedef struct witsensor_interp_t {
+    int channels;
+    int is_quat;            // 4 channels (w x y z) interpolated with slerp
+    uint32_t wrap_mask;     // channels in degrees that wrap at +-180
+    witsensor_interp_point_t points[WITSENSOR_INTERP_HISTORY];
+    uint32_t total;         // points pushed so far
+    uint32_t cursor;        // absolute index of the current segment start
+    double period;          // estimated frame spacing in samples
+    double gap_peak;        // decaying peak of arrival gaps in samples
+    double last_arrival;
+    double delay;           // current playback delay in samples
+} witsensor_interp_t;
+
+void witsensor_interp_init(witsensor_interp_t *ip, int channels, int is_quat, uint32_t wrap_mask, double period);
+// Add a frame that arrived at sample time 'now' (Pd thread)
+void witsensor_interp_push(witsensor_interp_t *ip, double now, const float *values);
+// Playback time of the next block of n samples at sample time 'now'. The delay
+// keeps enough frames ahead for 'mode' and slews so playback never runs backwards.
+double witsensor_interp_block_start(witsensor_interp_t *ip, witsensor_interp_mode_t mode, double now, int n);
+// Evaluate at sample time t; t must not decrease between calls
+void witsensor_interp_eval(witsensor_interp_t *ip, witsensor_interp_mode_t mode, double t, float *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_INTERP_H
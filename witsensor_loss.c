@@ -0,0 +1,82 @@
+/* witsensor_loss.c
+ * Frame loss accounting from stream cadence
+ *
+ * With timestamps (output modes 2/3) the device clock says exactly how far
+ * apart two frames were made; the spacing is learned from the stream, seeded
+ * from the configured rate, and a step of n periods means n - 1 frames went
+ * missing. Without timestamps only the arrival spacing is left: a silence
+ * well beyond the BLE burst pattern is divided by the configured period.
+ * Frames the local queue dropped show up as jumps in the producer sequence
+ * and are not counted as link loss.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_loss.h"
+#include <math.h>
+#include <string.h>
+
+void witsensor_loss_init(witsensor_loss_t *loss) {
+    if (!loss) return;
+    memset(loss, 0, sizeof(*loss));
+}
+
+static void witsensor_loss_mark(witsensor_loss_t *loss, const witsensor_frame_t *f, int timed) {
+    loss->last_ts = f->timestamp;
+    loss->last_rx_ns = f->rx_ns;
+    loss->last_seq = f->seq;
+    loss->last_timed = timed;
+}
+
+unsigned int witsensor_loss_check(witsensor_loss_t *loss, const witsensor_frame_t *f,
+                                  double rate_period_ms, double *gap_ms) {
+    if (gap_ms) *gap_ms = 0;
+    if (!loss || !f) return 0;
+    int timed = (f->flags & WITSENSOR_FRAME_TIMESTAMP) != 0;
+    loss->frames++;
+    if (rate_period_ms != loss->rate_period_ms) {
+        // New rate: forget the learned spacing
+        loss->rate_period_ms = rate_period_ms;
+        loss->period_ms = 0;
+    }
+    if (!loss->started || timed != loss->last_timed) {
+        // First frame or output mode switch: new baseline
+        loss->started = 1;
+        witsensor_loss_mark(loss, f, timed);
+        return 0;
+    }
+    uint32_t queue_drops = f->seq - loss->last_seq - 1;
+    double dt;
+    double lost = 0;
+    if (timed) {
+        uint32_t step = f->timestamp - loss->last_ts;
+        if (step == 0 || step > 0x7FFFFFFFu) {
+            // Duplicate or the device clock went back (sensor restart)
+            witsensor_loss_mark(loss, f, timed);
+            return 0;
+        }
+        dt = (double)step;
+        double period = loss->period_ms > 0 ? loss->period_ms : rate_period_ms;
+        if (period <= 0) period = dt;
+        double periods = floor(dt / period + 0.5);
+        if (periods >= 2) {
+            lost = periods - 1;
+        } else {
+            loss->period_ms = loss->period_ms > 0 ? loss->period_ms + 0.05 * (dt - loss->period_ms) : dt;
+        }
+    } else {
+        dt = (double)(f->rx_ns - loss->last_rx_ns) / 1e6;
+        if (rate_period_ms > 0 && dt > 2.0 * rate_period_ms + WITSENSOR_LOSS_ARRIVAL_SLACK_MS) {
+            lost = floor(dt / rate_period_ms + 0.5) - 1;
+        }
+    }
+    witsensor_loss_mark(loss, f, timed);
+    lost -= (double)queue_drops;
+    if (lost < 1) return 0;
+    loss->gaps++;
+    loss->lost += (uint64_t)lost;
+    loss->gap_ms += dt;
+    if (gap_ms) *gap_ms = dt;
+    return (unsigned int)lost;
+}
@@ -0,0 +1,49 @@
+/* witsensor_loss.h
+ * Frame loss accounting from stream cadence
+ * Device timestamps when the sensor sends them, arrival spacing otherwise
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_LOSS_H
+#define WITSENSOR_LOSS_H
+
+#include <stdint.h>
+#include "witsensor_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Arrival spacing: BLE delivers frames in bursts once per connection event,
+// so silence only counts as a gap beyond this slack plus two frame periods
+#define WITSENSOR_LOSS_ARRIVAL_SLACK_MS 60.0
+
+typedef struct witsensor_loss_t {
+    int started;
+    uint32_t last_ts;      // device ms of the previous frame (timestamp mode)
+    uint64_t last_rx_ns;   // arrival of the previous frame
+    uint32_t last_seq;     // producer sequence: jumps are local queue drops
+    int last_timed;        // previous frame carried a timestamp
+    double period_ms;      // frame spacing learned from timestamps, 0: unknown
+    double rate_period_ms; // configured spacing the learned one was seeded from
+    // Running totals for the connection
+    uint64_t frames;
+    uint64_t gaps;
+    uint64_t lost;
+    double gap_ms;         // summed duration of the gaps
+} witsensor_loss_t;
+
+void witsensor_loss_init(witsensor_loss_t *loss);
+// Account one frame (in producer order). rate_period_ms is the spacing the
+// configured rate implies. Returns the frames estimated lost on the link
+// just before this one and sets *gap_ms to the silence they left; 0 if none.
+unsigned int witsensor_loss_check(witsensor_loss_t *loss, const witsensor_frame_t *frame,
+                                  double rate_period_ms, double *gap_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_LOSS_H
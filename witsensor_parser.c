@@ -0,0 +1,172 @@
+/* witsensor_parser.c
+ * Reassembly of WIT frames from BLE notifications
+ *
+ * Frames are 20 bytes starting with 0x55 followed by a type byte. The parser
+ * walks each notification, hands out every complete frame, keeps a trailing
+ * partial frame for the next notification and skips garbage up to the next
+ * valid header. Register responses are decoded from a descriptor table.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_parser.h"
+#include <string.h>
+
+static int witsensor_parser_known_type(unsigned char type) {
+    return type == WITSENSOR_FRAME_STREAM || type == WITSENSOR_FRAME_REGISTER;
+}
+
+void witsensor_parser_init(witsensor_parser_t *parser) {
+    if (!parser) return;
+    memset(parser, 0, sizeof(*parser));
+}
+
+void witsensor_parser_reset(witsensor_parser_t *parser) {
+    if (!parser) return;
+    parser->partial_count = 0;
+}
+
+int witsensor_parser_feed(witsensor_parser_t *parser, const unsigned char *data, int length,
+                          witsensor_frame_callback_t callback, void *user_data) {
+    if (!parser || !data || length <= 0) return 0;
+    int delivered = 0;
+    int i = 0;
+
+    // A lone carried-over header byte can only be validated now
+    if (parser->partial_count == 1 && !witsensor_parser_known_type(data[0])) {
+        parser->partial_count = 0;
+        parser->resyncs++;
+        parser->skipped++;
+    }
+    // Complete the frame carried over from the previous notification
+    if (parser->partial_count > 0) {
+        int take = WITSENSOR_FRAME_SIZE - parser->partial_count;
+        if (take > length) take = length;
+        memcpy(parser->partial + parser->partial_count, data, (size_t)take);
+        parser->partial_count += take;
+        i = take;
+        if (parser->partial_count < WITSENSOR_FRAME_SIZE) return 0;
+        parser->partial_count = 0;
+        parser->frames++;
+        delivered++;
+        if (callback) callback(user_data, parser->partial);
+    }
+
+    int in_resync = 0;
+    while (i < length) {
+        int remaining = length - i;
+        if (data[i] != WITSENSOR_FRAME_HEADER
+            || (remaining > 1 && !witsensor_parser_known_type(data[i + 1]))) {
+            if (!in_resync) parser->resyncs++;
+            in_resync = 1;
+            parser->skipped++;
+            i++;
+            continue;
+        }
+        in_resync = 0;
+        if (remaining < WITSENSOR_FRAME_SIZE) {
+            memcpy(parser->partial, data + i, (size_t)remaining);
+            parser->partial_count = remaining;
+            break;
+        }
+        parser->frames++;
+        delivered++;
+        if (callback) callback(user_data, data + i);
+        i += WITSENSOR_FRAME_SIZE;
+    }
+    return delivered;
+}
+
+// Register responses known to the decoder; one row per output
+const witsensor_register_desc_t witsensor_registers[] = {
+    // addr words flags                                              outlet                   scale             name
+    { 0x64, 1, WITSENSOR_REGISTER_BATTERY,                          WITSENSOR_OUTLET_STATUS, 0.01f,            "battery"   },
+    { 0x40, 1, WITSENSOR_REGISTER_SIGNED,                           WITSENSOR_OUTLET_STATUS, 0.01f,            "temp"      },
+    { 0x3A, 3, WITSENSOR_REGISTER_SIGNED | WITSENSOR_REGISTER_MAG,  WITSENSOR_OUTLET_DATA,   1.0f / 150.0f,    "mag"       },
+    { 0x51, 4, WITSENSOR_REGISTER_SIGNED | WITSENSOR_REGISTER_QUAT, WITSENSOR_OUTLET_DATA,   1.0f / 32768.0f,  "quat"      },
+    { 0x2E, 2, 0,                                                   WITSENSOR_OUTLET_STATUS, 1.0f,             "version"   },
+    { 0x30, 4, WITSENSOR_REGISTER_DATETIME,                         WITSENSOR_OUTLET_STATUS, 1.0f,             "time"      },
+    // Not looked up by address: any response without a row of its own
+    { 0x00, 8, WITSENSOR_REGISTER_RAW,                              WITSENSOR_OUTLET_STATUS, 1.0f,             "reg"       },
+};
+const int witsensor_register_count = (int)(sizeof(witsensor_registers) / sizeof(witsensor_registers[0]));
+_Static_assert(sizeof(witsensor_registers) / sizeof(witsensor_registers[0]) <= WITSENSOR_REGISTER_ROWS_MAX,
+               "raise WITSENSOR_REGISTER_ROWS_MAX");
+
+static signed char witsensor_register_rows[256];
+static int witsensor_register_raw_row = -1;
+
+void witsensor_register_init(void) {
+    memset(witsensor_register_rows, -1, sizeof(witsensor_register_rows));
+    for (int i = 0; i < witsensor_register_count; i++) {
+        if (witsensor_registers[i].flags & WITSENSOR_REGISTER_RAW) {
+            witsensor_register_raw_row = i;
+            continue;
+        }
+        witsensor_register_rows[witsensor_registers[i].addr] = (signed char)i;
+    }
+}
+
+int witsensor_register_lookup(unsigned char addr) {
+    return witsensor_register_rows[addr];
+}
+
+// Charge estimate from battery centivolts (vendor discharge curve)
+static int witsensor_battery_percent(unsigned int centivolts) {
+    static const struct { unsigned int min; int pct; } curve[] = {
+        {397, 100}, {393, 90}, {387, 75}, {382, 60}, {379, 50}, {377, 40},
+        {373, 30}, {370, 20}, {368, 15}, {350, 10}, {340, 5}
+    };
+    for (size_t i = 0; i < sizeof(curve) / sizeof(curve[0]); i++) {
+        if (centivolts >= curve[i].min) return curve[i].pct;
+    }
+    return 0;
+}
+
+// Decode the words of one row starting at w
+static void witsensor_register_decode_row(int row, const unsigned char *w, witsensor_register_t *out) {
+    const witsensor_register_desc_t *desc = &witsensor_registers[row];
+    out->argc = 0;
+    if (desc->flags & WITSENSOR_REGISTER_DATETIME) {
+        // Three words of two byte fields each, then the milliseconds
+        for (int i = 0; i < 6; i++) out->v[out->argc++] = (float)w[i];
+        out->v[out->argc++] = (float)(w[6] | (w[7] << 8));
+    } else {
+        for (int i = 0; i < desc->words; i++) {
+            unsigned int raw = (unsigned int)(w[2 * i] | (w[2 * i + 1] << 8));
+            float value = (desc->flags & WITSENSOR_REGISTER_SIGNED) ? (float)(int16_t)raw : (float)raw;
+            out->v[out->argc++] = value * desc->scale;
+        }
+    }
+    if (desc->flags & WITSENSOR_REGISTER_BATTERY) {
+        out->v[out->argc++] = (float)witsensor_battery_percent((unsigned int)(w[0] | (w[1] << 8)));
+    }
+    out->index = (unsigned char)row;
+}
+
+int witsensor_register_decode(const unsigned char *frame, witsensor_register_t *out, int max) {
+    if (!frame || !out || max < 1) return 0;
+    const unsigned char *w = frame + 4;
+    int n = 0;
+    int word = 0;
+    while (n < max && word < WITSENSOR_REGISTER_MAX_WORDS) {
+        int row = witsensor_register_rows[(frame[2] + word) & 0xFF];
+        if (row < 0 || word + witsensor_registers[row].words > WITSENSOR_REGISTER_MAX_WORDS) break;
+        out[n].start = frame[2];
+        out[n].rx_ns = 0;
+        witsensor_register_decode_row(row, w + 2 * word, &out[n++]);
+        word += witsensor_registers[row].words;
+    }
+    if (n == 0 && witsensor_register_raw_row >= 0) {
+        // Unknown start register: the start and all eight words, unsigned
+        witsensor_register_t *raw = &out[n++];
+        raw->index = (unsigned char)witsensor_register_raw_row;
+        raw->start = frame[2];
+        raw->rx_ns = 0;
+        raw->v[0] = (float)frame[2];
+        for (int i = 0; i < WITSENSOR_REGISTER_MAX_WORDS; i++) raw->v[1 + i] = (float)(w[2 * i] | (w[2 * i + 1] << 8));
+        raw->argc = WITSENSOR_REGISTER_MAX_VALUES;
+    }
+    return n;
+}
@@ -0,0 +1,94 @@
+/* witsensor_parser.h
+ * Reassembly of WIT frames from BLE notifications
+ * A notification may carry several frames or end in the middle of one
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_PARSER_H
+#define WITSENSOR_PARSER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_FRAME_SIZE 20
+#define WITSENSOR_FRAME_HEADER 0x55
+#define WITSENSOR_FRAME_STREAM 0x61    // accel/gyro/angle (or output_mode variants)
+#define WITSENSOR_FRAME_REGISTER 0x71  // register read response
+
+// Called once per complete frame (WITSENSOR_FRAME_SIZE bytes)
+typedef void (*witsensor_frame_callback_t)(void *user_data, const unsigned char *frame);
+
+typedef struct witsensor_parser_t {
+    unsigned char partial[WITSENSOR_FRAME_SIZE]; // frame carried over from the previous notification
+    int partial_count;
+    uint64_t frames;   // complete frames delivered
+    uint64_t resyncs;  // runs of bytes skipped to find the next header
+    uint64_t skipped;  // bytes discarded while resynchronising
+} witsensor_parser_t;
+
+void witsensor_parser_init(witsensor_parser_t *parser);
+// Drop any partial frame (e.g. after reconnect); counters are kept
+void witsensor_parser_reset(witsensor_parser_t *parser);
+// Feed one notification; returns the number of frames delivered
+int witsensor_parser_feed(witsensor_parser_t *parser, const unsigned char *data, int length,
+                          witsensor_frame_callback_t callback, void *user_data);
+
+// Register read responses (0x71): register, 0x00, then up to 8 little-endian words
+#define WITSENSOR_REGISTER_MAX_WORDS 8
+#define WITSENSOR_REGISTER_MAX_VALUES (WITSENSOR_REGISTER_MAX_WORDS + 1)
+#define WITSENSOR_REGISTER_ROWS_MAX 64  // upper bound on witsensor_register_count
+
+// Descriptor flags
+#define WITSENSOR_REGISTER_SIGNED  0x01 // words are int16
+#define WITSENSOR_REGISTER_BATTERY 0x02 // append charge percentage from the voltage
+#define WITSENSOR_REGISTER_QUAT    0x04 // values are the quaternion w x y z
+#define WITSENSOR_REGISTER_MAG     0x08 // values are the magnetometer x y z (fed to host fusion)
+#define WITSENSOR_REGISTER_DATETIME 0x10 // words yymm ddhh mmss ms (low byte first): yy mm dd hh mm ss ms
+#define WITSENSOR_REGISTER_RAW     0x20 // fallback for responses without a row: start register and 8 words
+
+typedef enum {
+    WITSENSOR_OUTLET_DATA = 0,
+    WITSENSOR_OUTLET_STATUS = 1
+} witsensor_outlet_t;
+
+typedef struct witsensor_register_desc_t {
+    unsigned char addr;    // first register of the response
+    unsigned char words;   // words decoded from the response
+    unsigned char flags;   // WITSENSOR_REGISTER_*
+    unsigned char outlet;  // witsensor_outlet_t
+    float scale;           // value = word * scale
+    const char *name;      // output selector
+} witsensor_register_desc_t;
+
+// One decoded register response
+typedef struct witsensor_register_t {
+    unsigned char index;   // row in witsensor_registers
+    unsigned char argc;    // values used
+    unsigned char start;   // register the response starts at (the one read)
+    float v[WITSENSOR_REGISTER_MAX_VALUES];
+    uint64_t rx_ns;        // host receive time, set by the caller
+} witsensor_register_t;
+
+extern const witsensor_register_desc_t witsensor_registers[];
+extern const int witsensor_register_count;
+
+// Build the address lookup; call once before decoding (not thread-safe)
+void witsensor_register_init(void);
+// Row for a register address or -1
+int witsensor_register_lookup(unsigned char addr);
+// Decode a 0x71 frame into out[0..max-1]: the row at the start register and
+// every row that follows it without a gap within the 8 words (one read of
+// 0x2E gives version and time). Responses without a row give one RAW entry.
+// Returns the number of entries; at most WITSENSOR_REGISTER_MAX_WORDS.
+int witsensor_register_decode(const unsigned char *frame, witsensor_register_t *out, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_PARSER_H
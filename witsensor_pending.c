@@ -0,0 +1,138 @@
+/* witsensor_pending.c
+ * Outstanding 0x27 register reads
+ *
+ * Every 0x27 read that goes out is entered with its send time, keyed by the
+ * register it starts at, which is also the start register of the 0x71 frame
+ * that answers it. A matching answer removes the entry and yields the round
+ * trip; an answer without an entry is late (after a timeout) or was not
+ * asked for. A read unanswered for the timeout is resent up to the retry
+ * count and then reported as timed out, so every read ends within
+ * (retries + 1) * timeout. The table is small and scanned linearly.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_pending.h"
+#include <string.h>
+
+void witsensor_pending_init(witsensor_pending_t *pending) {
+    if (!pending) return;
+    memset(pending, 0, sizeof(*pending));
+    pending->timeout_ms = WITSENSOR_PENDING_TIMEOUT_MS;
+    pending->retries = WITSENSOR_PENDING_RETRIES;
+}
+
+void witsensor_pending_clear(witsensor_pending_t *pending) {
+    if (!pending) return;
+    pending->count = 0;
+}
+
+void witsensor_pending_set_timeout(witsensor_pending_t *pending, double timeout_ms, int retries) {
+    if (!pending) return;
+    pending->timeout_ms = timeout_ms > 0 ? timeout_ms : WITSENSOR_PENDING_TIMEOUT_MS;
+    if (retries < 0) retries = 0;
+    if (retries > WITSENSOR_PENDING_MAX_RETRIES) retries = WITSENSOR_PENDING_MAX_RETRIES;
+    pending->retries = retries;
+}
+
+void witsensor_pending_reset_stats(witsensor_pending_t *pending) {
+    if (!pending) return;
+    pending->issued = pending->answered = pending->retried = pending->timeouts = pending->late = 0;
+    pending->rtt_last_ms = pending->rtt_sum_ms = pending->rtt_max_ms = 0;
+}
+
+static int witsensor_pending_find(const witsensor_pending_t *pending, unsigned char reg) {
+    for (int i = 0; i < pending->count; i++) {
+        if (pending->entries[i].reg == reg) return i;
+    }
+    return -1;
+}
+
+static void witsensor_pending_remove(witsensor_pending_t *pending, int i) {
+    pending->entries[i] = pending->entries[--pending->count];
+}
+
+int witsensor_pending_issue(witsensor_pending_t *pending, unsigned char reg, unsigned char span,
+                            double now_ms, int *tries) {
+    if (!pending) return -1;
+    int evicted = -1;
+    int i = witsensor_pending_find(pending, reg);
+    if (i < 0) {
+        // Resends find their entry; only first sends count as issued
+        pending->issued++;
+        if (pending->count == WITSENSOR_PENDING_SLOTS) {
+            int oldest = 0;
+            for (int j = 1; j < pending->count; j++) {
+                if (pending->entries[j].issued_ms < pending->entries[oldest].issued_ms) oldest = j;
+            }
+            evicted = pending->entries[oldest].reg;
+            if (tries) *tries = pending->entries[oldest].tries;
+            witsensor_pending_remove(pending, oldest);
+            pending->timeouts++;
+        }
+        i = pending->count++;
+        pending->entries[i].reg = reg;
+        pending->entries[i].span = 0;
+        pending->entries[i].tries = 0;
+    }
+    // A resend or a second request still answers the widest read
+    if (span > pending->entries[i].span) pending->entries[i].span = span;
+    pending->entries[i].issued_ms = now_ms;
+    return evicted;
+}
+
+int witsensor_pending_match(witsensor_pending_t *pending, unsigned char reg, double rx_ms,
+                            double *rtt_ms, unsigned char *span) {
+    if (span) *span = 0;
+    if (!pending) return 0;
+    int i = witsensor_pending_find(pending, reg);
+    if (i < 0) {
+        pending->late++;
+        return 0;
+    }
+    // Send and receive are stamped on different threads; never negative
+    double rtt = rx_ms - pending->entries[i].issued_ms;
+    if (rtt < 0) rtt = 0;
+    if (span) *span = pending->entries[i].span;
+    witsensor_pending_remove(pending, i);
+    pending->answered++;
+    pending->rtt_last_ms = rtt;
+    pending->rtt_sum_ms += rtt;
+    if (rtt > pending->rtt_max_ms) pending->rtt_max_ms = rtt;
+    if (rtt_ms) *rtt_ms = rtt;
+    return 1;
+}
+
+witsensor_pending_event_t witsensor_pending_expire(witsensor_pending_t *pending, double now_ms,
+                                                   unsigned char *reg, int *tries) {
+    if (!pending) return WITSENSOR_PENDING_NONE;
+    for (int i = 0; i < pending->count; i++) {
+        witsensor_pending_entry_t *e = &pending->entries[i];
+        if (now_ms - e->issued_ms < pending->timeout_ms) continue;
+        if (reg) *reg = e->reg;
+        if (e->tries < pending->retries) {
+            // Re-armed here, so a resend that cannot go out still ends in a timeout
+            e->tries++;
+            e->issued_ms = now_ms;
+            pending->retried++;
+            if (tries) *tries = e->tries;
+            return WITSENSOR_PENDING_RETRY;
+        }
+        if (tries) *tries = e->tries;
+        witsensor_pending_remove(pending, i);
+        pending->timeouts++;
+        return WITSENSOR_PENDING_TIMEOUT;
+    }
+    return WITSENSOR_PENDING_NONE;
+}
+
+double witsensor_pending_wait(const witsensor_pending_t *pending, double now_ms) {
+    if (!pending || pending->count == 0) return -1;
+    double at = pending->entries[0].issued_ms;
+    for (int i = 1; i < pending->count; i++) {
+        if (pending->entries[i].issued_ms < at) at = pending->entries[i].issued_ms;
+    }
+    at += pending->timeout_ms;
+    return at > now_ms ? at - now_ms : 0;
+}
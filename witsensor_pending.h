@@ -0,0 +1,82 @@
+/* witsensor_pending.h
+ * Outstanding 0x27 register reads: issue times, timeouts, retries and
+ * round-trip times, keyed by the register a read starts at
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_PENDING_H
+#define WITSENSOR_PENDING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_PENDING_SLOTS 16
+#define WITSENSOR_PENDING_TIMEOUT_MS 500.0  // default wait for a 0x71 answer
+#define WITSENSOR_PENDING_RETRIES 1         // default resends before a read times out
+#define WITSENSOR_PENDING_MAX_RETRIES 8
+
+// What witsensor_pending_expire found
+typedef enum {
+    WITSENSOR_PENDING_NONE = 0,
+    WITSENSOR_PENDING_RETRY = 1,    // send the read again
+    WITSENSOR_PENDING_TIMEOUT = 2   // given up, entry removed
+} witsensor_pending_event_t;
+
+typedef struct witsensor_pending_entry_t {
+    unsigned char reg;
+    unsigned char span;      // registers asked for from reg on (0: its first row only)
+    int tries;               // resends so far
+    double issued_ms;        // last send
+} witsensor_pending_entry_t;
+
+typedef struct witsensor_pending_t {
+    witsensor_pending_entry_t entries[WITSENSOR_PENDING_SLOTS];
+    int count;
+    double timeout_ms;
+    int retries;
+    // Since the last witsensor_pending_reset_stats
+    uint64_t issued;
+    uint64_t answered;
+    uint64_t retried;
+    uint64_t timeouts;
+    uint64_t late;           // answers without an outstanding read (late or unsolicited)
+    double rtt_last_ms;
+    double rtt_sum_ms;
+    double rtt_max_ms;
+} witsensor_pending_t;
+
+// Empty table with the default timeout and retries
+void witsensor_pending_init(witsensor_pending_t *pending);
+// Forget outstanding reads (new connection); settings and stats are kept
+void witsensor_pending_clear(witsensor_pending_t *pending);
+void witsensor_pending_set_timeout(witsensor_pending_t *pending, double timeout_ms, int retries);
+void witsensor_pending_reset_stats(witsensor_pending_t *pending);
+// A read of reg asking for span registers went out at now_ms. A read of
+// reg already outstanding is restarted with the larger span (one entry per
+// register, counted as issued once); with the table full the oldest read is
+// dropped and counted as timed out. Returns the dropped read's register and
+// its resends in *tries, or -1.
+int witsensor_pending_issue(witsensor_pending_t *pending, unsigned char reg, unsigned char span,
+                            double now_ms, int *tries);
+// A 0x71 response starting at reg arrived at rx_ms. Returns 1, the round
+// trip in ms and the span of the read if one was outstanding, 0 (counted as
+// late, span 0) otherwise.
+int witsensor_pending_match(witsensor_pending_t *pending, unsigned char reg, double rx_ms,
+                            double *rtt_ms, unsigned char *span);
+// One overdue read at now_ms, or NONE. RETRY re-arms it (resend reg),
+// TIMEOUT removes it; call until NONE.
+witsensor_pending_event_t witsensor_pending_expire(witsensor_pending_t *pending, double now_ms,
+                                                   unsigned char *reg, int *tries);
+// ms until the next read is overdue (0: now), -1 if none is outstanding
+double witsensor_pending_wait(const witsensor_pending_t *pending, double now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_PENDING_H
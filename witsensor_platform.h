@@ -0,0 +1,130 @@
+/* witsensor_platform.h
+ * Small platform helpers shared by the Pd-free modules
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_PLATFORM_H
+#define WITSENSOR_PLATFORM_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+    #include <sched.h>
+    #include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Monotonic host time in nanoseconds (arbitrary origin, callable from any thread)
+static inline uint64_t witsensor_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000ull
+         + (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000ull / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+// Sleep the calling thread
+static inline void witsensor_sleep_ms(unsigned int ms) {
+#ifdef _WIN32
+    Sleep(ms);
+#else
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// Give up the rest of the time slice (spin-wait loops)
+static inline void witsensor_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+// Non-recursive mutex; WITSENSOR_MUTEX_INIT initializes static instances
+#ifdef _WIN32
+typedef SRWLOCK witsensor_mutex_t;
+#define WITSENSOR_MUTEX_INIT SRWLOCK_INIT
+static inline void witsensor_mutex_lock(witsensor_mutex_t *m) { AcquireSRWLockExclusive(m); }
+static inline void witsensor_mutex_unlock(witsensor_mutex_t *m) { ReleaseSRWLockExclusive(m); }
+#else
+typedef pthread_mutex_t witsensor_mutex_t;
+#define WITSENSOR_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+static inline void witsensor_mutex_lock(witsensor_mutex_t *m) { pthread_mutex_lock(m); }
+static inline void witsensor_mutex_unlock(witsensor_mutex_t *m) { pthread_mutex_unlock(m); }
+#endif
+
+// Condition variable paired with witsensor_mutex_t; WITSENSOR_COND_INIT for static instances
+#ifdef _WIN32
+typedef CONDITION_VARIABLE witsensor_cond_t;
+#define WITSENSOR_COND_INIT CONDITION_VARIABLE_INIT
+static inline void witsensor_cond_wait(witsensor_cond_t *c, witsensor_mutex_t *m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static inline void witsensor_cond_broadcast(witsensor_cond_t *c) { WakeAllConditionVariable(c); }
+#else
+typedef pthread_cond_t witsensor_cond_t;
+#define WITSENSOR_COND_INIT PTHREAD_COND_INITIALIZER
+static inline void witsensor_cond_wait(witsensor_cond_t *c, witsensor_mutex_t *m) { pthread_cond_wait(c, m); }
+static inline void witsensor_cond_broadcast(witsensor_cond_t *c) { pthread_cond_broadcast(c); }
+#endif
+
+// Joinable thread running fn(arg); start returns 1 on success
+typedef struct witsensor_thread_start_t { void (*fn)(void *); void *arg; } witsensor_thread_start_t;
+#ifdef _WIN32
+typedef HANDLE witsensor_thread_t;
+static inline DWORD WINAPI witsensor_thread_main(LPVOID p) {
+#else
+typedef pthread_t witsensor_thread_t;
+static inline void *witsensor_thread_main(void *p) {
+#endif
+    witsensor_thread_start_t s = *(witsensor_thread_start_t *)p;
+    free(p);
+    s.fn(s.arg);
+    return 0;
+}
+static inline int witsensor_thread_start(witsensor_thread_t *t, void (*fn)(void *), void *arg) {
+    witsensor_thread_start_t *s = (witsensor_thread_start_t *)malloc(sizeof(*s));
+    if (!s) return 0;
+    s->fn = fn;
+    s->arg = arg;
+#ifdef _WIN32
+    *t = CreateThread(NULL, 0, witsensor_thread_main, s, 0, NULL);
+    int ok = *t != NULL;
+#else
+    int ok = pthread_create(t, NULL, witsensor_thread_main, s) == 0;
+#endif
+    if (!ok) free(s);
+    return ok;
+}
+static inline void witsensor_thread_join(witsensor_thread_t t) {
+#ifdef _WIN32
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_PLATFORM_H
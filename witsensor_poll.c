@@ -0,0 +1,145 @@
+/* witsensor_poll.c
+ * Register polling scheduler
+ *
+ * Every group has a period and a due time. The caller asks for the next read
+ * whenever the link has room, typically right after a streaming notification
+ * has been handled, so reads fall between the sensor's data. The most overdue
+ * group goes first (earliest deadline), so groups interleave and an
+ * oversubscribed budget slows every group evenly instead of starving one. A
+ * group has at most one read in flight; its answer is matched by the register
+ * the 0x71 response starts at. Timeouts are up to the caller (the pending
+ * read table), which reports a read that was never answered as missed.
+ * A group waiting for an answer is not scheduled.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_poll.h"
+#include <string.h>
+
+void witsensor_poll_init(witsensor_poll_t *poll) {
+    if (!poll) return;
+    memset(poll, 0, sizeof(*poll));
+    poll->budget = WITSENSOR_POLL_BUDGET;
+    poll->tokens = WITSENSOR_POLL_BURST;
+}
+
+void witsensor_poll_clear(witsensor_poll_t *poll) {
+    if (!poll) return;
+    poll->count = 0;
+}
+
+void witsensor_poll_set_budget(witsensor_poll_t *poll, double reads_per_s) {
+    if (!poll || reads_per_s <= 0) return;
+    poll->budget = reads_per_s;
+}
+
+void witsensor_poll_copy(witsensor_poll_t *dst, const witsensor_poll_t *src, double now_ms) {
+    if (!dst || !src) return;
+    witsensor_poll_init(dst);
+    dst->budget = src->budget;
+    dst->count = src->count;
+    for (int i = 0; i < src->count; i++) {
+        dst->groups[i].reg = src->groups[i].reg;
+        dst->groups[i].period_ms = src->groups[i].period_ms;
+        dst->groups[i].due_ms = now_ms;
+    }
+}
+
+int witsensor_poll_find(const witsensor_poll_t *poll, unsigned char reg) {
+    for (int i = 0; i < poll->count; i++) {
+        if (poll->groups[i].reg == reg) return i;
+    }
+    return -1;
+}
+
+int witsensor_poll_set(witsensor_poll_t *poll, unsigned char reg, double rate_hz, double now_ms) {
+    if (!poll) return 0;
+    int i = witsensor_poll_find(poll, reg);
+    if (rate_hz <= 0) {
+        if (i >= 0) {
+            poll->groups[i] = poll->groups[poll->count - 1];
+            poll->count--;
+        }
+        return 1;
+    }
+    if (rate_hz > WITSENSOR_POLL_MAX_HZ) rate_hz = WITSENSOR_POLL_MAX_HZ;
+    if (i < 0) {
+        if (poll->count == WITSENSOR_POLL_GROUPS) return 0;
+        i = poll->count++;
+        memset(&poll->groups[i], 0, sizeof(poll->groups[i]));
+        poll->groups[i].reg = reg;
+        poll->groups[i].due_ms = now_ms;
+    }
+    poll->groups[i].period_ms = 1000.0 / rate_hz;
+    return 1;
+}
+
+static void witsensor_poll_refill(witsensor_poll_t *poll, double now_ms) {
+    if (now_ms > poll->tokens_ms) {
+        poll->tokens += (now_ms - poll->tokens_ms) * poll->budget / 1000.0;
+        if (poll->tokens > WITSENSOR_POLL_BURST) poll->tokens = WITSENSOR_POLL_BURST;
+    }
+    poll->tokens_ms = now_ms;
+}
+
+int witsensor_poll_next(witsensor_poll_t *poll, double now_ms) {
+    if (!poll || poll->count == 0) return -1;
+    witsensor_poll_refill(poll, now_ms);
+    if (poll->tokens < 1.0) return -1;
+    witsensor_poll_group_t *best = NULL;
+    for (int i = 0; i < poll->count; i++) {
+        witsensor_poll_group_t *g = &poll->groups[i];
+        if (g->sent_ms > 0 || g->due_ms > now_ms) continue;
+        if (!best || g->due_ms < best->due_ms) best = g;
+    }
+    if (!best) return -1;
+    poll->tokens -= 1.0;
+    best->sent_ms = now_ms > 0 ? now_ms : 1e-3;
+    best->sent++;
+    // Next slot one period on; slots already missed are skipped, not bunched
+    best->due_ms += best->period_ms;
+    if (best->due_ms < now_ms) best->due_ms = now_ms;
+    return best->reg;
+}
+
+int witsensor_poll_match(witsensor_poll_t *poll, unsigned char reg) {
+    if (!poll) return -1;
+    int i = witsensor_poll_find(poll, reg);
+    if (i < 0) return -1;
+    witsensor_poll_group_t *g = &poll->groups[i];
+    if (g->sent_ms <= 0) return -1;
+    g->sent_ms = 0;
+    g->answered++;
+    return i;
+}
+
+int witsensor_poll_missed(witsensor_poll_t *poll, unsigned char reg) {
+    if (!poll) return -1;
+    int i = witsensor_poll_find(poll, reg);
+    if (i < 0) return -1;
+    witsensor_poll_group_t *g = &poll->groups[i];
+    if (g->sent_ms <= 0) return -1;
+    g->sent_ms = 0;
+    g->missed++;
+    return i;
+}
+
+double witsensor_poll_wait(witsensor_poll_t *poll, double now_ms) {
+    if (!poll || poll->count == 0) return -1;
+    double at = -1;
+    for (int i = 0; i < poll->count; i++) {
+        witsensor_poll_group_t *g = &poll->groups[i];
+        // A group with a read in flight waits for its answer or timeout
+        if (g->sent_ms > 0) continue;
+        if (at < 0 || g->due_ms < at) at = g->due_ms;
+    }
+    if (at < 0) return -1;
+    witsensor_poll_refill(poll, now_ms);
+    if (poll->tokens < 1.0) {
+        double refill = now_ms + (1.0 - poll->tokens) * 1000.0 / poll->budget;
+        if (refill > at) at = refill;
+    }
+    return at > now_ms ? at - now_ms : 0;
+}
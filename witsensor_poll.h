@@ -0,0 +1,68 @@
+/* witsensor_poll.h
+ * Register polling scheduler: several register groups, each at its own rate,
+ * interleaved within a per-device budget of 0x27 reads per second
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_POLL_H
+#define WITSENSOR_POLL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_POLL_GROUPS 8
+#define WITSENSOR_POLL_MAX_HZ 50.0      // per group
+#define WITSENSOR_POLL_BUDGET 20.0      // default reads per second per device
+#define WITSENSOR_POLL_BURST 2.0        // reads the budget lets go out back to back
+
+typedef struct witsensor_poll_group_t {
+    unsigned char reg;       // register read with 0x27, answered by a 0x71 starting there
+    double period_ms;
+    double due_ms;           // next read is due at this time
+    double sent_ms;          // time of the outstanding read, 0: none
+    uint64_t sent;
+    uint64_t answered;
+    uint64_t missed;         // reads that timed out without an answer
+} witsensor_poll_group_t;
+
+typedef struct witsensor_poll_t {
+    witsensor_poll_group_t groups[WITSENSOR_POLL_GROUPS];
+    int count;
+    double budget;           // reads per second
+    double tokens;           // token bucket for the budget
+    double tokens_ms;        // time of the last refill
+} witsensor_poll_t;
+
+void witsensor_poll_init(witsensor_poll_t *poll);
+// Add or change (rate_hz > 0, capped at WITSENSOR_POLL_MAX_HZ) or remove
+// (rate_hz <= 0) the group reading reg; returns 0 if all groups are taken
+int witsensor_poll_set(witsensor_poll_t *poll, unsigned char reg, double rate_hz, double now_ms);
+void witsensor_poll_clear(witsensor_poll_t *poll);
+void witsensor_poll_set_budget(witsensor_poll_t *poll, double reads_per_s);
+// Groups and budget of src with a fresh schedule starting at now_ms
+void witsensor_poll_copy(witsensor_poll_t *dst, const witsensor_poll_t *src, double now_ms);
+// Group of reg or -1
+int witsensor_poll_find(const witsensor_poll_t *poll, unsigned char reg);
+// Register to read now, or -1: the most overdue group without a read in
+// flight, if the budget allows. The read counts as sent.
+int witsensor_poll_next(witsensor_poll_t *poll, double now_ms);
+// Match a 0x71 response starting at reg to its outstanding read; returns the
+// group, or -1 if none of the groups was waiting for it
+int witsensor_poll_match(witsensor_poll_t *poll, unsigned char reg);
+// The outstanding read of reg timed out or could not be sent; returns the
+// group, or -1
+int witsensor_poll_missed(witsensor_poll_t *poll, unsigned char reg);
+// ms until witsensor_poll_next can return a register (0: now), -1 without
+// groups or while every group waits for an answer
+double witsensor_poll_wait(witsensor_poll_t *poll, double now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_POLL_H
@@ -0,0 +1,315 @@
+/* witsensor_recorder.c
+ * Session recorder: raw BLE notifications with host timestamps to a binary log
+ *
+ * Each source has its own single-producer byte ring, so the BLE callback only
+ * copies a few dozen bytes and never blocks or allocates; a full ring drops the
+ * record and counts it. The writer thread polls the rings, appends records to
+ * the mapped file and refreshes the header, so a crashed session still reads
+ * back up to the last pass. The file is preallocated in large steps and
+ * trimmed to its used length on close.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_recorder.h"
+#include "witsensor_platform.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/time.h>
+    #include <unistd.h>
+#endif
+
+#define RING_MASK (WITSENSOR_RECORD_RING_BYTES - 1)
+#define IDLE_MS 5 // writer pause when every ring is empty
+
+_Static_assert((WITSENSOR_RECORD_RING_BYTES & RING_MASK) == 0, "ring size must be a power of two");
+_Static_assert(sizeof(witsensor_record_t) == 16, "record header layout");
+_Static_assert(sizeof(witsensor_record_header_t) <= WITSENSOR_RECORD_HEADER_SIZE, "file header too large");
+
+typedef struct witsensor_record_ring_t {
+    _Atomic uint32_t head;    // bytes produced
+    _Atomic uint32_t tail;    // bytes consumed by the writer
+    unsigned char bytes[WITSENSOR_RECORD_RING_BYTES];
+} witsensor_record_ring_t;
+
+struct witsensor_recorder_t {
+    witsensor_record_ring_t rings[WITSENSOR_RECORD_SOURCES];
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t records;
+    _Atomic uint64_t used;    // record bytes in the file
+    _Atomic int stop;
+    witsensor_thread_t thread;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    unsigned char *map;       // writer thread only once started
+    uint64_t map_size;
+    witsensor_mutex_t lock;   // guards header
+    witsensor_record_header_t header;
+};
+
+static int64_t witsensor_recorder_unix_ms(void) {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t t = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (int64_t)(t / 10000) - 11644473600000LL;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+#endif
+}
+
+static void witsensor_recorder_unmap(witsensor_recorder_t *rec) {
+    if (!rec->map) return;
+#ifdef _WIN32
+    UnmapViewOfFile(rec->map);
+    CloseHandle(rec->mapping);
+    rec->mapping = NULL;
+#else
+    munmap(rec->map, (size_t)rec->map_size);
+#endif
+    rec->map = NULL;
+}
+
+// Size the file to 'size' bytes and map all of it
+static int witsensor_recorder_map(witsensor_recorder_t *rec, uint64_t size) {
+    witsensor_recorder_unmap(rec);
+#ifdef _WIN32
+    rec->mapping = CreateFileMappingA(rec->file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+    if (!rec->mapping) return 0;
+    rec->map = (unsigned char *)MapViewOfFile(rec->mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)size);
+    if (!rec->map) {
+        CloseHandle(rec->mapping);
+        rec->mapping = NULL;
+        return 0;
+    }
+#else
+#if defined(__linux__)
+    // Reserve the blocks now so a full disk fails here, not as SIGBUS later
+    if (posix_fallocate(rec->fd, 0, (off_t)size) != 0) return 0;
+#else
+    if (ftruncate(rec->fd, (off_t)size) != 0) return 0;
+#endif
+    void *map = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, rec->fd, 0);
+    if (map == MAP_FAILED) return 0;
+    rec->map = (unsigned char *)map;
+#endif
+    rec->map_size = size;
+    return 1;
+}
+
+// Copy out of a ring across its wrap point
+static void witsensor_recorder_ring_read(const witsensor_record_ring_t *ring, uint32_t pos, void *dst, size_t n) {
+    size_t at = pos & RING_MASK;
+    size_t first = WITSENSOR_RECORD_RING_BYTES - at;
+    if (first > n) first = n;
+    memcpy(dst, ring->bytes + at, first);
+    memcpy((unsigned char *)dst + first, ring->bytes, n - first);
+}
+
+static void witsensor_recorder_ring_write(witsensor_record_ring_t *ring, uint32_t pos, const void *src, size_t n) {
+    size_t at = pos & RING_MASK;
+    size_t first = WITSENSOR_RECORD_RING_BYTES - at;
+    if (first > n) first = n;
+    memcpy(ring->bytes + at, src, first);
+    memcpy(ring->bytes, (const unsigned char *)src + first, n - first);
+}
+
+// Move queued records into the file; returns the number moved (writer thread)
+static unsigned int witsensor_recorder_drain(witsensor_recorder_t *rec) {
+    unsigned int moved = 0;
+    uint64_t used = atomic_load_explicit(&rec->used, memory_order_relaxed);
+    for (int s = 0; s < WITSENSOR_RECORD_SOURCES; s++) {
+        witsensor_record_ring_t *ring = &rec->rings[s];
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        while (head - tail >= sizeof(witsensor_record_t)) {
+            witsensor_record_t r;
+            witsensor_recorder_ring_read(ring, tail, &r, sizeof(r));
+            size_t size = sizeof(r) + WITSENSOR_RECORD_PADDED(r.length);
+            uint64_t end = WITSENSOR_RECORD_HEADER_SIZE + used + size;
+            int room = rec->map != NULL;
+            if (room && end > rec->map_size) {
+                room = witsensor_recorder_map(rec, rec->map_size + WITSENSOR_RECORD_GROW_BYTES);
+                // The failed grow unmapped the file; map it back at the old size
+                if (!room) witsensor_recorder_map(rec, rec->map_size);
+            }
+            if (!room) {
+                // Disk full, or no mapping left at all: keep draining so
+                // producers are not stuck, count the loss
+                atomic_fetch_add_explicit(&rec->dropped, 1, memory_order_relaxed);
+            } else {
+                witsensor_recorder_ring_read(ring, tail, rec->map + WITSENSOR_RECORD_HEADER_SIZE + used, size);
+                used += size;
+                moved++;
+            }
+            tail += (uint32_t)size;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    if (moved) {
+        atomic_store_explicit(&rec->used, used, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rec->records, moved, memory_order_relaxed);
+    }
+    if (rec->map) {
+        witsensor_mutex_lock(&rec->lock);
+        rec->header.data_bytes = used;
+        memcpy(rec->map, &rec->header, sizeof(rec->header));
+        witsensor_mutex_unlock(&rec->lock);
+    }
+    return moved;
+}
+
+static void witsensor_recorder_main(void *arg) {
+    witsensor_recorder_t *rec = (witsensor_recorder_t *)arg;
+    while (!atomic_load(&rec->stop)) {
+        if (!witsensor_recorder_drain(rec)) witsensor_sleep_ms(IDLE_MS);
+    }
+    witsensor_recorder_drain(rec);
+}
+
+static void witsensor_recorder_close_file(witsensor_recorder_t *rec) {
+    uint64_t size = WITSENSOR_RECORD_HEADER_SIZE + atomic_load(&rec->used);
+    witsensor_recorder_unmap(rec);
+#ifdef _WIN32
+    if (rec->file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER at;
+        at.QuadPart = (LONGLONG)size;
+        if (SetFilePointerEx(rec->file, at, NULL, FILE_BEGIN)) SetEndOfFile(rec->file);
+        CloseHandle(rec->file);
+        rec->file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (rec->fd >= 0) {
+        if (ftruncate(rec->fd, (off_t)size) != 0) { /* keep the padded file */ }
+        close(rec->fd);
+        rec->fd = -1;
+    }
+#endif
+}
+
+witsensor_recorder_t *witsensor_recorder_open(const char *path, float rate_hz, int output_mode,
+                                              char *err, size_t errsize) {
+    if (!path || !path[0]) {
+        snprintf(err, errsize, "no file name");
+        return NULL;
+    }
+    witsensor_recorder_t *rec = (witsensor_recorder_t *)calloc(1, sizeof(*rec));
+    if (!rec) {
+        snprintf(err, errsize, "out of memory");
+        return NULL;
+    }
+    witsensor_mutex_t init = WITSENSOR_MUTEX_INIT;
+    rec->lock = init;
+#ifdef _WIN32
+    rec->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if (rec->file == INVALID_HANDLE_VALUE) {
+        snprintf(err, errsize, "cannot create %s", path);
+        free(rec);
+        return NULL;
+    }
+#else
+    rec->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (rec->fd < 0) {
+        snprintf(err, errsize, "cannot create %s: %s", path, strerror(errno));
+        free(rec);
+        return NULL;
+    }
+#endif
+    if (!witsensor_recorder_map(rec, WITSENSOR_RECORD_HEADER_SIZE + WITSENSOR_RECORD_GROW_BYTES)) {
+        snprintf(err, errsize, "cannot preallocate %s", path);
+        witsensor_recorder_close_file(rec);
+        free(rec);
+        return NULL;
+    }
+    memcpy(rec->header.magic, WITSENSOR_RECORD_MAGIC, sizeof(WITSENSOR_RECORD_MAGIC));
+    rec->header.version = WITSENSOR_RECORD_VERSION;
+    rec->header.header_size = WITSENSOR_RECORD_HEADER_SIZE;
+    rec->header.start_ns = witsensor_now_ns();
+    rec->header.start_unix_ms = witsensor_recorder_unix_ms();
+    rec->header.rate_hz = rate_hz;
+    rec->header.output_mode = output_mode;
+    rec->header.sources = WITSENSOR_RECORD_SOURCES;
+    memcpy(rec->map, &rec->header, sizeof(rec->header));
+    if (!witsensor_thread_start(&rec->thread, witsensor_recorder_main, rec)) {
+        snprintf(err, errsize, "cannot start the writer thread");
+        witsensor_recorder_close_file(rec);
+        free(rec);
+        return NULL;
+    }
+    return rec;
+}
+
+void witsensor_recorder_set_sensor(witsensor_recorder_t *rec, int source, const char *name) {
+    if (!rec || source < 0 || source >= WITSENSOR_RECORD_SOURCES) return;
+    witsensor_mutex_lock(&rec->lock);
+    snprintf(rec->header.sensor[source], sizeof(rec->header.sensor[source]), "%s", name ? name : "");
+    witsensor_mutex_unlock(&rec->lock);
+}
+
+void witsensor_recorder_set_config(witsensor_recorder_t *rec, float rate_hz, int output_mode) {
+    if (!rec) return;
+    witsensor_mutex_lock(&rec->lock);
+    rec->header.rate_hz = rate_hz;
+    rec->header.output_mode = output_mode;
+    witsensor_mutex_unlock(&rec->lock);
+}
+
+int witsensor_recorder_write(witsensor_recorder_t *rec, int source, uint64_t t_ns,
+                             const unsigned char *data, int length) {
+    if (!rec || source < 0 || source >= WITSENSOR_RECORD_SOURCES || !data || length <= 0) return 0;
+    witsensor_record_ring_t *ring = &rec->rings[source];
+    witsensor_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.t_ns = t_ns;
+    r.length = (uint16_t)(length > WITSENSOR_RECORD_MAX_BYTES ? WITSENSOR_RECORD_MAX_BYTES : length);
+    r.source = (uint8_t)source;
+    r.kind = WITSENSOR_RECORD_NOTIFY;
+    r.flags = length > WITSENSOR_RECORD_MAX_BYTES ? WITSENSOR_RECORD_CUT : 0;
+    size_t size = sizeof(r) + WITSENSOR_RECORD_PADDED(r.length);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (WITSENSOR_RECORD_RING_BYTES - (head - tail) < size) {
+        atomic_fetch_add_explicit(&rec->dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+    witsensor_recorder_ring_write(ring, head, &r, sizeof(r));
+    witsensor_recorder_ring_write(ring, head + (uint32_t)sizeof(r), data, r.length);
+    // Padding bytes stay whatever the ring held; length says where data ends
+    atomic_store_explicit(&ring->head, head + (uint32_t)size, memory_order_release);
+    return 1;
+}
+
+void witsensor_recorder_stats(witsensor_recorder_t *rec, witsensor_recorder_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!rec) return;
+    stats->records = atomic_load(&rec->records);
+    stats->bytes = atomic_load(&rec->used);
+    stats->dropped = atomic_load(&rec->dropped);
+}
+
+void witsensor_recorder_close(witsensor_recorder_t *rec, witsensor_recorder_stats_t *stats) {
+    if (!rec) return;
+    atomic_store(&rec->stop, 1);
+    witsensor_thread_join(rec->thread);
+    witsensor_recorder_stats(rec, stats);
+    witsensor_recorder_close_file(rec);
+    free(rec);
+}
@@ -0,0 +1,91 @@
+/* witsensor_recorder.h
+ * Session recorder: raw BLE notifications with host timestamps to a binary log
+ * Producers (BLE callbacks, one per source) copy into lock-free rings; a
+ * writer thread appends them to a preallocated, memory-mapped file
+ *
+ * File layout (little-endian): a witsensor_record_header_t padded to
+ * header_size bytes, then records. Each record is a witsensor_record_t
+ * followed by 'length' data bytes, padded to a multiple of 8. Records of one
+ * source are in order; sources interleave in blocks, sort by t_ns if needed.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_RECORDER_H
+#define WITSENSOR_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_RECORD_MAGIC "WITREC1"
+#define WITSENSOR_RECORD_VERSION 1
+#define WITSENSOR_RECORD_SOURCES 16         // devices per file
+#define WITSENSOR_RECORD_HEADER_SIZE 4096   // first record starts here
+#define WITSENSOR_RECORD_MAX_BYTES 512      // longer notifications are cut (WITSENSOR_RECORD_CUT)
+#define WITSENSOR_RECORD_RING_BYTES 65536   // per source, power of two (~2 s at 200 Hz and full MTU)
+#define WITSENSOR_RECORD_GROW_BYTES (64u << 20) // file grows in steps of this
+
+// Record kinds
+#define WITSENSOR_RECORD_NOTIFY 0           // data bytes of one notification
+
+// Record flags
+#define WITSENSOR_RECORD_CUT 0x01           // notification longer than WITSENSOR_RECORD_MAX_BYTES
+
+typedef struct witsensor_record_header_t {
+    char magic[8];            // WITSENSOR_RECORD_MAGIC
+    uint32_t version;
+    uint32_t header_size;     // offset of the first record
+    uint64_t start_ns;        // witsensor_now_ns when recording started
+    int64_t start_unix_ms;    // wall clock at the same moment
+    uint64_t data_bytes;      // record bytes after the header, kept current while writing
+    float rate_hz;            // configured stream rate
+    int32_t output_mode;      // AGPVSEL 0..3, -1: unknown
+    uint32_t sources;         // WITSENSOR_RECORD_SOURCES
+    uint32_t reserved;
+    char sensor[WITSENSOR_RECORD_SOURCES][64]; // connect target per source, may be empty
+} witsensor_record_header_t;
+
+typedef struct witsensor_record_t {
+    uint64_t t_ns;            // host receive time (witsensor_now_ns)
+    uint16_t length;          // data bytes that follow
+    uint8_t source;           // device slot
+    uint8_t kind;             // WITSENSOR_RECORD_*
+    uint8_t flags;
+    uint8_t reserved[3];
+} witsensor_record_t;
+
+#define WITSENSOR_RECORD_PADDED(length) (((size_t)(length) + 7) & ~(size_t)7)
+
+typedef struct witsensor_recorder_t witsensor_recorder_t;
+
+typedef struct witsensor_recorder_stats_t {
+    uint64_t records;         // records written to the file
+    uint64_t bytes;           // file bytes after the header
+    uint64_t dropped;         // records lost to full rings or a full disk
+} witsensor_recorder_stats_t;
+
+// Create the file and start the writer; NULL with a reason in err on failure
+witsensor_recorder_t *witsensor_recorder_open(const char *path, float rate_hz, int output_mode,
+                                              char *err, size_t errsize);
+// Update header fields (any thread but the producers)
+void witsensor_recorder_set_sensor(witsensor_recorder_t *rec, int source, const char *name);
+void witsensor_recorder_set_config(witsensor_recorder_t *rec, float rate_hz, int output_mode);
+// Producer side, one thread per source: copy a notification, never blocks;
+// returns 0 if it was dropped
+int witsensor_recorder_write(witsensor_recorder_t *rec, int source, uint64_t t_ns,
+                             const unsigned char *data, int length);
+void witsensor_recorder_stats(witsensor_recorder_t *rec, witsensor_recorder_stats_t *stats);
+// Stop the writer, write out what is queued, trim the file and free rec.
+// No producer may be inside witsensor_recorder_write.
+void witsensor_recorder_close(witsensor_recorder_t *rec, witsensor_recorder_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_RECORDER_H
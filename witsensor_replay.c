@@ -0,0 +1,243 @@
+/* witsensor_replay.c
+ * Session replay: feed a recorded log (witsensor_recorder.h) back as notifications
+ *
+ * The recorder writes each source in order but interleaves sources in blocks,
+ * so open reads the whole data section and sorts an index of the records by
+ * receive time (file order breaks ties). The replay thread then sleeps until
+ * each record's time relative to the first, divided by the speed; the last
+ * stretch before a record is spun so bursts keep their sub-ms spacing.
+ * At speed 0 records go out as fast as the consumer's ready callback allows.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_replay.h"
+#include "witsensor_platform.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPIN_NS 1000000ull  // spin instead of sleeping this close to a record
+#define STOP_CHECK_MS 50    // longest sleep between checks of the stop flag
+#define READY_WAIT_MS 1     // speed 0: sleep while the consumer is full
+
+typedef struct witsensor_replay_entry_t {
+    uint64_t t_ns;
+    size_t offset;            // record in data
+} witsensor_replay_entry_t;
+
+struct witsensor_replay_t {
+    witsensor_record_header_t header;
+    unsigned char *data;      // record bytes after the file header
+    witsensor_replay_entry_t *index;
+    size_t count;
+    int sources;
+    double speed;
+    witsensor_replay_data_t data_callback;
+    witsensor_replay_done_t done_callback;
+    witsensor_replay_ready_t ready_callback;
+    void *user_data;
+    witsensor_thread_t thread;
+    int running;              // thread started, not yet joined
+    _Atomic int stop;
+    _Atomic int finished;
+    _Atomic uint64_t records;
+    _Atomic uint64_t bytes;
+    _Atomic uint64_t start_ns;
+    _Atomic uint64_t end_ns;      // thread done feeding, 0: still running
+    _Atomic uint64_t position_ns; // session time of the last record fed
+};
+
+static int witsensor_replay_compare(const void *a, const void *b) {
+    const witsensor_replay_entry_t *ea = (const witsensor_replay_entry_t *)a;
+    const witsensor_replay_entry_t *eb = (const witsensor_replay_entry_t *)b;
+    if (ea->t_ns != eb->t_ns) return ea->t_ns < eb->t_ns ? -1 : 1;
+    return ea->offset < eb->offset ? -1 : ea->offset > eb->offset;
+}
+
+static void witsensor_replay_free(witsensor_replay_t *rp) {
+    free(rp->data);
+    free(rp->index);
+    free(rp);
+}
+
+witsensor_replay_t *witsensor_replay_open(const char *path, char *err, size_t errsize) {
+    if (err && errsize) err[0] = '\0';
+    witsensor_replay_t *rp = (witsensor_replay_t *)calloc(1, sizeof(*rp));
+    if (!rp) {
+        snprintf(err, errsize, "out of memory");
+        return NULL;
+    }
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        snprintf(err, errsize, "can't open %s", path);
+        free(rp);
+        return NULL;
+    }
+    witsensor_record_header_t *h = &rp->header;
+    if (fread(h, sizeof(*h), 1, file) != 1 || memcmp(h->magic, WITSENSOR_RECORD_MAGIC, sizeof(WITSENSOR_RECORD_MAGIC)) != 0) {
+        snprintf(err, errsize, "%s is not a witsensor recording", path);
+        goto fail;
+    }
+    if (h->version != WITSENSOR_RECORD_VERSION || h->header_size < sizeof(*h)) {
+        snprintf(err, errsize, "%s: unsupported recording version %u", path, (unsigned)h->version);
+        goto fail;
+    }
+    if (h->data_bytes > (uint64_t)(size_t)-1 || fseek(file, (long)h->header_size, SEEK_SET) != 0) {
+        snprintf(err, errsize, "%s: bad header", path);
+        goto fail;
+    }
+    size_t size = (size_t)h->data_bytes;
+    rp->data = (unsigned char *)malloc(size ? size : 1);
+    if (!rp->data) {
+        snprintf(err, errsize, "%s: out of memory", path);
+        goto fail;
+    }
+    // A session cut short keeps what its header covers; a truncated copy replays what is there
+    size = fread(rp->data, 1, size, file);
+    fclose(file);
+    file = NULL;
+
+    // Walk the records once to count, then again to index
+    for (int pass = 0; pass < 2; pass++) {
+        size_t n = 0;
+        for (size_t at = 0; at + sizeof(witsensor_record_t) <= size;) {
+            witsensor_record_t r;
+            memcpy(&r, rp->data + at, sizeof(r));
+            size_t next = at + sizeof(r) + WITSENSOR_RECORD_PADDED(r.length);
+            if (r.length == 0 || r.length > WITSENSOR_RECORD_MAX_BYTES || r.source >= WITSENSOR_RECORD_SOURCES || next > size) break;
+            if (r.kind == WITSENSOR_RECORD_NOTIFY) {
+                if (pass) {
+                    rp->index[n].t_ns = r.t_ns;
+                    rp->index[n].offset = at;
+                    if (r.source >= rp->sources) rp->sources = r.source + 1;
+                }
+                n++;
+            }
+            at = next;
+        }
+        if (!pass) {
+            rp->index = (witsensor_replay_entry_t *)malloc((n ? n : 1) * sizeof(*rp->index));
+            if (!rp->index) {
+                snprintf(err, errsize, "%s: out of memory", path);
+                goto fail;
+            }
+        }
+        rp->count = n;
+    }
+    if (!rp->count) {
+        snprintf(err, errsize, "%s holds no notifications", path);
+        goto fail;
+    }
+    qsort(rp->index, rp->count, sizeof(*rp->index), witsensor_replay_compare);
+    return rp;
+
+fail:
+    if (file) fclose(file);
+    witsensor_replay_free(rp);
+    return NULL;
+}
+
+const witsensor_record_header_t *witsensor_replay_header(const witsensor_replay_t *rp) {
+    return rp ? &rp->header : NULL;
+}
+
+int witsensor_replay_sources(const witsensor_replay_t *rp) {
+    return rp ? rp->sources : 0;
+}
+
+double witsensor_replay_duration_ms(const witsensor_replay_t *rp) {
+    if (!rp || !rp->count) return 0;
+    return (double)(rp->index[rp->count - 1].t_ns - rp->index[0].t_ns) / 1e6;
+}
+
+// Wait until due (host ns); 0 if asked to stop meanwhile
+static int witsensor_replay_wait(witsensor_replay_t *rp, uint64_t due) {
+    for (;;) {
+        if (atomic_load(&rp->stop)) return 0;
+        uint64_t now = witsensor_now_ns();
+        if (now >= due) return 1;
+        uint64_t left = due - now;
+        if (left > SPIN_NS) {
+            uint64_t ms = (left - SPIN_NS) / 1000000ull;
+            witsensor_sleep_ms((unsigned int)(ms < STOP_CHECK_MS ? ms : STOP_CHECK_MS));
+        }
+    }
+}
+
+// Feed records in order; returns 0 if stopped before the last one
+static int witsensor_replay_feed(witsensor_replay_t *rp) {
+    uint64_t first = rp->index[0].t_ns;
+    uint64_t start = atomic_load(&rp->start_ns);
+    for (size_t i = 0; i < rp->count; i++) {
+        const witsensor_replay_entry_t *e = &rp->index[i];
+        witsensor_record_t r;
+        memcpy(&r, rp->data + e->offset, sizeof(r));
+        if (rp->speed > 0) {
+            if (!witsensor_replay_wait(rp, start + (uint64_t)((double)(e->t_ns - first) / rp->speed))) return 0;
+        } else {
+            for (;;) {
+                if (atomic_load(&rp->stop)) return 0;
+                if (!rp->ready_callback || rp->ready_callback(rp->user_data, r.source, r.length)) break;
+                witsensor_sleep_ms(READY_WAIT_MS);
+            }
+        }
+        rp->data_callback(rp->user_data, r.source, rp->data + e->offset + sizeof(r), r.length);
+        atomic_store(&rp->position_ns, e->t_ns - first);
+        atomic_fetch_add(&rp->bytes, r.length);
+        atomic_fetch_add(&rp->records, 1);
+    }
+    return 1;
+}
+
+static void witsensor_replay_main(void *arg) {
+    witsensor_replay_t *rp = (witsensor_replay_t *)arg;
+    int finished = witsensor_replay_feed(rp);
+    atomic_store(&rp->end_ns, witsensor_now_ns());
+    if (!finished) return;
+    atomic_store(&rp->finished, 1);
+    if (rp->done_callback) rp->done_callback(rp->user_data);
+}
+
+int witsensor_replay_start(witsensor_replay_t *rp, double speed, witsensor_replay_data_t data,
+                           witsensor_replay_done_t done, void *user_data) {
+    if (!rp || !data || rp->running) return 0;
+    rp->speed = speed > 0 ? speed : 0;
+    rp->data_callback = data;
+    rp->done_callback = done;
+    rp->user_data = user_data;
+    atomic_store(&rp->start_ns, witsensor_now_ns());
+    rp->running = witsensor_thread_start(&rp->thread, witsensor_replay_main, rp);
+    return rp->running;
+}
+
+void witsensor_replay_set_ready(witsensor_replay_t *rp, witsensor_replay_ready_t ready) {
+    if (rp && !rp->running) rp->ready_callback = ready;
+}
+
+void witsensor_replay_stats(witsensor_replay_t *rp, witsensor_replay_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!rp) return;
+    stats->records = atomic_load(&rp->records);
+    stats->bytes = atomic_load(&rp->bytes);
+    stats->position_ms = (double)atomic_load(&rp->position_ns) / 1e6;
+    stats->finished = atomic_load(&rp->finished);
+    if (rp->running) {
+        uint64_t end = atomic_load(&rp->end_ns);
+        stats->elapsed_ns = (end ? end : witsensor_now_ns()) - atomic_load(&rp->start_ns);
+    }
+}
+
+void witsensor_replay_close(witsensor_replay_t *rp, witsensor_replay_stats_t *stats) {
+    if (!rp) {
+        witsensor_replay_stats(NULL, stats);
+        return;
+    }
+    atomic_store(&rp->stop, 1);
+    if (rp->running) witsensor_thread_join(rp->thread);
+    witsensor_replay_stats(rp, stats);
+    witsensor_replay_free(rp);
+}
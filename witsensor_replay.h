@@ -0,0 +1,60 @@
+/* witsensor_replay.h
+ * Session replay: feed a recorded log (witsensor_recorder.h) back as notifications
+ * Records are loaded and put in receive-time order, then a replay thread hands
+ * them to a callback with the original spacing, scaled, or back to back
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_REPLAY_H
+#define WITSENSOR_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "witsensor_recorder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct witsensor_replay_t witsensor_replay_t;
+
+// Replay thread: one recorded notification of a source
+typedef void (*witsensor_replay_data_t)(void *user_data, int source, const unsigned char *data, int length);
+// Replay thread: the last record was fed (not called after witsensor_replay_close)
+typedef void (*witsensor_replay_done_t)(void *user_data);
+// Replay thread, speed 0 only: 1 if the consumer can take a notification of
+// length bytes for source now, 0 to wait and ask again
+typedef int (*witsensor_replay_ready_t)(void *user_data, int source, int length);
+
+typedef struct witsensor_replay_stats_t {
+    uint64_t records;         // notifications fed
+    uint64_t bytes;           // their data bytes
+    uint64_t elapsed_ns;      // since the start
+    double position_ms;       // session time of the last record fed
+    int finished;             // every record was fed
+} witsensor_replay_stats_t;
+
+// Read the file and order its records; NULL with a reason in err on failure
+witsensor_replay_t *witsensor_replay_open(const char *path, char *err, size_t errsize);
+const witsensor_record_header_t *witsensor_replay_header(const witsensor_replay_t *rp);
+// Highest source with records plus one, and first to last record in ms
+int witsensor_replay_sources(const witsensor_replay_t *rp);
+double witsensor_replay_duration_ms(const witsensor_replay_t *rp);
+// Start feeding: speed 1 keeps the recorded timing, 2 plays twice as fast,
+// 0 as fast as possible. Returns 0 if the thread could not be started.
+int witsensor_replay_start(witsensor_replay_t *rp, double speed, witsensor_replay_data_t data,
+                           witsensor_replay_done_t done, void *user_data);
+// Back-pressure for speed 0, set before witsensor_replay_start; without it
+// records are fed without waiting
+void witsensor_replay_set_ready(witsensor_replay_t *rp, witsensor_replay_ready_t ready);
+void witsensor_replay_stats(witsensor_replay_t *rp, witsensor_replay_stats_t *stats);
+// Stop and join the replay thread, then free rp
+void witsensor_replay_close(witsensor_replay_t *rp, witsensor_replay_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_REPLAY_H
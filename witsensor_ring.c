@@ -0,0 +1,119 @@
+/* witsensor_ring.c
+ * Fixed-capacity single-producer/single-consumer ring for decoded frames
+ *
+ * The producer never blocks and never allocates. When the ring is full it
+ * either discards the incoming frame (drop-newest) or steals the oldest slot
+ * by advancing the tail itself (drop-oldest). The consumer claims a slot by
+ * CAS on the tail, so a slot stolen mid-copy is detected and re-read.
+ * Register responses use a plain drop-newest ring of the same kind.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_ring.h"
+#include <string.h>
+
+void witsensor_ring_init(witsensor_ring_t *ring, witsensor_overflow_t policy) {
+    if (!ring) return;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->overflow, (int)policy);
+    atomic_init(&ring->pushed, 0);
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->high_water, 0);
+    memset(ring->slots, 0, sizeof(ring->slots));
+}
+
+void witsensor_ring_set_overflow(witsensor_ring_t *ring, witsensor_overflow_t policy) {
+    if (!ring) return;
+    atomic_store_explicit(&ring->overflow, (int)policy, memory_order_relaxed);
+}
+
+int witsensor_ring_push(witsensor_ring_t *ring, const witsensor_frame_t *frame) {
+    if (!ring || !frame) return 0;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    while (head - tail >= WITSENSOR_RING_CAPACITY) {
+        if (atomic_load_explicit(&ring->overflow, memory_order_relaxed) == WITSENSOR_DROP_NEWEST) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return 0;
+        }
+        // Drop-oldest: take the tail slot away from the consumer. On failure
+        // the consumer moved the tail first and 'tail' holds the new value.
+        if (atomic_compare_exchange_weak_explicit(&ring->tail, &tail, tail + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            tail++;
+        }
+    }
+    ring->slots[head & WITSENSOR_RING_MASK] = *frame;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    atomic_fetch_add_explicit(&ring->pushed, 1, memory_order_relaxed);
+
+    uint32_t depth = head + 1 - tail;
+    if (depth > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, depth, memory_order_relaxed);
+    }
+    return 1;
+}
+
+int witsensor_ring_pop(witsensor_ring_t *ring, witsensor_frame_t *frame) {
+    if (!ring || !frame) return 0;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    for (;;) {
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail == head) return 0;
+        *frame = ring->slots[tail & WITSENSOR_RING_MASK];
+        // Only keep the copy if the producer did not steal the slot meanwhile
+        if (atomic_compare_exchange_weak_explicit(&ring->tail, &tail, tail + 1,
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            return 1;
+        }
+    }
+}
+
+unsigned int witsensor_ring_depth(witsensor_ring_t *ring) {
+    if (!ring) return 0;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return (unsigned int)(head - tail);
+}
+
+void witsensor_ring_reset_counters(witsensor_ring_t *ring) {
+    if (!ring) return;
+    atomic_store_explicit(&ring->pushed, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->high_water, witsensor_ring_depth(ring), memory_order_relaxed);
+}
+
+void witsensor_register_ring_init(witsensor_register_ring_t *ring) {
+    if (!ring) return;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->dropped, 0);
+    memset(ring->slots, 0, sizeof(ring->slots));
+}
+
+int witsensor_register_ring_push(witsensor_register_ring_t *ring, const witsensor_register_t *reg) {
+    if (!ring || !reg) return 0;
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= WITSENSOR_REGISTER_RING_CAPACITY) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return 0;
+    }
+    ring->slots[head & WITSENSOR_REGISTER_RING_MASK] = *reg;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return 1;
+}
+
+int witsensor_register_ring_pop(witsensor_register_ring_t *ring, witsensor_register_t *reg) {
+    if (!ring || !reg) return 0;
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail == head) return 0;
+    *reg = ring->slots[tail & WITSENSOR_REGISTER_RING_MASK];
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 1;
+}
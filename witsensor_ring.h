@@ -0,0 +1,87 @@
+/* witsensor_ring.h
+ * Fixed-capacity single-producer/single-consumer ring for decoded frames
+ * Producer: BLE callback thread, consumer: Pd scheduler thread
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_RING_H
+#define WITSENSOR_RING_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "witsensor_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number of frame slots (must be a power of two)
+#define WITSENSOR_RING_CAPACITY 256
+#define WITSENSOR_RING_MASK (WITSENSOR_RING_CAPACITY - 1)
+
+// Frame flags: which variant the sensor streamed (derived from output_mode)
+#define WITSENSOR_FRAME_DISP_SPEED 0x01  // v[0..5] are displacement/speed
+#define WITSENSOR_FRAME_TIMESTAMP  0x02  // v[6..7] unused, timestamp is valid
+#define WITSENSOR_FRAME_QUAT       0x04  // quat holds the host fusion (ahrs) result
+
+// Overflow policy when the Pd thread falls behind
+typedef enum {
+    WITSENSOR_DROP_OLDEST = 0,  // overwrite the oldest queued frame
+    WITSENSOR_DROP_NEWEST = 1   // discard the incoming frame
+} witsensor_overflow_t;
+
+// One decoded 0x61 streaming frame
+typedef struct witsensor_frame_t {
+    float v[9];          // accel|disp xyz, gyro|speed xyz, angle xyz
+    float quat[4];       // orientation w x y z after this frame (WITSENSOR_FRAME_QUAT only)
+    uint32_t timestamp;  // device time in ms (WITSENSOR_FRAME_TIMESTAMP only)
+    uint32_t seq;        // running frame counter assigned by the producer
+    unsigned char flags; // WITSENSOR_FRAME_* bits
+    uint64_t rx_ns;      // host receive time of the notification (witsensor_now_ns)
+    uint64_t decode_ns;  // when decoding finished, just before queueing
+} witsensor_frame_t;
+
+typedef struct witsensor_ring_t {
+    _Atomic uint32_t head;       // next slot to write (producer)
+    _Atomic uint32_t tail;       // next slot to read (consumer; producer advances it on drop-oldest)
+    _Atomic int overflow;        // witsensor_overflow_t
+    // Counters (written by the producer only)
+    _Atomic uint64_t pushed;     // frames accepted
+    _Atomic uint64_t dropped;    // frames lost to overflow (either policy)
+    _Atomic uint32_t high_water; // deepest fill level seen
+    witsensor_frame_t slots[WITSENSOR_RING_CAPACITY];
+} witsensor_ring_t;
+
+void witsensor_ring_init(witsensor_ring_t *ring, witsensor_overflow_t policy);
+void witsensor_ring_set_overflow(witsensor_ring_t *ring, witsensor_overflow_t policy);
+// Producer side: returns 1 if the frame was queued, 0 if it was dropped
+int witsensor_ring_push(witsensor_ring_t *ring, const witsensor_frame_t *frame);
+// Consumer side: returns 1 and fills *frame, or 0 when empty
+int witsensor_ring_pop(witsensor_ring_t *ring, witsensor_frame_t *frame);
+unsigned int witsensor_ring_depth(witsensor_ring_t *ring);
+// Consumer side: reset counters (not the queued frames)
+void witsensor_ring_reset_counters(witsensor_ring_t *ring);
+
+// Decoded register responses take the same path; they are rare, so the ring
+// is small and simply drops new responses when full
+#define WITSENSOR_REGISTER_RING_CAPACITY 32
+#define WITSENSOR_REGISTER_RING_MASK (WITSENSOR_REGISTER_RING_CAPACITY - 1)
+
+typedef struct witsensor_register_ring_t {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic uint64_t dropped;
+    witsensor_register_t slots[WITSENSOR_REGISTER_RING_CAPACITY];
+} witsensor_register_ring_t;
+
+void witsensor_register_ring_init(witsensor_register_ring_t *ring);
+int witsensor_register_ring_push(witsensor_register_ring_t *ring, const witsensor_register_t *reg);
+int witsensor_register_ring_pop(witsensor_register_ring_t *ring, witsensor_register_t *reg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_RING_H
@@ -0,0 +1,222 @@
+/* witsensor_scancache.c
+ * Bounded cache of advertising devices seen by a scan
+ *
+ * Entries live in a fixed pool and never move; two linear-probing index
+ * tables map address and identifier hashes to entry numbers. Removal shifts
+ * the following index slots back instead of leaving tombstones, so lookups
+ * stay short however often devices come and go. Not thread-safe: callers
+ * hold their own lock.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_scancache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define BUCKET_MASK (WITSENSOR_SCAN_BUCKETS - 1)
+#define SWEEP_INTERVAL_NS 1000000000ull
+
+_Static_assert((WITSENSOR_SCAN_BUCKETS & BUCKET_MASK) == 0, "bucket count must be a power of two");
+_Static_assert(WITSENSOR_SCAN_ENTRIES * 4 <= WITSENSOR_SCAN_BUCKETS * 3, "index load must stay <= 3/4");
+_Static_assert(WITSENSOR_SCAN_ENTRIES < 65535, "entry numbers are stored as uint16_t + 1");
+
+// FNV-1a
+static uint32_t witsensor_scan_hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void witsensor_scan_cache_init(witsensor_scan_cache_t *c, uint64_t max_age_ns, void (*release)(void *handle)) {
+    if (!c) return;
+    memset(c, 0, sizeof(*c));
+    c->max_age_ns = max_age_ns;
+    c->release = release;
+}
+
+static void witsensor_scan_drop_handle(witsensor_scan_cache_t *c, void *handle) {
+    if (handle && c->release) c->release(handle);
+}
+
+void witsensor_scan_cache_free(witsensor_scan_cache_t *c) {
+    if (!c) return;
+    witsensor_scan_cache_clear(c);
+    free(c->entries); // one block holds the indexes and the free stack too
+    c->entries = NULL;
+    c->by_addr = NULL;
+    c->by_id = NULL;
+    c->free_slots = NULL;
+    c->count = 0;
+}
+
+void witsensor_scan_cache_clear(witsensor_scan_cache_t *c) {
+    if (!c || !c->entries) return;
+    for (unsigned int i = 0; i < WITSENSOR_SCAN_ENTRIES; i++) {
+        if (c->entries[i].used) witsensor_scan_drop_handle(c, c->entries[i].handle);
+        c->entries[i].used = 0;
+        c->entries[i].handle = NULL;
+        // Pop order hands out low entry numbers first
+        c->free_slots[i] = (uint16_t)(WITSENSOR_SCAN_ENTRIES - 1 - i);
+    }
+    memset(c->by_addr, 0, sizeof(uint16_t) * WITSENSOR_SCAN_BUCKETS);
+    memset(c->by_id, 0, sizeof(uint16_t) * WITSENSOR_SCAN_BUCKETS);
+    c->count = 0;
+}
+
+static int witsensor_scan_alloc(witsensor_scan_cache_t *c) {
+    if (c->entries) return 1;
+    size_t entries = sizeof(witsensor_scan_entry_t) * WITSENSOR_SCAN_ENTRIES;
+    size_t buckets = sizeof(uint16_t) * WITSENSOR_SCAN_BUCKETS;
+    unsigned char *block = (unsigned char *)calloc(1, entries + 2 * buckets + sizeof(uint16_t) * WITSENSOR_SCAN_ENTRIES);
+    if (!block) return 0;
+    c->entries = (witsensor_scan_entry_t *)block;
+    c->by_addr = (uint16_t *)(block + entries);
+    c->by_id = (uint16_t *)(block + entries + buckets);
+    c->free_slots = (uint16_t *)(block + entries + 2 * buckets);
+    witsensor_scan_cache_clear(c);
+    return 1;
+}
+
+static uint32_t witsensor_scan_home(const witsensor_scan_cache_t *c, const uint16_t *index, uint16_t slot) {
+    const witsensor_scan_entry_t *e = &c->entries[slot - 1];
+    return (index == c->by_addr ? e->addr_hash : e->id_hash) & BUCKET_MASK;
+}
+
+static void witsensor_scan_index_add(uint16_t *index, uint32_t hash, unsigned int n) {
+    uint32_t i = hash & BUCKET_MASK;
+    while (index[i]) i = (i + 1) & BUCKET_MASK;
+    index[i] = (uint16_t)(n + 1);
+}
+
+// Remove entry n from an index, shifting later members of the probe run back
+static void witsensor_scan_index_remove(witsensor_scan_cache_t *c, uint16_t *index, uint32_t hash, unsigned int n) {
+    uint32_t i = hash & BUCKET_MASK;
+    while (index[i] && index[i] != n + 1) i = (i + 1) & BUCKET_MASK;
+    if (!index[i]) return;
+    uint32_t j = i;
+    for (;;) {
+        j = (j + 1) & BUCKET_MASK;
+        if (!index[j]) break;
+        uint32_t k = witsensor_scan_home(c, index, index[j]);
+        // Move j into the hole at i unless its home lies cyclically in (i, j]
+        int stays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+        if (!stays) {
+            index[i] = index[j];
+            i = j;
+        }
+    }
+    index[i] = 0;
+}
+
+static void witsensor_scan_remove_entry(witsensor_scan_cache_t *c, unsigned int n) {
+    witsensor_scan_entry_t *e = &c->entries[n];
+    witsensor_scan_index_remove(c, c->by_addr, e->addr_hash, n);
+    if (e->id[0]) witsensor_scan_index_remove(c, c->by_id, e->id_hash, n);
+    witsensor_scan_drop_handle(c, e->handle);
+    e->handle = NULL;
+    e->used = 0;
+    c->free_slots[WITSENSOR_SCAN_ENTRIES - c->count] = (uint16_t)n;
+    c->count--;
+}
+
+static witsensor_scan_entry_t *witsensor_scan_find_addr(witsensor_scan_cache_t *c, const char *addr, uint32_t hash) {
+    for (uint32_t i = hash & BUCKET_MASK; c->by_addr[i]; i = (i + 1) & BUCKET_MASK) {
+        witsensor_scan_entry_t *e = &c->entries[c->by_addr[i] - 1];
+        if (e->addr_hash == hash && strcmp(e->addr, addr) == 0) return e;
+    }
+    return NULL;
+}
+
+static void witsensor_scan_set_id(witsensor_scan_cache_t *c, witsensor_scan_entry_t *e, const char *id) {
+    unsigned int n = (unsigned int)(e - c->entries);
+    if (e->id[0]) witsensor_scan_index_remove(c, c->by_id, e->id_hash, n);
+    snprintf(e->id, sizeof(e->id), "%s", id);
+    e->id_hash = witsensor_scan_hash(e->id);
+    e->is_wit = strstr(e->id, "WT") != NULL;
+    if (e->id[0]) witsensor_scan_index_add(c->by_id, e->id_hash, n);
+}
+
+unsigned int witsensor_scan_cache_expire(witsensor_scan_cache_t *c, uint64_t now_ns) {
+    if (!c || !c->entries || !c->max_age_ns) return 0;
+    unsigned int removed = 0;
+    for (unsigned int n = 0; n < WITSENSOR_SCAN_ENTRIES && c->count; n++) {
+        witsensor_scan_entry_t *e = &c->entries[n];
+        if (e->used && now_ns > e->last_seen_ns && now_ns - e->last_seen_ns > c->max_age_ns) {
+            witsensor_scan_remove_entry(c, n);
+            removed++;
+        }
+    }
+    c->evicted += removed;
+    return removed;
+}
+
+int witsensor_scan_cache_update(witsensor_scan_cache_t *c, const char *addr, const char *id,
+                                int rssi, uint64_t now_ns, void *handle) {
+    if (!c) return -1;
+    if (!addr || !addr[0] || !witsensor_scan_alloc(c)) {
+        witsensor_scan_drop_handle(c, handle);
+        return -1;
+    }
+    if (now_ns - c->last_sweep_ns >= SWEEP_INTERVAL_NS) {
+        c->last_sweep_ns = now_ns;
+        witsensor_scan_cache_expire(c, now_ns);
+    }
+    if (!id) id = "";
+    uint32_t hash = witsensor_scan_hash(addr);
+    witsensor_scan_entry_t *e = witsensor_scan_find_addr(c, addr, hash);
+    if (e) {
+        // Names often arrive with a later advertisement (scan response)
+        if (id[0] && strcmp(e->id, id) != 0) witsensor_scan_set_id(c, e, id);
+        e->rssi = (int16_t)rssi;
+        e->last_seen_ns = now_ns;
+        if (!e->handle) e->handle = handle;
+        else witsensor_scan_drop_handle(c, handle);
+        return 0;
+    }
+    if (c->count == WITSENSOR_SCAN_ENTRIES && !witsensor_scan_cache_expire(c, now_ns)) {
+        // Full of live devices: the one heard from least recently goes
+        unsigned int oldest = 0;
+        for (unsigned int n = 1; n < WITSENSOR_SCAN_ENTRIES; n++) {
+            if (c->entries[n].last_seen_ns < c->entries[oldest].last_seen_ns) oldest = n;
+        }
+        witsensor_scan_remove_entry(c, oldest);
+        c->evicted++;
+    }
+    unsigned int n = c->free_slots[WITSENSOR_SCAN_ENTRIES - 1 - c->count];
+    c->count++;
+    e = &c->entries[n];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->addr, sizeof(e->addr), "%s", addr);
+    e->addr_hash = witsensor_scan_hash(e->addr);
+    e->used = 1;
+    e->rssi = (int16_t)rssi;
+    e->last_seen_ns = now_ns;
+    e->handle = handle;
+    witsensor_scan_index_add(c->by_addr, e->addr_hash, n);
+    witsensor_scan_set_id(c, e, id);
+    return 1;
+}
+
+witsensor_scan_entry_t *witsensor_scan_cache_find(witsensor_scan_cache_t *c, const char *target) {
+    if (!c || !c->entries || !target || !target[0]) return NULL;
+    witsensor_scan_entry_t *e = witsensor_scan_find_addr(c, target, witsensor_scan_hash(target));
+    if (e) return e;
+    uint32_t hash = witsensor_scan_hash(target);
+    for (uint32_t i = hash & BUCKET_MASK; c->by_id[i]; i = (i + 1) & BUCKET_MASK) {
+        e = &c->entries[c->by_id[i] - 1];
+        if (e->id_hash == hash && strcmp(e->id, target) == 0) return e;
+    }
+    return NULL;
+}
+
+void witsensor_scan_cache_remove(witsensor_scan_cache_t *c, const char *addr) {
+    if (!c || !c->entries || !addr) return;
+    witsensor_scan_entry_t *e = witsensor_scan_find_addr(c, addr, witsensor_scan_hash(addr));
+    if (e) witsensor_scan_remove_entry(c, (unsigned int)(e - c->entries));
+}
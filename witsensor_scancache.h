@@ -0,0 +1,74 @@
+/* witsensor_scancache.h
+ * Bounded cache of advertising devices seen by a scan
+ * Keyed by address, with a second index by identifier; entries age out
+ * Each entry may own a backend handle, released through a callback
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_SCANCACHE_H
+#define WITSENSOR_SCANCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WITSENSOR_SCAN_ENTRIES 384             // devices kept at most
+#define WITSENSOR_SCAN_BUCKETS 512             // index slots per key (power of two, load <= 3/4)
+#define WITSENSOR_SCAN_MAX_AGE_NS (30ull * 1000000000ull) // unseen for this long: stale
+
+typedef struct witsensor_scan_entry_t {
+    char addr[64];          // key
+    char id[128];           // advertised name, may be empty or shared by several devices
+    uint32_t addr_hash;
+    uint32_t id_hash;
+    int16_t rssi;           // dBm of the newest advertisement
+    unsigned char is_wit;   // identifier looks like a WIT sensor
+    unsigned char used;
+    uint64_t last_seen_ns;  // witsensor_now_ns of the newest advertisement
+    void *handle;           // owned backend handle for connecting, may be NULL
+} witsensor_scan_entry_t;
+
+typedef struct witsensor_scan_cache_t {
+    // Allocated on first insert, so caches of objects that never scan stay empty
+    witsensor_scan_entry_t *entries;           // [WITSENSOR_SCAN_ENTRIES], never moved
+    uint16_t *by_addr;                         // [WITSENSOR_SCAN_BUCKETS] entry + 1, 0: empty
+    uint16_t *by_id;
+    uint16_t *free_slots;                      // stack of unused entry numbers
+    unsigned int count;
+    uint64_t max_age_ns;
+    uint64_t last_sweep_ns;
+    uint64_t evicted;                          // entries dropped for age or space
+    void (*release)(void *handle);             // called when an entry lets go of its handle
+} witsensor_scan_cache_t;
+
+void witsensor_scan_cache_init(witsensor_scan_cache_t *c, uint64_t max_age_ns, void (*release)(void *handle));
+void witsensor_scan_cache_free(witsensor_scan_cache_t *c);
+// Drop all entries, keep the allocation
+void witsensor_scan_cache_clear(witsensor_scan_cache_t *c);
+// Insert or refresh a device. Returns 1 for a new entry, 0 for a refresh and
+// -1 if the cache could not be allocated. Stale entries are swept at most once
+// per second; when full, the least recently seen entry makes room.
+// Ownership of handle (may be NULL) passes to the cache: it is kept if the
+// entry has none yet and released otherwise.
+int witsensor_scan_cache_update(witsensor_scan_cache_t *c, const char *addr, const char *id,
+                                int rssi, uint64_t now_ns, void *handle);
+// Lookup by address, then by identifier; NULL if unknown
+witsensor_scan_entry_t *witsensor_scan_cache_find(witsensor_scan_cache_t *c, const char *target);
+void witsensor_scan_cache_remove(witsensor_scan_cache_t *c, const char *addr);
+// Drop entries not seen since now_ns - max_age_ns; returns the number removed
+unsigned int witsensor_scan_cache_expire(witsensor_scan_cache_t *c, uint64_t now_ns);
+// Iterate: entry i or NULL for an unused slot (0 <= i < WITSENSOR_SCAN_ENTRIES)
+static inline witsensor_scan_entry_t *witsensor_scan_cache_at(witsensor_scan_cache_t *c, unsigned int i) {
+    return (c->entries && c->entries[i].used) ? &c->entries[i] : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_SCANCACHE_H
@@ -0,0 +1,64 @@
+/* witsensor_snapshot.c
+ * Latest sensor state published by the BLE thread, read by the Pd thread
+ *
+ * The writer makes the sequence odd, updates the words and makes it even
+ * again. A reader copies the words and keeps the copy only if it saw the
+ * same even sequence before and after, so it never returns a state that
+ * mixes two frames. The frame and the quaternion are updated independently
+ * in a writer-only shadow copy which is published whole.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#include "witsensor_snapshot.h"
+#include <string.h>
+
+void witsensor_snapshot_init(witsensor_snapshot_t *snap) {
+    if (!snap) return;
+    atomic_init(&snap->seq, 0);
+    for (size_t i = 0; i < WITSENSOR_SNAPSHOT_WORDS; i++) atomic_init(&snap->words[i], 0);
+    memset(&snap->shadow, 0, sizeof(snap->shadow));
+}
+
+// Publish the writer's shadow copy
+static void witsensor_snapshot_publish(witsensor_snapshot_t *snap) {
+    uint32_t buf[WITSENSOR_SNAPSHOT_WORDS] = {0};
+    memcpy(buf, &snap->shadow, sizeof(snap->shadow));
+
+    uint32_t seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (size_t i = 0; i < WITSENSOR_SNAPSHOT_WORDS; i++) {
+        atomic_store_explicit(&snap->words[i], buf[i], memory_order_relaxed);
+    }
+    atomic_store_explicit(&snap->seq, seq + 2, memory_order_release);
+}
+
+void witsensor_snapshot_store_frame(witsensor_snapshot_t *snap, const witsensor_frame_t *frame) {
+    if (!snap || !frame) return;
+    snap->shadow.frame = *frame;
+    witsensor_snapshot_publish(snap);
+}
+
+void witsensor_snapshot_store_quat(witsensor_snapshot_t *snap, const float *quat, uint64_t rx_ns) {
+    if (!snap || !quat) return;
+    memcpy(snap->shadow.quat, quat, sizeof(snap->shadow.quat));
+    snap->shadow.quat_rx_ns = rx_ns;
+    witsensor_snapshot_publish(snap);
+}
+
+void witsensor_snapshot_read(witsensor_snapshot_t *snap, witsensor_state_t *state) {
+    if (!snap || !state) return;
+    uint32_t buf[WITSENSOR_SNAPSHOT_WORDS];
+    for (;;) {
+        uint32_t before = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        if (before & 1) continue; // writer active
+        for (size_t i = 0; i < WITSENSOR_SNAPSHOT_WORDS; i++) {
+            buf[i] = atomic_load_explicit(&snap->words[i], memory_order_relaxed);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&snap->seq, memory_order_relaxed) == before) break;
+    }
+    memcpy(state, buf, sizeof(*state));
+}
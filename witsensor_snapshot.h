@@ -0,0 +1,47 @@
+/* witsensor_snapshot.h
+ * Latest sensor state published by the BLE thread, read by the Pd thread
+ * Seqlock: one writer, any number of readers, no locks on either side
+ *
+ * This is free and unencumbered software released into the public domain.
+ * For more information, please refer to <https://unlicense.org>
+ */
+
+#ifndef WITSENSOR_SNAPSHOT_H
+#define WITSENSOR_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "witsensor_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct witsensor_state_t {
+    witsensor_frame_t frame; // newest streaming frame (values, host receive time, seq)
+    float quat[4];           // newest quaternion register read (w x y z)
+    uint64_t quat_rx_ns;     // host receive time of the quaternion, 0 if none yet
+} witsensor_state_t;
+
+#define WITSENSOR_SNAPSHOT_WORDS ((sizeof(witsensor_state_t) + 3) / 4)
+
+typedef struct witsensor_snapshot_t {
+    _Atomic uint32_t seq;    // odd while the writer is updating
+    // State stored as relaxed atomic words so a racing read is merely
+    // retried, never undefined
+    _Atomic uint32_t words[WITSENSOR_SNAPSHOT_WORDS];
+    witsensor_state_t shadow; // writer-only copy the words are published from
+} witsensor_snapshot_t;
+
+void witsensor_snapshot_init(witsensor_snapshot_t *snap);
+// Writer side (BLE thread)
+void witsensor_snapshot_store_frame(witsensor_snapshot_t *snap, const witsensor_frame_t *frame);
+void witsensor_snapshot_store_quat(witsensor_snapshot_t *snap, const float *quat, uint64_t rx_ns);
+// Reader side: copies one consistent state
+void witsensor_snapshot_read(witsensor_snapshot_t *snap, witsensor_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WITSENSOR_SNAPSHOT_H